@@ -8,9 +8,11 @@
 #include <algorithm>
 #include <limits>
 
+#include "cell_library.h"
+
 using namespace std;
 
-enum class NodeType { AND, OR, NOT, INPUT, OUTPUT };
+using NodeType = GateType;
 
 struct Node {
     string name;
@@ -27,10 +29,7 @@ unordered_map<string, Node> nodes;
 unordered_map<string, int> memo;
 string output_name;
 
-// NAND-NOT only cost library
-const int NOT_COST = 2;
-const int NAND2_COST = 3;
-
+// NAND-NOT only: NOT_COST and NAND2_COST come from the shared table
 int compute_nand_not_cost(const string& name) {
     if (memo.count(name)) return memo[name];
     if (nodes.find(name) == nodes.end()) {
@@ -102,9 +101,11 @@ void parse_netlist(const string& filepath) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     string input_file = "input8.txt";
     string output_file = "output.txt";
+    if (argc > 1) input_file = argv[1];
+    if (argc > 2) output_file = argv[2];
 
     parse_netlist(input_file);
     int min_cost = compute_nand_not_cost(output_name);
@@ -7,20 +7,12 @@
 #include <sstream>
 #include <limits>
 
+#include "cell_library.h"
+
 using namespace std;
 
-// Node types in the circuit
-enum class NodeType {
-    AND,
-    OR,
-    NOT,
-    INPUT,
-    OUTPUT,
-    NAND2,
-    NOR2,
-    AOI21,
-    AOI22
-};
+// Gate types come from the shared technology table
+using NodeType = GateType;
 
 // Structure to represent a node
 struct Node {
@@ -32,15 +24,6 @@ struct Node {
     Node() : type(NodeType::INPUT), cost(-1), visited(false) {}
 };
 
-// Gate costs
-static const int NOT_COST   = 2;
-static const int NAND2_COST = 3;
-static const int AND2_COST  = 4;
-static const int NOR2_COST  = 6;
-static const int OR2_COST   = 4;
-static const int AOI21_COST = 7;
-static const int AOI22_COST = 7;
-
 // Utility to trim whitespace
 static string trim(const string &s) {
     size_t f = s.find_first_not_of(" \t\r\n");
@@ -281,12 +264,14 @@ private:
 
 };
 
-int main(){
+int main(int argc, char* argv[]){
+    string inputFile = argc > 1 ? argv[1] : "input2.txt";
+    string outputFile = argc > 2 ? argv[2] : "output.txt";
     TechnologyMapper tm;
-    if(!tm.readNetlist("input2.txt")) return 1;
+    if(!tm.readNetlist(inputFile)) return 1;
     int c = tm.calculateMinimalCost();
     if(c<0) return 1;
-    ofstream out("output.txt"); out<<c;
+    ofstream out(outputFile); out<<c;
     cout<<"Minimal cost: "<<c<<endl;
     return 0;
 }
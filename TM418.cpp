@@ -6,9 +6,12 @@
 #include <string>
 #include <algorithm>
 
+#include "cell_library.h"
+#include "netlist.h"
+
 using namespace std;
 
-enum class NodeType { INPUT, AND, OR, NOT };
+using NodeType = GateType;
 
 struct Node {
     string name;
@@ -19,7 +22,6 @@ struct Node {
 };
 
 unordered_map<string, Node> nodes;
-unordered_map<string, int> cost_map = { {"NOT", 2}, {"NAND2", 3} };
 
 int compute_cost(const string& name) {
     if (nodes[name].visited) return nodes[name].cost;
@@ -29,26 +31,24 @@ int compute_cost(const string& name) {
     if (node.type == NodeType::INPUT) return node.cost = 0;
 
     if (node.type == NodeType::NOT) {
-        return node.cost = compute_cost(node.inputs[0]) + cost_map["NOT"];
+        return node.cost = compute_cost(node.inputs[0]) + NOT_COST;
     }
     if (node.type == NodeType::AND) {
         int a = compute_cost(node.inputs[0]);
         int b = compute_cost(node.inputs[1]);
-        return node.cost = a + b + cost_map["NAND2"] + cost_map["NOT"];
+        return node.cost = a + b + NAND2_COST + NOT_COST;
     }
     if (node.type == NodeType::OR) {
-        int a = compute_cost(node.inputs[0]) + cost_map["NOT"];
-        int b = compute_cost(node.inputs[1]) + cost_map["NOT"];
-        return node.cost = a + b + cost_map["NAND2"] + cost_map["NOT"];
+        int a = compute_cost(node.inputs[0]) + NOT_COST;
+        int b = compute_cost(node.inputs[1]) + NOT_COST;
+        return node.cost = a + b + NAND2_COST + NOT_COST;
     }
     return 0;
 }
 
 NodeType parse_type(const string& s) {
-    if (s == "AND") return NodeType::AND;
-    if (s == "OR") return NodeType::OR;
-    if (s == "NOT") return NodeType::NOT;
-    return NodeType::INPUT;
+    NodeType t = parseGateType(s);
+    return t == NodeType::UNKNOWN ? NodeType::INPUT : t;
 }
 
 void parse_netlist(const string& filename, string& output_node) {
@@ -91,13 +91,17 @@ void parse_netlist(const string& filename, string& output_node) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    string input_file = argc > 1 ? argv[1] : "input.txt";
+    string output_file = argc > 2 ? argv[2] : "output.txt";
+    // compute_cost() would read a loop's unfinished cost of -1
+    if (reportFileLoops(input_file) > 0) return 1;
     string output_node;
-    parse_netlist("input.txt", output_node);
+    parse_netlist(input_file, output_node);
 
     int result = compute_cost(output_node);
 
-    ofstream out("output.txt");
+    ofstream out(output_file);
     out << result << endl;
     out.close();
 
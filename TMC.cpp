@@ -6,10 +6,24 @@
 #include <string>
 #include <algorithm>
 #include <limits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <set>
+#include <memory>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+
+#include "cell_library.h"
+#include "netlist.h"
+
 using namespace std;
 
-// Node types in the circuit
-enum NodeType { INPUT, OUTPUT, AND, OR, NOT, UNKNOWN };
+// Node types in the circuit come from the shared technology table
+using NodeType = GateType;
 
 // Structure to hold gate info
 struct Node {
@@ -17,29 +31,14 @@ struct Node {
     vector<string> inputs;
     int cost;
     bool visited;
+    int fanout;              // readers inside the output cone
+    bool duplicate;          // shared, but rebuilt by each reader instead
+    vector<string> leaves;   // signals the chosen implementation reads
+    int dups;                // shared signals that implementation absorbs
     
-    Node() : type(UNKNOWN), cost(-1), visited(false) {}
+    Node() : type(NodeType::UNKNOWN), cost(-1), visited(false), fanout(0), duplicate(false), dups(0) {}
 };
 
-// Gate costs in the technology library
-const int NOT_COST = 2;
-const int NAND2_COST = 3;
-const int AND2_COST = 4;
-const int OR2_COST = 4;
-const int NOR2_COST = 6;
-const int AOI21_COST = 7;
-const int AOI22_COST = 7;
-
-// Converts string to node type
-NodeType getNodeType(const string& s) {
-    if (s == "AND") return AND;
-    if (s == "OR") return OR;
-    if (s == "NOT") return NOT;
-    if (s == "INPUT") return INPUT;
-    if (s == "OUTPUT") return OUTPUT;
-    return UNKNOWN;
-}
-
 // Parses the input netlist
 bool readNetlist(const string& filename, unordered_map<string, Node>& circuit, string& outputNode) {
     ifstream file(filename);
@@ -64,7 +63,7 @@ bool readNetlist(const string& filename, unordered_map<string, Node>& circuit, s
 
         if (typeOrEqual == "INPUT") {
             Node& node = circuit[name];
-            node.type = INPUT;
+            node.type = NodeType::INPUT;
             node.cost = 0;
         } else if (typeOrEqual == "OUTPUT") {
             outputNode = name;
@@ -72,7 +71,7 @@ bool readNetlist(const string& filename, unordered_map<string, Node>& circuit, s
             string gateTypeStr;
             ss >> gateTypeStr;
 
-            NodeType gateType = getNodeType(gateTypeStr);
+            NodeType gateType = parseGateType(gateTypeStr);
             vector<string> inputs;
             string inputName;
             while (ss >> inputName) {
@@ -89,226 +88,664 @@ bool readNetlist(const string& filename, unordered_map<string, Node>& circuit, s
     return !outputNode.empty();
 }
 
-// Main evaluation function - calculates minimal cost for each node
-int evaluate(const string& nodeName, unordered_map<string, Node>& circuit) {
-    Node& node = circuit[nodeName];
-    
-    // Return memoized result if available
-    if (node.visited && node.cost >= 0) {
-        return node.cost;
+// Counts the readers of every signal in the output's cone, once after parsing
+void countFanout(const string& outputNode, unordered_map<string, Node>& circuit) {
+    unordered_map<string, bool> seen;
+    vector<string> stack = {outputNode};
+    circuit[outputNode].fanout++;
+    seen[outputNode] = true;
+    while (!stack.empty()) {
+        string name = stack.back();
+        stack.pop_back();
+        for (const string& input : circuit[name].inputs) {
+            circuit[input].fanout++;
+            if (!seen[input]) {
+                seen[input] = true;
+                stack.push_back(input);
+            }
+        }
+    }
+}
+
+int evaluate(const string& nodeName, unordered_map<string, Node>& circuit);
+
+// Costs computed so far by a parallel evaluation. A lock-free open-addressing
+// table keyed by node address: the thread whose compare-exchange puts a node
+// in an empty slot computes it and publishes the cost; every other thread
+// finds the slot busy or done, so no node is computed twice.
+class CostMemo {
+public:
+    static const int BUSY = INT_MIN;
+
+    explicit CostMemo(size_t nodes) {
+        size_t capacity = 16;
+        while (capacity < 2 * nodes) capacity *= 2;
+        slots.reset(new Slot[capacity]);
+        mask = capacity - 1;
+        clear();
+    }
+
+    // Not thread-safe; between evaluations only
+    void clear() {
+        for (size_t i = 0; i <= mask; i++) {
+            slots[i].key.store(nullptr, memory_order_relaxed);
+            slots[i].cost.store(BUSY, memory_order_relaxed);
+        }
+    }
+
+    // The cost slot of node, claiming it (claimed = true, cost BUSY) if no
+    // thread has yet
+    atomic<int>& find(const Node* node, bool& claimed) {
+        size_t i = (reinterpret_cast<uintptr_t>(node) >> 4) * 0x9E3779B97F4A7C15ull & mask;
+        for (;; i = (i + 1) & mask) {
+            const Node* key = slots[i].key.load(memory_order_acquire);
+            if (key == nullptr) {
+                claimed = slots[i].key.compare_exchange_strong(key, node, memory_order_acq_rel);
+                if (claimed) return slots[i].cost;
+            }
+            if (key == node) return slots[i].cost;
+        }
+    }
+
+private:
+    struct Slot {
+        atomic<const Node*> key;
+        atomic<int> cost;
+    };
+    unique_ptr<Slot[]> slots;
+    size_t mask;
+};
+
+// Parallel evaluation (--threads). A node with at least PARALLEL_MIN_FANIN
+// inputs, no deeper than PARALLEL_MAX_DEPTH, queues slices of its inputs
+// for idle workers of the pool before costing itself.
+static const int PARALLEL_MIN_FANIN = 8;
+static const int PARALLEL_MAX_DEPTH = 4;
+static CostMemo* costMemo = nullptr;   // set while evaluating in parallel
+static int parallelThreads = 1;
+static atomic<int> tasksQueued{0};
+static atomic<int> tasksTaken{0};      // run by a worker rather than their owner
+static atomic<int> busyWaits{0};
+static thread_local int evalDepth = 0;
+
+// Inputs [first, last) of a wide node, evaluated by whichever thread takes it
+struct EvalTask {
+    const Node* node;
+    int first, last;
+    int depth;               // evalDepth of the owner
+    atomic<int>* pending;    // the owner's slices not yet done
+};
+
+// The --threads - 1 workers, started once, and the queue they take slices
+// from. An owner waiting for its slices takes back those no worker has
+// started: they are below its own node, so it never waits on itself.
+class EvalPool {
+public:
+    void start(int workers, unordered_map<string, Node>& c) {
+        circuit = &c;
+        for (int i = 0; i < workers; i++) threads.emplace_back([this] { work(); });
+    }
+
+    ~EvalPool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& t : threads) t.join();
+    }
+
+    // Workers waiting for a task and not yet promised one
+    int idle() const { return idleWorkers.load(memory_order_relaxed) - (int)queued.load(memory_order_relaxed); }
+
+    void submit(const EvalTask& t) {
+        {
+            lock_guard<mutex> lock(m);
+            tasks.push_back(t);
+            queued.store(tasks.size(), memory_order_relaxed);
+        }
+        tasksQueued.fetch_add(1, memory_order_relaxed);
+        wake.notify_one();
+    }
+
+    // Runs one queued task of the owner of pending; false if none is left
+    bool takeBack(atomic<int>* pending) {
+        EvalTask t;
+        {
+            lock_guard<mutex> lock(m);
+            auto it = find_if(tasks.begin(), tasks.end(), [&](const EvalTask& q) { return q.pending == pending; });
+            if (it == tasks.end()) return false;
+            t = *it;
+            tasks.erase(it);
+            queued.store(tasks.size(), memory_order_relaxed);
+        }
+        run(t);
+        return true;
+    }
+
+private:
+    unordered_map<string, Node>* circuit = nullptr;
+    vector<thread> threads;
+    mutex m;
+    condition_variable wake;
+    deque<EvalTask> tasks;
+    bool stopping = false;
+    atomic<int> idleWorkers{0};
+    atomic<size_t> queued{0};
+
+    void run(const EvalTask& t) {
+        int saved = evalDepth;
+        evalDepth = t.depth + 1;
+        for (int k = t.first; k < t.last; k++) evaluate(t.node->inputs[k], *circuit);
+        evalDepth = saved;
+        t.pending->fetch_sub(1, memory_order_release);
+    }
+
+    void work() {
+        for (;;) {
+            EvalTask t;
+            {
+                unique_lock<mutex> lock(m);
+                idleWorkers.fetch_add(1, memory_order_relaxed);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                idleWorkers.fetch_sub(1, memory_order_relaxed);
+                if (tasks.empty()) return;
+                t = tasks.front();
+                tasks.pop_front();
+                queued.store(tasks.size(), memory_order_relaxed);
+            }
+            tasksTaken.fetch_add(1, memory_order_relaxed);
+            run(t);
+        }
+    }
+};
+
+static EvalPool* evalPool = nullptr;   // set while evaluating in parallel
+
+// A signal with more than one reader is built once on its own, unless it
+// is marked to be duplicated into its readers
+bool isShared(const Node& node) {
+    return node.fanout > 1 && !node.duplicate;
+}
+
+// Cost a cell pays for reading a signal. A shared signal is paid for once
+// in coverCost(), so it costs nothing here.
+int leafCost(const string& name, unordered_map<string, Node>& circuit) {
+    int cost = evaluate(name, circuit);
+    if (cost < 0) return -1;
+    return isShared(circuit.at(name)) ? 0 : cost;
+}
+
+// The node as its own gate, reading its inputs as leaves
+int plainCost(Node& node, unordered_map<string, Node>& circuit) {
+    // Calculate costs for inputs
+    int inputCostSum = 0;
+    for (const string& input : node.inputs) {
+        int inputCost = leafCost(input, circuit);
+        if (inputCost < 0) return -1;  // Invalid
+        inputCostSum += inputCost;
     }
     
-    // Mark as visited to avoid infinite recursion
-    node.visited = true;
+    int minCost = numeric_limits<int>::max();
     
+    switch (node.type) {
+        case NodeType::NOT:
+            minCost = min(inputCostSum + NOT_COST, inputCostSum + NAND2_COST);  // NOT or NAND with tied inputs
+            break;
+            
+        case NodeType::AND:
+            if (node.inputs.size() == 2) {
+                // Direct AND2 implementation
+                int and2Cost = inputCostSum + AND2_COST;
+                
+                // NAND2 followed by NOT
+                int nandNotCost = inputCostSum + NAND2_COST + NOT_COST;
+                
+                minCost = min(and2Cost, nandNotCost);
+            } else {
+                // For multi-input AND gates, decompose into 2-input gates
+                minCost = inputCostSum + (node.inputs.size() - 1) * AND2_COST;
+            }
+            break;
+            
+        case NodeType::OR:
+            if (node.inputs.size() == 2) {
+                // Direct OR2 implementation
+                int or2Cost = inputCostSum + OR2_COST;
+                
+                // NOR2 followed by NOT
+                int norNotCost = inputCostSum + NOR2_COST + NOT_COST;
+                
+                // NOT on each input followed by NAND2
+                int notNotNandCost = inputCostSum + 2 * NOT_COST + NAND2_COST;
+                
+                minCost = min({or2Cost, norNotCost, notNotNandCost});
+            } else {
+                // For multi-input OR gates, decompose into 2-input gates
+                minCost = inputCostSum + (node.inputs.size() - 1) * OR2_COST;
+            }
+            break;
+            
+        default:
+            return -1;  // Invalid type
+    }
+    return minCost;
+}
+
+// Calculates the minimal cost of one node, evaluating its inputs as needed.
+// Nodes are looked up with at(), which never inserts, so that threads
+// evaluating in parallel only read the map.
+int computeCost(Node& node, unordered_map<string, Node>& circuit) {
     // Base cases
-    if (node.type == INPUT) {
+    if (node.type == NodeType::INPUT) {
         node.cost = 0;
         return 0;
     }
     
-    if (node.type == OUTPUT) {
-        node.cost = evaluate(node.inputs[0], circuit);
+    if (node.type == NodeType::OUTPUT) {
+        node.cost = leafCost(node.inputs[0], circuit);
+        node.leaves = node.inputs;
         return node.cost;
     }
     
+    // A pattern that absorbs signals with other readers duplicates their
+    // logic. While such a signal is still built on its own for the other
+    // readers, the pattern is only taken when it beats the plain gate.
+    auto take = [&](int cost, vector<string> leaves, initializer_list<string> absorbed) {
+        int dups = 0;
+        bool kept = false;
+        for (const string& name : absorbed) {
+            dups += circuit.at(name).fanout > 1 ? 1 : 0;
+            kept = kept || isShared(circuit.at(name));
+        }
+        if (kept) {
+            int plain = plainCost(node, circuit);
+            if (plain >= 0 && plain <= cost) return false;
+        }
+        node.cost = cost;
+        node.leaves = leaves;
+        node.dups = dups;
+        return true;
+    };
+    
     // --- Special Pattern Recognition ---
     
     // NOT patterns
-    if (node.type == NOT) {
+    if (node.type == NodeType::NOT) {
         const string& input = node.inputs[0];
         
         // Double negation: NOT(NOT(x)) -> x
-        if (circuit[input].type == NOT) {
-            int cost = evaluate(circuit[input].inputs[0], circuit);
-            if (cost >= 0) {
-                node.cost = cost;
-                return cost;
-            }
+        if (circuit.at(input).type == NodeType::NOT) {
+            const string& x = circuit.at(input).inputs[0];
+            int cost = leafCost(x, circuit);
+            if (cost >= 0 && take(cost, {x}, {})) return cost;
         }
         
         // NOT(OR(a,b)) -> NOR2(a,b)
-        if (circuit[input].type == OR && circuit[input].inputs.size() == 2) {
-            auto& inputs = circuit[input].inputs;
-            int cost1 = evaluate(inputs[0], circuit);
-            int cost2 = evaluate(inputs[1], circuit);
+        if (circuit.at(input).type == NodeType::OR && circuit.at(input).inputs.size() == 2) {
+            auto inputs = circuit.at(input).inputs;
+            int cost1 = leafCost(inputs[0], circuit);
+            int cost2 = leafCost(inputs[1], circuit);
             if (cost1 >= 0 && cost2 >= 0) {
                 int norCost = cost1 + cost2 + NOR2_COST;
-                node.cost = norCost;
-                return norCost;
+                if (take(norCost, inputs, {input})) return norCost;
             }
         }
         
         // NOT(AND(a,b)) -> NAND2(a,b)
-        if (circuit[input].type == AND && circuit[input].inputs.size() == 2) {
-            auto& inputs = circuit[input].inputs;
-            int cost1 = evaluate(inputs[0], circuit);
-            int cost2 = evaluate(inputs[1], circuit);
+        if (circuit.at(input).type == NodeType::AND && circuit.at(input).inputs.size() == 2) {
+            auto inputs = circuit.at(input).inputs;
+            int cost1 = leafCost(inputs[0], circuit);
+            int cost2 = leafCost(inputs[1], circuit);
             if (cost1 >= 0 && cost2 >= 0) {
                 int nandCost = cost1 + cost2 + NAND2_COST;
-                node.cost = nandCost;
-                return nandCost;
+                if (take(nandCost, inputs, {input})) return nandCost;
             }
         }
         
         // AOI21 pattern: NOT(OR(AND(a,b),c))
-        if (circuit[input].type == OR && circuit[input].inputs.size() == 2) {
-            auto& orInputs = circuit[input].inputs;
-            bool and0 = (circuit.count(orInputs[0]) > 0 && circuit[orInputs[0]].type == AND);
-            bool and1 = (circuit.count(orInputs[1]) > 0 && circuit[orInputs[1]].type == AND);
+        if (circuit.at(input).type == NodeType::OR && circuit.at(input).inputs.size() == 2) {
+            auto orInputs = circuit.at(input).inputs;
+            bool and0 = (circuit.count(orInputs[0]) > 0 && circuit.at(orInputs[0]).type == NodeType::AND);
+            bool and1 = (circuit.count(orInputs[1]) > 0 && circuit.at(orInputs[1]).type == NodeType::AND);
             
             // Case 1: AND + non-AND
             if (and0 && !and1) {
-                auto& andInputs = circuit[orInputs[0]].inputs;
-                int costA = evaluate(andInputs[0], circuit);
-                int costB = evaluate(andInputs[1], circuit);
-                int costC = evaluate(orInputs[1], circuit);
+                auto andInputs = circuit.at(orInputs[0]).inputs;
+                int costA = leafCost(andInputs[0], circuit);
+                int costB = leafCost(andInputs[1], circuit);
+                int costC = leafCost(orInputs[1], circuit);
                 if (costA >= 0 && costB >= 0 && costC >= 0) {
                     int aoi21Cost = costA + costB + costC + AOI21_COST;
-                    node.cost = aoi21Cost;
-                    return aoi21Cost;
+                    if (take(aoi21Cost, {andInputs[0], andInputs[1], orInputs[1]},
+                             {input, orInputs[0]}))
+                        return aoi21Cost;
                 }
             }
             
             // Case 2: non-AND + AND
             if (!and0 && and1) {
-                auto& andInputs = circuit[orInputs[1]].inputs;
-                int costA = evaluate(andInputs[0], circuit);
-                int costB = evaluate(andInputs[1], circuit);
-                int costC = evaluate(orInputs[0], circuit);
+                auto andInputs = circuit.at(orInputs[1]).inputs;
+                int costA = leafCost(andInputs[0], circuit);
+                int costB = leafCost(andInputs[1], circuit);
+                int costC = leafCost(orInputs[0], circuit);
                 if (costA >= 0 && costB >= 0 && costC >= 0) {
                     int aoi21Cost = costA + costB + costC + AOI21_COST;
-                    node.cost = aoi21Cost;
-                    return aoi21Cost;
+                    if (take(aoi21Cost, {andInputs[0], andInputs[1], orInputs[0]},
+                             {input, orInputs[1]}))
+                        return aoi21Cost;
                 }
             }
             
             // Case 3: AND + AND (AOI22 pattern)
             if (and0 && and1) {
-                auto& andInputs0 = circuit[orInputs[0]].inputs;
-                auto& andInputs1 = circuit[orInputs[1]].inputs;
-                int costA = evaluate(andInputs0[0], circuit);
-                int costB = evaluate(andInputs0[1], circuit);
-                int costC = evaluate(andInputs1[0], circuit);
-                int costD = evaluate(andInputs1[1], circuit);
+                auto andInputs0 = circuit.at(orInputs[0]).inputs;
+                auto andInputs1 = circuit.at(orInputs[1]).inputs;
+                int costA = leafCost(andInputs0[0], circuit);
+                int costB = leafCost(andInputs0[1], circuit);
+                int costC = leafCost(andInputs1[0], circuit);
+                int costD = leafCost(andInputs1[1], circuit);
                 if (costA >= 0 && costB >= 0 && costC >= 0 && costD >= 0) {
                     int aoi22Cost = costA + costB + costC + costD + AOI22_COST;
-                    node.cost = aoi22Cost;
-                    return aoi22Cost;
+                    if (take(aoi22Cost, {andInputs0[0], andInputs0[1], andInputs1[0], andInputs1[1]},
+                             {input, orInputs[0], orInputs[1]}))
+                        return aoi22Cost;
                 }
             }
         }
     }
     
     // AND Pattern: AND(AND(a,b), NOT(OR(c,d))) or AND(NOT(OR(c,d)), AND(a,b))
-    if (node.type == AND && node.inputs.size() == 2) {
-        auto& inputs = node.inputs;
+    if (node.type == NodeType::AND && node.inputs.size() == 2) {
+        auto inputs = node.inputs;
         
         // Check for pattern: AND(AND(a,b), NOT(OR(c,d)))
-        if (circuit[inputs[0]].type == AND && circuit[inputs[1]].type == NOT && 
-            circuit.count(circuit[inputs[1]].inputs[0]) > 0 && circuit[circuit[inputs[1]].inputs[0]].type == OR) {
+        if (circuit.at(inputs[0]).type == NodeType::AND && circuit.at(inputs[1]).type == NodeType::NOT && 
+            circuit.count(circuit.at(inputs[1]).inputs[0]) > 0 && circuit.at(circuit.at(inputs[1]).inputs[0]).type == NodeType::OR) {
             
-            auto& andInputs = circuit[inputs[0]].inputs;
-            auto& orInputs = circuit[circuit[inputs[1]].inputs[0]].inputs;
+            string orNode = circuit.at(inputs[1]).inputs[0];
+            auto andInputs = circuit.at(inputs[0]).inputs;
+            auto orInputs = circuit.at(orNode).inputs;
             
-            int costA = evaluate(andInputs[0], circuit);
-            int costB = evaluate(andInputs[1], circuit);
-            int costC = evaluate(orInputs[0], circuit);
-            int costD = evaluate(orInputs[1], circuit);
+            int costA = leafCost(andInputs[0], circuit);
+            int costB = leafCost(andInputs[1], circuit);
+            int costC = leafCost(orInputs[0], circuit);
+            int costD = leafCost(orInputs[1], circuit);
             
             if (costA >= 0 && costB >= 0 && costC >= 0 && costD >= 0) {
                 int nandCost = costA + costB + NAND2_COST;
                 int orCost = costC + costD + OR2_COST;
                 int norCost = nandCost + orCost + NOR2_COST;
-                node.cost = norCost;
-                return norCost;
+                if (take(norCost, {andInputs[0], andInputs[1], orInputs[0], orInputs[1]},
+                         {inputs[0], inputs[1], orNode}))
+                    return norCost;
             }
         }
         
         // Check for pattern: AND(NOT(OR(c,d)), AND(a,b))
-        if (circuit[inputs[1]].type == AND && circuit[inputs[0]].type == NOT && 
-            circuit.count(circuit[inputs[0]].inputs[0]) > 0 && circuit[circuit[inputs[0]].inputs[0]].type == OR) {
+        if (circuit.at(inputs[1]).type == NodeType::AND && circuit.at(inputs[0]).type == NodeType::NOT && 
+            circuit.count(circuit.at(inputs[0]).inputs[0]) > 0 && circuit.at(circuit.at(inputs[0]).inputs[0]).type == NodeType::OR) {
             
-            auto& andInputs = circuit[inputs[1]].inputs;
-            auto& orInputs = circuit[circuit[inputs[0]].inputs[0]].inputs;
+            string orNode = circuit.at(inputs[0]).inputs[0];
+            auto andInputs = circuit.at(inputs[1]).inputs;
+            auto orInputs = circuit.at(orNode).inputs;
             
-            int costA = evaluate(andInputs[0], circuit);
-            int costB = evaluate(andInputs[1], circuit);
-            int costC = evaluate(orInputs[0], circuit);
-            int costD = evaluate(orInputs[1], circuit);
+            int costA = leafCost(andInputs[0], circuit);
+            int costB = leafCost(andInputs[1], circuit);
+            int costC = leafCost(orInputs[0], circuit);
+            int costD = leafCost(orInputs[1], circuit);
             
             if (costA >= 0 && costB >= 0 && costC >= 0 && costD >= 0) {
                 int nandCost = costA + costB + NAND2_COST;
                 int orCost = costC + costD + OR2_COST;
                 int norCost = nandCost + orCost + NOR2_COST;
-                node.cost = norCost;
-                return norCost;
+                if (take(norCost, {andInputs[0], andInputs[1], orInputs[0], orInputs[1]},
+                         {inputs[0], inputs[1], orNode}))
+                    return norCost;
             }
         }
     }
     
     // --- Standard Gate Implementations ---
     
-    // Calculate costs for inputs
-    int inputCostSum = 0;
-    for (const string& input : node.inputs) {
-        int inputCost = evaluate(input, circuit);
-        if (inputCost < 0) return -1;  // Invalid
-        inputCostSum += inputCost;
-    }
-    
-    int minCost = numeric_limits<int>::max();
+    int minCost = plainCost(node, circuit);
+    if (minCost < 0) return -1;
     
-    switch (node.type) {
-        case NOT:
-            minCost = min(inputCostSum + NOT_COST, inputCostSum + NAND2_COST);  // NOT or NAND with tied inputs
-            break;
-            
-        case AND:
-            if (node.inputs.size() == 2) {
-                // Direct AND2 implementation
-                int and2Cost = inputCostSum + AND2_COST;
-                
-                // NAND2 followed by NOT
-                int nandNotCost = inputCostSum + NAND2_COST + NOT_COST;
-                
-                minCost = min(and2Cost, nandNotCost);
-            } else {
-                // For multi-input AND gates, decompose into 2-input gates
-                minCost = inputCostSum + (node.inputs.size() - 1) * AND2_COST;
+    node.cost = minCost;
+    node.leaves = node.inputs;
+    node.dups = 0;
+    return minCost;
+}
+
+// Evaluates the inputs of a wide node on several threads, in contiguous
+// slices, so that computing the node itself only finds memoized inputs
+void evaluateInputsInParallel(const Node& node, unordered_map<string, Node>& circuit) {
+    int n = node.inputs.size();
+    int slice = max(1, n / parallelThreads);
+    atomic<int> pending{0};
+    int first = slice;   // this thread keeps [0, slice)
+    for (int idle = evalPool->idle(); first < n && idle > 0; first += slice, idle--) {
+        pending.fetch_add(1, memory_order_relaxed);
+        evalPool->submit(EvalTask{&node, first, min(first + slice, n), evalDepth, &pending});
+    }
+    // whatever was not queued is evaluated here
+    for (int k = 0; k < slice && k < n; k++) evaluate(node.inputs[k], circuit);
+    for (int k = first; k < n; k++) evaluate(node.inputs[k], circuit);
+    while (pending.load(memory_order_acquire) > 0) {
+        if (!evalPool->takeBack(&pending)) this_thread::yield();
+    }
+}
+
+// Main evaluation function - calculates minimal cost for each node,
+// memoized in the node, or in costMemo when evaluating in parallel
+int evaluate(const string& nodeName, unordered_map<string, Node>& circuit) {
+    Node& node = circuit.at(nodeName);
+
+    if (!costMemo) {
+        // Return memoized result if available
+        if (node.visited && node.cost >= 0) {
+            return node.cost;
+        }
+        // Mark as visited to avoid infinite recursion
+        node.visited = true;
+        return computeCost(node, circuit);
+    }
+
+    bool claimed = false;
+    atomic<int>& slot = costMemo->find(&node, claimed);
+    if (!claimed) {
+        int cost = slot.load(memory_order_acquire);
+        if (cost != CostMemo::BUSY) return cost;
+        // Another thread is computing the node: help with its inputs, then
+        // wait. Loops were refused up front, so the node does finish.
+        busyWaits.fetch_add(1, memory_order_relaxed);
+        for (const string& input : node.inputs) evaluate(input, circuit);
+        while ((cost = slot.load(memory_order_acquire)) == CostMemo::BUSY) this_thread::yield();
+        return cost;
+    }
+    // This thread owns the node until its cost is published
+    evalDepth++;
+    if ((int)node.inputs.size() >= PARALLEL_MIN_FANIN && evalDepth <= PARALLEL_MAX_DEPTH && evalPool->idle() > 0)
+        evaluateInputsInParallel(node, circuit);
+    int cost = computeCost(node, circuit);
+    evalDepth--;
+    slot.store(cost, memory_order_release);
+    return cost;
+}
+
+// Total cost of the cover: the output's tree plus, once each, every shared
+// signal the chosen cells read. A shared signal that all its readers absorb
+// is not built on its own. dups counts the cells that duplicate one.
+int coverCost(const string& outputNode, unordered_map<string, Node>& circuit, int& dups) {
+    for (auto& pair : circuit) {
+        pair.second.visited = false;
+        pair.second.cost = -1;
+    }
+    if (costMemo) costMemo->clear();
+    int total = evaluate(outputNode, circuit);
+    if (total < 0) return -1;
+    dups = 0;
+    unordered_map<string, bool> seen;
+    vector<string> stack = {outputNode};
+    seen[outputNode] = true;
+    while (!stack.empty()) {
+        Node& node = circuit[stack.back()];
+        stack.pop_back();
+        dups += node.dups;
+        for (const string& leaf : node.leaves) {
+            if (seen[leaf]) continue;
+            seen[leaf] = true;
+            if (isShared(circuit[leaf])) total += circuit[leaf].cost;
+            stack.push_back(leaf);
+        }
+    }
+    return total;
+}
+
+// Nodes whose patterns read the cost or check the sharing of a signal up to
+// this many levels below them (AND(AND(a,b), NOT(OR(c,d))) reads c and d)
+static const int PATTERN_DEPTH = 3;
+
+// The output's cone in topological order (inputs first), with the readers
+// of each signal as indices into it
+struct ConeOrder {
+    vector<string> names;
+    vector<Node*> nodes;
+    vector<vector<int>> readers;
+};
+
+ConeOrder coneOrder(const string& outputNode, unordered_map<string, Node>& circuit) {
+    ConeOrder cone;
+    unordered_map<string, int> index;
+    vector<pair<string, size_t>> stack = {{outputNode, 0}};
+    index[outputNode] = -1;
+    while (!stack.empty()) {
+        const string& name = stack.back().first;
+        const vector<string>& inputs = circuit.at(name).inputs;
+        size_t& next = stack.back().second;
+        if (next < inputs.size()) {
+            const string& input = inputs[next++];
+            if (index.emplace(input, -1).second) stack.push_back({input, 0});
+            continue;
+        }
+        index[name] = cone.names.size();
+        cone.names.push_back(name);
+        cone.nodes.push_back(&circuit.at(name));
+        stack.pop_back();
+    }
+    cone.readers.resize(cone.names.size());
+    for (size_t i = 0; i < cone.names.size(); i++) {
+        for (const string& input : cone.nodes[i]->inputs) cone.readers[index.at(input)].push_back(i);
+    }
+    return cone;
+}
+
+// Adds the readers of node i, up to PATTERN_DEPTH levels up, to dirty
+void addReaders(const ConeOrder& cone, int i, set<int>& dirty) {
+    vector<int> level = {i}, next;
+    for (int d = 0; d < PATTERN_DEPTH && !level.empty(); d++) {
+        next.clear();
+        for (int v : level) {
+            for (int r : cone.readers[v]) {
+                if (dirty.insert(r).second) next.push_back(r);
             }
-            break;
-            
-        case OR:
-            if (node.inputs.size() == 2) {
-                // Direct OR2 implementation
-                int or2Cost = inputCostSum + OR2_COST;
-                
-                // NOR2 followed by NOT
-                int norNotCost = inputCostSum + NOR2_COST + NOT_COST;
-                
-                // NOT on each input followed by NAND2
-                int notNotNandCost = inputCostSum + 2 * NOT_COST + NAND2_COST;
-                
-                minCost = min({or2Cost, norNotCost, notNotNandCost});
+        }
+        level.swap(next);
+    }
+}
+
+// Decides while costing, bottom-up, whether each shared signal is built once
+// or duplicated into its readers. Duplicating one re-costs only the readers
+// above it, up to the nearest shared signals, and is kept when their change
+// undercuts building the signal once. One full evaluation then checks the
+// result against the cover with nothing duplicated.
+int chooseDuplication(const string& outputNode, unordered_map<string, Node>& circuit, int& dups) {
+    int base = coverCost(outputNode, circuit, dups);
+    if (base < 0) return -1;
+    ConeOrder cone = coneOrder(outputNode, circuit);
+    int n = cone.names.size();
+    // the costs just computed are the memo from here on, updated in place
+    CostMemo* memo = costMemo;
+    costMemo = nullptr;
+    for (Node* node : cone.nodes) node->visited = node->cost >= 0;
+
+    struct Saved {
+        Node* node;
+        int cost;
+        vector<string> leaves;
+        int dups;
+    };
+    for (int s = 0; s < n; s++) {
+        Node& shared = *cone.nodes[s];
+        if (shared.fanout < 2 || shared.type == NodeType::INPUT || cone.names[s] == outputNode) continue;
+        // built once, it is paid for once if a reader's cell reads it
+        bool built = false;
+        for (int r : cone.readers[s]) {
+            const vector<string>& leaves = cone.nodes[r]->leaves;
+            built = built || find(leaves.begin(), leaves.end(), cone.names[s]) != leaves.end();
+        }
+        shared.duplicate = true;
+        int delta = built ? -shared.cost : 0;
+        vector<Saved> saved;
+        set<int> dirty;
+        addReaders(cone, s, dirty);
+        // in topological order, so every node is re-costed once, after its inputs
+        while (!dirty.empty()) {
+            int i = *dirty.begin();
+            dirty.erase(dirty.begin());
+            Node& node = *cone.nodes[i];
+            saved.push_back({&node, node.cost, node.leaves, node.dups});
+            int cost = computeCost(node, circuit);
+            if (cost < 0) {
+                delta = 0;
+                break;
+            }
+            if (cost == saved.back().cost) continue;
+            // a shared signal's readers read it for free; past it, only
+            // the total changes
+            if (isShared(node) || cone.names[i] == outputNode) {
+                delta += cost - saved.back().cost;
             } else {
-                // For multi-input OR gates, decompose into 2-input gates
-                minCost = inputCostSum + (node.inputs.size() - 1) * OR2_COST;
+                addReaders(cone, i, dirty);
             }
-            break;
-            
-        default:
-            return -1;  // Invalid type
+        }
+        if (delta < 0) continue;
+        shared.duplicate = false;
+        for (auto it = saved.rbegin(); it != saved.rend(); ++it) {
+            it->node->cost = it->cost;
+            it->node->leaves = it->leaves;
+            it->node->dups = it->dups;
+        }
     }
-    
-    node.cost = minCost;
-    return minCost;
+    costMemo = memo;
+    int d = 0;
+    int cost = coverCost(outputNode, circuit, d);
+    if (cost >= 0 && cost <= base) {
+        dups = d;
+        return cost;
+    }
+    // the local estimates missed a change further up: duplicate nothing
+    for (Node* node : cone.nodes) node->duplicate = false;
+    return coverCost(outputNode, circuit, dups);
 }
 
 int main(int argc, char* argv[]) {
     string inputFile = "input2.txt";
-    if (argc > 1) {
-        inputFile = argv[1];
+    string outputFile = "output.txt";
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            parallelThreads = max(1, atoi(argv[++i]));
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() > 0) {
+        inputFile = files[0];
+    }
+    if (files.size() > 1) {
+        outputFile = files[1];
     }
     
     unordered_map<string, Node> circuit;
@@ -320,14 +757,27 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Reset visited flags and costs
-    for (auto& pair : circuit) {
-        pair.second.visited = false;
-        pair.second.cost = -1;
+    // evaluate() would recurse around a loop forever, or wait for a node
+    // in progress that never finishes
+    if (reportFileLoops(inputFile) > 0) return 1;
+
+    countFanout(outputNode, circuit);
+
+    // With --threads, costs are memoized in a shared table; the circuit map
+    // is only read from here on
+    unique_ptr<CostMemo> memo;
+    unique_ptr<EvalPool> pool;
+    if (parallelThreads > 1) {
+        memo.reset(new CostMemo(circuit.size()));
+        costMemo = memo.get();
+        pool.reset(new EvalPool);
+        pool->start(parallelThreads - 1, circuit);
+        evalPool = pool.get();
     }
     
     // Calculate the minimal cost
-    int cost = evaluate(outputNode, circuit);
+    int dups = 0;
+    int cost = chooseDuplication(outputNode, circuit, dups);
     
     if (cost < 0) {
         cerr << "Error: Could not calculate valid cost!" << endl;
@@ -335,11 +785,16 @@ int main(int argc, char* argv[]) {
     }
 
     // Output the result
-    ofstream outFile("output.txt");
+    ofstream outFile(outputFile);
     outFile << cost << endl;
     outFile.close();
 
     cout << "Minimal cost = " << cost << endl;
+    cout << "Duplicated shared signals: " << dups << endl;
+    if (costMemo) {
+        cout << "Parallel evaluate: " << parallelThreads << " threads, " << tasksQueued << " slices queued, "
+             << tasksTaken << " taken by workers, " << busyWaits << " waits on nodes in progress" << endl;
+    }
 
     return 0;
 }
\ No newline at end of file
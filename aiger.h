@@ -0,0 +1,270 @@
+// aiger.h
+// Reader for binary AIGER ("aig M I L O A") files, the and-inverter graphs
+// synthesis tools write. The file is read once, front to back (compressed
+// files too, see compressed_input.h): the header, the latch and output
+// literals, the delta-coded AND gates and the symbol table.
+//
+// With a subject graph given, every AND goes straight into it as NOT(NAND2)
+// and an inverted edge becomes a NOT node, shared by every reader of that
+// literal; the netlist then only names the inputs, constants and outputs
+// (outputs have no fan-ins there). Without one, the gates are written to the
+// netlist instead (AND gates and NOT signals named "_l<literal>"), for the
+// passes that need a netlist first.
+//
+// The mapper is combinational, so latches are cut: a latch's output is read
+// as an input and its next state is mapped as an output "<latch>_next".
+// Unnamed signals are called i<k>, l<k> and o<k>. Bad-state, constraint,
+// justice and fairness sections (AIGER 1.9) are refused.
+#ifndef AIGER_H
+#define AIGER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+#include "netlist.h"
+#include "subject_graph.h"
+#include "compressed_input.h"
+
+struct AigerStats {
+    uint32_t maxVar = 0, inputs = 0, latches = 0, outputs = 0, ands = 0;
+    uint32_t symbols = 0;   // names taken from the symbol table
+};
+
+// Buffered bytes of an InputFile
+class AigerStream {
+public:
+    explicit AigerStream(InputFile &f) : file(f), buf(1 << 20) {}
+
+    int get() {
+        if (pos == end) {
+            pos = 0;
+            end = file.read(buf.data(), buf.size());
+            if (end == 0) return -1;
+        }
+        return (unsigned char)buf[pos++];
+    }
+
+    // One text line without its '\n'; false at the end of the file
+    bool line(std::string &s) {
+        s.clear();
+        int c = get();
+        if (c < 0) return false;
+        for (; c >= 0 && c != '\n'; c = get()) s.push_back((char)c);
+        return true;
+    }
+
+    // A 7-bits-per-byte number of the AND section; false if cut off or too long
+    bool delta(uint32_t &x) {
+        x = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            int c = get();
+            if (c < 0) return false;
+            x |= (uint32_t)(c & 0x7F) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        return false;
+    }
+
+private:
+    InputFile &file;
+    std::vector<char> buf;
+    size_t pos = 0, end = 0;
+};
+
+// Whether fname (possibly compressed) starts like an AIGER file, binary or ASCII
+inline bool isAigerFile(const std::string &fname) {
+    InputFile f;
+    char h[4];
+    if (!f.open(fname)) return false;
+    size_t n = 0;
+    while (n < 4) {
+        size_t k = f.read(h + n, 4 - n);
+        if (k == 0) return false;
+        n += k;
+    }
+    return (h[0] == 'a' && h[1] == 'i' && h[2] == 'g' && h[3] == ' ') ||
+           (h[0] == 'a' && h[1] == 'a' && h[2] == 'g' && h[3] == ' ');
+}
+
+// Renames signal id unless the name is taken
+inline bool renameSignal(Netlist &nl, int id, const std::string &name) {
+    if (name.empty() || nl.ids.count(name)) return false;
+    nl.ids.erase(nl.names[id]);
+    nl.names[id] = name;
+    nl.ids.emplace(name, id);
+    return true;
+}
+
+// Reads the binary AIGER file fname into nl and, when sg is set, straight
+// into sg (see above). Returns false with a message on stderr on a malformed
+// or truncated file.
+inline bool readAiger(const std::string &fname, Netlist &nl, SubjectGraph *sg, AigerStats *stats = nullptr) {
+    InputFile f;
+    if (!f.open(fname)) return false;
+    AigerStream in(f);
+    auto fail = [&](const std::string &msg) {
+        std::cerr << fname << ": " << (f.error.empty() ? msg : f.error) << std::endl;
+        return false;
+    };
+
+    std::string line;
+    if (!in.line(line)) return fail("empty file");
+    std::istringstream header(line);
+    std::string magic;
+    uint64_t h[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};   // M I L O A B C J F
+    header >> magic;
+    if (magic == "aag") return fail("ASCII AIGER is not supported; convert it with aigtoaig first");
+    int fields = 0;
+    while (fields < 9 && header >> h[fields]) fields++;
+    if (magic != "aig" || fields < 5) return fail("not a binary AIGER file");
+    if (h[5] || h[6] || h[7] || h[8]) return fail("bad-state, constraint, justice and fairness sections are not supported");
+    if (h[0] >= (1u << 30) || h[0] != h[1] + h[2] + h[4]) return fail("header: M must be I + L + A");
+    AigerStats st;
+    st.maxVar = (uint32_t)h[0];
+    st.inputs = (uint32_t)h[1];
+    st.latches = (uint32_t)h[2];
+    st.outputs = (uint32_t)h[3];
+    st.ands = (uint32_t)h[4];
+    uint32_t maxLit = 2 * st.maxVar + 1;
+
+    // variable 0 is FALSE; inputs and latch outputs come next, then the ANDs
+    std::vector<int> sig(st.maxVar + 1, -1);    // netlist signal of each input or latch variable
+    std::vector<int> node;                      // subject node of each variable (sg only)
+    std::vector<int> neg;                       // its NOT node, or netlist NOT signal without sg
+    if (sg) {
+        node.assign(st.maxVar + 1, -1);
+        neg.assign(st.maxVar + 1, -1);
+        // an AND is at most two nodes, NAND2 and NOT
+        size_t nodes = sg->size() + st.inputs + st.latches + 2 + 2 * (size_t)st.ands;
+        sg->nodes.reserve(nodes);
+        sg->level.reserve(nodes);
+        sg->source.reserve(nodes);
+        sg->repr.reserve(nodes);
+        sg->nextChoice.reserve(nodes);
+        sg->strash.reserve(sg->strash.size() + 2 * (size_t)st.ands);
+    } else {
+        neg.assign(st.maxVar + 1, -1);
+    }
+    for (uint32_t k = 0; k < st.inputs + st.latches; k++) {
+        uint32_t v = k + 1;
+        bool latch = k >= st.inputs;
+        sig[v] = nl.intern((latch ? "l" : "i") + std::to_string(latch ? k - st.inputs : k));
+        nl.gates[sig[v]].type = GateType::INPUT;
+        if (sg) node[v] = sg->addInput(sig[v]);
+    }
+    int constSig[2] = {-1, -1};
+    auto constant = [&](uint32_t lit) {
+        if (constSig[lit] < 0) {
+            constSig[lit] = nl.intern(lit ? "1" : "0");
+            if (sg) {
+                int id = constSig[lit];
+                constSig[lit] = sg->addInput(id);
+            }
+        }
+        return constSig[lit];
+    };
+    // subject node of a literal
+    auto litNode = [&](uint32_t lit) {
+        if (lit < 2) return constant(lit);
+        uint32_t v = lit >> 1;
+        if (!(lit & 1)) return node[v];
+        if (neg[v] < 0) neg[v] = sg->addNot(node[v]);
+        return neg[v];
+    };
+    // netlist signal of a literal
+    auto litSignal = [&](uint32_t lit) {
+        if (lit < 2) return constant(lit);
+        uint32_t v = lit >> 1;
+        if (!(lit & 1)) return sig[v];
+        if (neg[v] < 0) {
+            neg[v] = nl.intern("_l" + std::to_string(lit));
+            nl.gates[neg[v]].type = GateType::NOT;
+            nl.gates[neg[v]].inputs = {sig[v]};
+        }
+        return neg[v];
+    };
+
+    // latch next states and outputs are literals of gates read later
+    std::vector<uint32_t> outLits;
+    for (uint32_t k = 0; k < st.latches + st.outputs; k++) {
+        if (!in.line(line)) return fail("file ends in the latch and output section");
+        std::istringstream ls(line);
+        uint64_t lit;
+        if (!(ls >> lit) || lit > maxLit) return fail("bad literal '" + line + "'");
+        outLits.push_back((uint32_t)lit);
+    }
+
+    for (uint32_t k = 0; k < st.ands; k++) {
+        uint32_t v = st.inputs + st.latches + 1 + k;
+        uint32_t lhs = 2 * v, d0, d1;
+        if (!in.delta(d0) || !in.delta(d1)) return fail("file ends in AND gate " + std::to_string(k));
+        if (d0 == 0 || d0 > lhs || d1 > lhs - d0) return fail("AND gate " + std::to_string(k) + " is not ordered");
+        uint32_t r0 = lhs - d0, r1 = r0 - d1;
+        if (sg) {
+            node[v] = sg->addAnd(litNode(r0), litNode(r1));
+        } else {
+            int a = litSignal(r0), b = litSignal(r1);
+            sig[v] = nl.intern("_l" + std::to_string(lhs));
+            nl.gates[sig[v]].type = GateType::AND;
+            nl.gates[sig[v]].inputs = {a, b};
+        }
+    }
+
+    // outputs first, then the latches' next states
+    std::vector<int> outSig(outLits.size());
+    for (uint32_t k = 0; k < outLits.size(); k++) {
+        bool latch = k < st.latches;
+        uint32_t idx = latch ? k : k - st.latches;
+        int id = nl.intern(latch ? "l" + std::to_string(idx) + "_next" : "o" + std::to_string(idx));
+        nl.gates[id].type = GateType::OUTPUT;
+        if (!sg) nl.gates[id].inputs = {litSignal(outLits[k])};
+        outSig[k] = id;
+    }
+    for (uint32_t k = 0; k < st.outputs; k++) nl.outputs.push_back(outSig[st.latches + k]);
+    for (uint32_t k = 0; k < st.latches; k++) nl.outputs.push_back(outSig[k]);
+
+    // symbol table, then an optional comment section
+    while (in.line(line) && line != "c") {
+        if (line.empty()) continue;
+        size_t sp = line.find(' ');
+        char kind = line[0];
+        if (sp == std::string::npos || (kind != 'i' && kind != 'l' && kind != 'o'))
+            return fail("bad symbol '" + line + "'");
+        uint64_t idx = std::strtoull(line.c_str() + 1, nullptr, 10);
+        uint64_t count = kind == 'i' ? st.inputs : kind == 'l' ? st.latches : st.outputs;
+        if (idx >= count) return fail("symbol for a missing signal: '" + line + "'");
+        std::string name = line.substr(sp + 1);
+        // the text formats split names at white space
+        for (char &c : name)
+            if (c == ' ' || c == '\t' || c == '\r') c = '_';
+        bool named = false;
+        if (kind == 'i') {
+            named = renameSignal(nl, sig[idx + 1], name);
+        } else if (kind == 'o') {
+            named = renameSignal(nl, outSig[st.latches + idx], name);
+        } else {
+            named = renameSignal(nl, sig[st.inputs + idx + 1], name);
+            renameSignal(nl, outSig[idx], name + "_next");
+        }
+        if (named) st.symbols++;
+    }
+    if (!f.error.empty()) return fail(f.error);
+
+    if (sg) {
+        for (int k = 0; k < (int)nl.outputs.size(); k++) {
+            uint32_t lit = k < (int)st.outputs ? outLits[st.latches + k] : outLits[k - st.outputs];
+            int n = litNode(lit);
+            // a node no other signal names takes the output's name
+            if (sg->source[n] < 0) sg->source[n] = nl.outputs[k];
+            sg->outputs.push_back(n);
+        }
+    }
+    if (stats) *stats = st;
+    if (nl.outputs.empty()) return fail("no outputs");
+    return true;
+}
+
+#endif
@@ -7,20 +7,12 @@
 #include <sstream>
 #include <limits>
 
+#include "cell_library.h"
+
 using namespace std;
 
-// Node types in the circuit
-enum class NodeType {
-    AND,
-    OR,
-    NOT,
-    INPUT,
-    OUTPUT,
-    NAND2,
-    NOR2,
-    AOI21,
-    AOI22
-};
+// Gate types come from the shared technology table
+using NodeType = GateType;
 
 // Node structure
 struct Node {
@@ -37,15 +29,6 @@ struct Node {
       {}
 };
 
-// Gate costs
-static const int NOT_COST   = 2;
-static const int NAND2_COST = 3;
-static const int AND2_COST  = 4;
-static const int NOR2_COST  = 6;
-static const int OR2_COST   = 4;
-static const int AOI21_COST = 7;
-static const int AOI22_COST = 7;
-
 // Utility to trim whitespace
 static std::string trim(const std::string &s) {
     size_t f = s.find_first_not_of(" \t\r\n");
@@ -242,12 +225,14 @@ private:
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    std::string inputFile = argc > 1 ? argv[1] : "input.txt";
+    std::string outputFile = argc > 2 ? argv[2] : "output.txt";
     TechnologyMapper tm;
-    if(!tm.readNetlist("input.txt")) return 1;
+    if(!tm.readNetlist(inputFile)) return 1;
     int c = tm.calculateMinimalCost();
     if(c<0) return 1;
-    std::ofstream out("output.txt"); out<<c;
+    std::ofstream out(outputFile); out<<c;
     std::cout<<"Minimal cost: "<<c<<std::endl;
     return 0;
 }
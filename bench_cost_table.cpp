@@ -0,0 +1,113 @@
+// bench_cost_table.cpp
+// Microbenchmark for the shared cost table in cell_library.h.
+// Generates a random AND/OR/NOT netlist and runs the NAND/NOT costing sweep
+// from TM418.cpp twice: once with the old string-keyed cost_map and gate-name
+// compares, once with the dense GateType-indexed table.
+//
+// Build: g++ -std=c++17 -O2 -o bench_cost_table bench_cost_table.cpp
+// Run:   ./bench_cost_table [gates]        (default 10000000)
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+#include "cell_library.h"
+
+using namespace std;
+
+struct BenchNode {
+    string gate;      // gate keyword as the old parsers kept it
+    GateType type;    // same gate as a table index
+    int in0;
+    int in1;
+};
+
+static const int NUM_INPUTS = 1000;
+
+// Costs are summed tree-style like TM418.cpp, so they grow exponentially on a
+// reconvergent DAG; unsigned arithmetic keeps the wraparound well defined.
+
+// Builds a topologically ordered netlist; fan-ins come from a window of
+// recent nodes so the DAG stays deep instead of collapsing onto the inputs.
+vector<BenchNode> generateNetlist(int gates) {
+    mt19937 rng(418);
+    vector<BenchNode> nl;
+    nl.reserve(NUM_INPUTS + gates);
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        nl.push_back({"INPUT", GateType::INPUT, -1, -1});
+    }
+    for (int i = 0; i < gates; i++) {
+        int n = (int)nl.size();
+        int window = min(n, 4096);
+        int a = n - 1 - (int)(rng() % window);
+        int b = n - 1 - (int)(rng() % window);
+        switch (rng() % 3) {
+            case 0: nl.push_back({"AND", GateType::AND, a, b}); break;
+            case 1: nl.push_back({"OR", GateType::OR, a, b}); break;
+            default: nl.push_back({"NOT", GateType::NOT, a, -1}); break;
+        }
+    }
+    return nl;
+}
+
+// Old kernel: hashes the cost keys and compares gate strings per node
+unsigned sweepStringKeyed(const vector<BenchNode> &nl, vector<unsigned> &cost) {
+    unordered_map<string, int> cost_map = { {"NOT", 2}, {"NAND2", 3} };
+    for (size_t i = 0; i < nl.size(); i++) {
+        const BenchNode &n = nl[i];
+        if (n.gate == "INPUT") {
+            cost[i] = 0;
+        } else if (n.gate == "NOT") {
+            cost[i] = cost[n.in0] + cost_map["NOT"];
+        } else if (n.gate == "AND") {
+            cost[i] = cost[n.in0] + cost[n.in1] + cost_map["NAND2"] + cost_map["NOT"];
+        } else if (n.gate == "OR") {
+            cost[i] = cost[n.in0] + cost[n.in1] + 3 * cost_map["NOT"] + cost_map["NAND2"];
+        }
+    }
+    return cost.back();
+}
+
+// New kernel: one indexed load from a per-type table
+unsigned sweepDenseTable(const vector<BenchNode> &nl, vector<unsigned> &cost) {
+    int gateCost[GATE_TYPE_COUNT] = {};
+    gateCost[(int)GateType::NOT] = NOT_COST;
+    gateCost[(int)GateType::AND] = NAND2_COST + NOT_COST;
+    gateCost[(int)GateType::OR] = NAND2_COST + 3 * NOT_COST;
+    for (size_t i = 0; i < nl.size(); i++) {
+        const BenchNode &n = nl[i];
+        unsigned c = gateCost[(int)n.type];
+        if (n.in0 >= 0) c += cost[n.in0];
+        if (n.in1 >= 0) c += cost[n.in1];
+        cost[i] = c;
+    }
+    return cost.back();
+}
+
+template <class F>
+double timeSweep(const char *label, F sweep, const vector<BenchNode> &nl, vector<unsigned> &cost) {
+    auto t0 = chrono::steady_clock::now();
+    unsigned result = sweep(nl, cost);
+    auto t1 = chrono::steady_clock::now();
+    double sec = chrono::duration<double>(t1 - t0).count();
+    double rate = nl.size() / sec;
+    cout << label << ": " << sec * 1000 << " ms, " << rate / 1e6 << " M nodes/s (cost " << result << ")" << endl;
+    return rate;
+}
+
+int main(int argc, char *argv[]) {
+    int gates = 10000000;
+    if (argc > 1) gates = atoi(argv[1]);
+
+    vector<BenchNode> nl = generateNetlist(gates);
+    vector<unsigned> cost(nl.size(), 0);
+    cout << "Netlist: " << nl.size() << " nodes" << endl;
+
+    double before = timeSweep("string-keyed", sweepStringKeyed, nl, cost);
+    double after = timeSweep("dense table ", sweepDenseTable, nl, cost);
+    cout << "Speedup: " << after / before << "x" << endl;
+    return 0;
+}
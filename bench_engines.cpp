@@ -0,0 +1,169 @@
+// bench_engines.cpp
+// Runs every engine from engine.h over a set of netlists and tabulates cost,
+// wall time and peak memory. Each run is forked, so a crash or a runaway
+// engine only loses its own entry, and the peak RSS comes from wait4().
+// Costs are compared with a reference engine (default exact): '>' marks a
+// worse cover, '<' a cost below it, which so far has always meant an engine
+// that dropped part of the netlist. The fastest engine that matches the
+// reference everywhere is named at the end.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o bench_engines bench_engines.cpp -lz
+//        (and the stand-alone programs into --bin, e.g. g++ -O2 -o bin/TMC TMC.cpp)
+// Run:   ./bench_engines [--bin DIR] [--timeout SEC] [--engines a,b,...]
+//                        [--reference NAME] netlist...
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "engine.h"
+
+using namespace std;
+
+struct RunStats {
+    int cost = -1;
+    string error;
+    double ms = 0;
+    long maxRssKb = 0;
+};
+
+// Runs one engine on one netlist in a child process
+RunStats measureRun(MapperEngine &engine, const string &netlist, int timeoutSec) {
+    RunStats st;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        st.error = "pipe failed";
+        return st;
+    }
+    auto t0 = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        if (timeoutSec > 0) alarm(timeoutSec);
+        EngineResult r = engine.run(netlist);
+        string msg = to_string(r.cost) + " " + r.error;
+        if (write(fds[1], msg.data(), msg.size()) < 0) _exit(1);
+        _exit(0);
+    }
+    close(fds[1]);
+    string msg;
+    char buf[256];
+    ssize_t k;
+    while ((k = read(fds[0], buf, sizeof(buf))) > 0) msg.append(buf, k);
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage ru;
+    if (pid < 0 || wait4(pid, &status, 0, &ru) < 0) {
+        st.error = "fork failed";
+        return st;
+    }
+    st.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    st.maxRssKb = ru.ru_maxrss;
+    if (WIFSIGNALED(status)) {
+        st.error = WTERMSIG(status) == SIGALRM ? "timeout" : "signal " + to_string(WTERMSIG(status));
+        return st;
+    }
+    istringstream iss(msg);
+    iss >> st.cost;
+    getline(iss >> ws, st.error);
+    if (st.cost < 0 && st.error.empty()) st.error = "failed";
+    return st;
+}
+
+int main(int argc, char *argv[]) {
+    string binDir = ".";
+    int timeoutSec = 60;
+    string only;
+    string reference = "exact";
+    vector<string> netlists;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bin" && i + 1 < argc) binDir = argv[++i];
+        else if (arg == "--timeout" && i + 1 < argc) timeoutSec = atoi(argv[++i]);
+        else if (arg == "--engines" && i + 1 < argc) only = "," + string(argv[++i]) + ",";
+        else if (arg == "--reference" && i + 1 < argc) reference = argv[++i];
+        else netlists.push_back(arg);
+    }
+    if (netlists.empty()) {
+        cerr << "Usage: bench_engines [--bin DIR] [--timeout SEC] [--engines a,b,...] [--reference NAME] netlist..." << endl;
+        return 1;
+    }
+
+    vector<unique_ptr<MapperEngine>> engines = makeEngines(binDir, timeoutSec);
+    vector<MapperEngine *> selected;
+    int ref = -1;
+    for (auto &e : engines) {
+        if (e->name() == reference) ref = (int)selected.size();
+        if (e->name() == reference || only.empty() || only.find("," + e->name() + ",") != string::npos)
+            selected.push_back(e.get());
+    }
+    if (ref < 0) {
+        cerr << "Unknown reference engine '" << reference << "'" << endl;
+        return 1;
+    }
+
+    // results[e][n]
+    vector<vector<RunStats>> results(selected.size(), vector<RunStats>(netlists.size()));
+    for (size_t e = 0; e < selected.size(); e++) {
+        for (size_t n = 0; n < netlists.size(); n++)
+            results[e][n] = measureRun(*selected[e], netlists[n], timeoutSec);
+    }
+    auto mark = [&](size_t e, size_t n) {
+        int c = results[e][n].cost, r = results[ref][n].cost;
+        if (c < 0 || r < 0 || c == r) return ' ';
+        return c < r ? '<' : '>';
+    };
+
+    for (size_t n = 0; n < netlists.size(); n++) {
+        cout << netlists[n] << endl;
+        for (size_t e = 0; e < selected.size(); e++) {
+            const RunStats &st = results[e][n];
+            cout << "  " << left << setw(20) << selected[e]->name() << right;
+            if (st.cost >= 0) cout << setw(8) << st.cost << mark(e, n);
+            else cout << setw(9) << "-";
+            cout << fixed << setprecision(1) << setw(10) << st.ms << " ms" << setw(9) << st.maxRssKb << " KB";
+            if (!st.error.empty()) cout << "  " << st.error;
+            cout << endl;
+        }
+    }
+
+    cout << endl << left << setw(20) << "engine" << right << setw(8) << "match" << setw(8) << "below"
+         << setw(8) << "above" << setw(8) << "failed" << setw(12) << "total ms" << setw(12) << "peak KB" << endl;
+    MapperEngine *promote = nullptr;
+    double promoteMs = 0;
+    for (size_t e = 0; e < selected.size(); e++) {
+        int match = 0, below = 0, above = 0, failed = 0;
+        double ms = 0;
+        long rss = 0;
+        for (size_t n = 0; n < netlists.size(); n++) {
+            const RunStats &st = results[e][n];
+            if (st.cost < 0) failed++;
+            else if (st.cost == results[ref][n].cost) match++;
+            else if (mark(e, n) == '<') below++;
+            else if (mark(e, n) == '>') above++;
+            ms += st.ms;
+            rss = max(rss, st.maxRssKb);
+        }
+        cout << left << setw(20) << selected[e]->name() << right << setw(8) << match << setw(8) << below
+             << setw(8) << above << setw(8) << failed
+             << fixed << setprecision(1) << setw(12) << ms << setw(12) << rss << endl;
+        if (match == (int)netlists.size() && (!promote || ms < promoteMs)) {
+            promote = selected[e];
+            promoteMs = ms;
+        }
+    }
+    cout << endl;
+    if (promote)
+        cout << "Fastest engine matching " << reference << " on every netlist: " << promote->name()
+             << " (" << promote->description() << ")" << endl;
+    else
+        cout << "The reference engine failed on some netlist" << endl;
+    return 0;
+}
@@ -0,0 +1,176 @@
+// bench_layout.cpp
+// Cache behaviour of the mapper under different subject graph layouts.
+// Generates a random NAND2/NOT graph, scatters it into a random topological
+// order (what a hash-map-backed netlist gives you), then maps it three times:
+// scattered, after reorderSubjectGraph(DFS) and after reorderSubjectGraph(LEVEL).
+// L1D and LLC read misses come from perf_event_open; where the kernel has no
+// hardware counters (most VMs) only the times are printed.
+//
+// Build: g++ -std=c++17 -O2 -o bench_layout bench_layout.cpp
+// Run:   ./bench_layout [gates]        (default 50000000, ~4 GB of RAM)
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "mapper.h"
+
+using namespace std;
+
+static const int NUM_INPUTS = 1000;
+
+// One hardware counter for this thread, user space only
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd < 0) error = strerror(errno);
+    }
+    ~PerfCounter() { if (fd >= 0) close(fd); }
+
+    bool ok() const { return fd >= 0; }
+    void start() {
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    uint64_t stop() {
+        if (fd < 0) return 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t v = 0;
+        if (read(fd, &v, sizeof(v)) != sizeof(v)) return 0;
+        return v;
+    }
+
+    string error;
+
+private:
+    int fd = -1;
+};
+
+static uint64_t cacheReadMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Fan-ins come from a window of recent nodes so the graph stays deep; the
+// nodes nobody reads become the outputs
+SubjectGraph generateGraph(int gates) {
+    mt19937 rng(30);
+    SubjectGraph sg;
+    for (int i = 0; i < NUM_INPUTS; i++) sg.addInput(-1);
+    for (int i = 0; i < gates; i++) {
+        int n = sg.size();
+        int window = min(n, 4096);
+        int a = n - 1 - (int)(rng() % window);
+        int b = n - 1 - (int)(rng() % window);
+        if (rng() % 3 == 0 || a == b) sg.addNot(a);
+        else sg.addNand(a, b);
+    }
+    vector<char> read(sg.size(), 0);
+    for (const SgNode &s : sg.nodes) {
+        if (s.in0 >= 0) read[s.in0] = 1;
+        if (s.in1 >= 0) read[s.in1] = 1;
+    }
+    for (int i = NUM_INPUTS; i < sg.size(); i++)
+        if (!read[i]) sg.outputs.push_back(i);
+    sg.strash = {};   // only needed while building
+    return sg;
+}
+
+// Level order with random ties: still topological, but a node's fan-ins end
+// up anywhere in the previous levels
+vector<int> scatteredOrder(const SubjectGraph &sg) {
+    mt19937 rng(418);
+    vector<uint32_t> key(sg.size());
+    for (uint32_t &k : key) k = rng();
+    vector<int> order(sg.size());
+    for (int i = 0; i < sg.size(); i++) order[i] = i;
+    sort(order.begin(), order.end(), [&](int a, int b) {
+        return sg.level[a] != sg.level[b] ? sg.level[a] < sg.level[b] : key[a] < key[b];
+    });
+    return order;
+}
+
+struct Sample {
+    double ms;
+    uint64_t l1Miss;
+    uint64_t llcMiss;
+    int cost;
+};
+
+// Maps the graph once, counting misses over calculateMinimalCost() only
+Sample measure(SubjectGraph &sg, PerfCounter &l1, PerfCounter &llc) {
+    TechnologyMapper tm;
+    tm.graph = move(sg);
+    Sample s;
+    l1.start();
+    llc.start();
+    auto t0 = chrono::steady_clock::now();
+    s.cost = tm.calculateMinimalCost();
+    auto t1 = chrono::steady_clock::now();
+    s.llcMiss = llc.stop();
+    s.l1Miss = l1.stop();
+    s.ms = chrono::duration<double, milli>(t1 - t0).count();
+    sg = move(tm.graph);
+    return s;
+}
+
+void report(const char *label, const Sample &s, const Sample &base, bool counters) {
+    cout << left << setw(10) << label << right << fixed << setprecision(1)
+         << setw(10) << s.ms << " ms";
+    if (counters) {
+        cout << setw(14) << s.l1Miss << " L1D" << setw(12) << s.llcMiss << " LLC";
+        if (&s != &base && base.l1Miss && base.llcMiss)
+            cout << "  (" << 100.0 * s.l1Miss / base.l1Miss << "% / "
+                 << 100.0 * s.llcMiss / base.llcMiss << "% of scattered)";
+    }
+    cout << "  cost " << s.cost << endl;
+}
+
+int main(int argc, char *argv[]) {
+    int gates = 50000000;
+    if (argc > 1) gates = atoi(argv[1]);
+
+    SubjectGraph sg = generateGraph(gates);
+    cout << "Subject graph: " << sg.size() << " nodes, " << sg.outputs.size() << " outputs" << endl;
+
+    PerfCounter l1(PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_L1D));
+    PerfCounter llc(PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_LL));
+    bool counters = l1.ok() && llc.ok();
+    if (!counters) cout << "Hardware counters unavailable (" << (l1.ok() ? llc.error : l1.error) << "), timing only" << endl;
+
+    applyNodeOrder(sg, scatteredOrder(sg));
+    Sample scattered = measure(sg, l1, llc);
+    reorderSubjectGraph(sg, NodeOrder::DFS);
+    Sample dfs = measure(sg, l1, llc);
+    reorderSubjectGraph(sg, NodeOrder::LEVEL);
+    Sample level = measure(sg, l1, llc);
+
+    report("scattered", scattered, scattered, counters);
+    report("dfs", dfs, scattered, counters);
+    report("level", level, scattered, counters);
+    if (dfs.cost != scattered.cost || level.cost != scattered.cost) {
+        cerr << "Error: layouts gave different costs!" << endl;
+        return 1;
+    }
+    return 0;
+}
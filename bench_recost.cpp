@@ -0,0 +1,174 @@
+// bench_recost.cpp
+// Cost-sweep benchmark for match_store.h. Maps a netlist (or a random
+// NAND2/NOT graph) once, stores its matches, then prices a grid of NAND2,
+// NOR2 and AOI21/AOI22 costs two ways: by pattern matching and running the
+// DP again for every point, and by re-costing the stored matches, one cost
+// vector per sweep and then K per sweep (SIMD lanes).
+//
+// Build: g++ -std=c++17 -O2 -mavx2 -o bench_recost bench_recost.cpp -lz
+//        (-mavx512f for 16-lane vectors; without either the lanes are plain loops)
+// Run:   ./bench_recost [gates | netlist.txt] [points]   (default 1000000, 1000)
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+
+#include "mapper.h"
+#include "match_store.h"
+
+using namespace std;
+
+static const int NUM_INPUTS = 1000;
+
+// Same shape as bench_layout.cpp: fan-ins from a window of recent nodes
+SubjectGraph generateGraph(int gates) {
+    mt19937 rng(38);
+    SubjectGraph sg;
+    for (int i = 0; i < NUM_INPUTS; i++) sg.addInput(-1);
+    for (int i = 0; i < gates; i++) {
+        int n = sg.size();
+        int window = min(n, 4096);
+        int a = n - 1 - (int)(rng() % window);
+        int b = n - 1 - (int)(rng() % window);
+        if (rng() % 3 == 0 || a == b) sg.addNot(a);
+        else sg.addNand(a, b);
+    }
+    vector<char> read(sg.size(), 0);
+    for (const SgNode &s : sg.nodes) {
+        if (s.in0 >= 0) read[s.in0] = 1;
+        if (s.in1 >= 0) read[s.in1] = 1;
+    }
+    for (int i = NUM_INPUTS; i < sg.size(); i++)
+        if (!read[i]) sg.outputs.push_back(i);
+    sg.strash = {};
+    return sg;
+}
+
+// What a sweep point cost before: match every node again and run the DP
+int remap(const TechnologyMapper &tm, const CostTable &costs, vector<int> &label) {
+    const SubjectGraph &g = tm.graph;
+    int n = g.size();
+    label.assign(n, 0);
+    for (int i = 0; i < n; i++) {
+        if (tm.fanout[i] == 0 || g.nodes[i].type == GateType::INPUT) continue;
+        Match m[MAX_MATCHES];
+        int k = findMatches(g, tm.fanout, i, m);
+        int best = numeric_limits<int>::max();
+        for (int j = 0; j < k; j++) {
+            int c = costs[(int)m[j].cell];
+            for (int l = 0; l < m[j].numLeaves; l++) {
+                int leaf = m[j].leaves[l];
+                if (tm.uses[leaf] <= 1) c += label[leaf];
+            }
+            best = min(best, c);
+        }
+        label[i] = best;
+    }
+    int total = 0;
+    vector<char> seen(n, 0);
+    for (int o : g.outputs) {
+        if (tm.uses[o] <= 1 && !seen[o]) total += label[o];
+        seen[o] = 1;
+    }
+    for (int i = 0; i < n; i++)
+        if (tm.uses[i] > 1 && g.nodes[i].type != GateType::INPUT) total += label[i];
+    return total;
+}
+
+// Times costLanes<K> over the sweep (whole batches only; with fewer points
+// than K, one batch that repeats them) and checks every lane against the
+// one-vector sweep
+template <int K>
+bool lanesPerSecond(MatchStore &ms, const vector<CostTable> &sweep, double oneMs) {
+    int batches = max<int>(1, (int)sweep.size() / K);
+    vector<CostTable> lanes(batches * K);
+    for (size_t i = 0; i < lanes.size(); i++) lanes[i] = sweep[i % sweep.size()];
+    vector<int> totals(K);
+    auto t0 = chrono::steady_clock::now();
+    for (int b = 0; b < batches; b++) ms.costLanes<K>(&lanes[b * K], totals.data());
+    double ms1 = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() / batches;
+    for (int k = 0; k < K; k++) {
+        if (totals[k] != ms.cost(lanes[(batches - 1) * K + k])) {
+            cerr << "Error: lane " << k << " of K=" << K << " differs" << endl;
+            return false;
+        }
+    }
+    cout << "  K=" << K << ": " << ms1 << " ms per sweep, " << 1000.0 * K / ms1 << " lanes/s ("
+         << oneMs * K / ms1 << "x one at a time)" << endl;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    string arg = argc > 1 ? argv[1] : "1000000";
+    int points = argc > 2 ? atoi(argv[2]) : 1000;
+
+    TechnologyMapper tm;
+    auto t0 = chrono::steady_clock::now();
+    if (!arg.empty() && isdigit((unsigned char)arg[0])) {
+        tm.graph = generateGraph(atoi(arg.c_str()));
+        t0 = chrono::steady_clock::now();
+    } else if (!tm.readNetlist(arg)) {
+        cerr << "Failed to read or parse netlist!" << endl;
+        return 1;
+    }
+    int cost = tm.calculateMinimalCost();
+    double mapMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    MatchStore ms;
+    auto t1 = chrono::steady_clock::now();
+    ms.build(tm);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t1).count();
+    cout << "Subject graph: " << tm.graph.size() << " nodes, mapped in " << mapMs << " ms, cost " << cost << endl;
+    cout << "Match store: " << ms.nodes() << " nodes, " << ms.code.size() << " words (" << ms.bytes() / 1024
+         << " KB), built in " << buildMs << " ms" << endl;
+    if (ms.cost(defaultCostTable()) != cost) {
+        cerr << "Error: stored matches give " << ms.cost(defaultCostTable()) << ", mapper gave " << cost << endl;
+        return 1;
+    }
+
+    // grid over the NAND2, NOR2 and AOI costs, around the library values
+    vector<CostTable> sweep;
+    for (int p = 0; (int)sweep.size() < points; p++) {
+        CostTable c = defaultCostTable();
+        c[(int)GateType::NAND2] = 1 + p % 6;
+        c[(int)GateType::NOR2] = 1 + p / 6 % 6;
+        c[(int)GateType::AOI21] = 2 + p / 36 % 6;
+        c[(int)GateType::AOI22] = c[(int)GateType::AOI21] + 1 + p / 216 % 5;
+        sweep.push_back(c);
+    }
+
+    // the re-match baseline is slow; time it on a sample of the grid
+    int sample = max(1, min(points, 20));
+    vector<int> label;
+    vector<int> expect(sample);
+    auto t2 = chrono::steady_clock::now();
+    for (int p = 0; p < sample; p++) expect[p] = remap(tm, sweep[p * points / sample], label);
+    double remapMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t2).count() / sample;
+
+    auto t3 = chrono::steady_clock::now();
+    long long sum = 0;
+    for (const CostTable &c : sweep) sum += ms.cost(c);
+    double storeMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t3).count() / points;
+
+    for (int p = 0; p < sample; p++) {
+        if (ms.cost(sweep[p * points / sample]) != expect[p]) {
+            cerr << "Error: point " << p * points / sample << " differs from the re-match" << endl;
+            return 1;
+        }
+    }
+    cout << "Re-match:     " << remapMs << " ms per point" << endl;
+    cout << "Match store:  " << storeMs << " ms per point, " << (storeMs > 0 ? 1000.0 / storeMs : 0)
+         << " points/s (" << remapMs / storeMs << "x), mean cost " << sum / points << endl;
+
+    // the same grid with K cost vectors per sweep
+    cout << "Lanes (K cost vectors per sweep):" << endl;
+    if (!lanesPerSecond<1>(ms, sweep, storeMs) || !lanesPerSecond<8>(ms, sweep, storeMs) ||
+        !lanesPerSecond<16>(ms, sweep, storeMs) || !lanesPerSecond<32>(ms, sweep, storeMs) ||
+        !lanesPerSecond<64>(ms, sweep, storeMs))
+        return 1;
+    return 0;
+}
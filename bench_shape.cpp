@@ -0,0 +1,131 @@
+// bench_shape.cpp
+// Microbenchmark for the shape-signature matcher in mapper.h. Generates a
+// random NAND2/NOT graph and lists the cell patterns of every node three
+// ways: with the old if-ladder (kept here as the reference), computing each
+// signature and looking it up, and looking up signatures precomputed the
+// way mapNodes does. All three must find the same matches.
+//
+// Build: g++ -std=c++17 -O2 -o bench_shape bench_shape.cpp
+// Run:   ./bench_shape [gates] [rounds]        (default 5000000, 5)
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "mapper.h"
+
+using namespace std;
+
+static const int NUM_INPUTS = 1000;
+
+SubjectGraph generateGraph(int gates) {
+    mt19937 rng(40);
+    SubjectGraph sg;
+    for (int i = 0; i < NUM_INPUTS; i++) sg.addInput(-1);
+    for (int i = 0; i < gates; i++) {
+        int n = sg.size();
+        int window = min(n, 4096);
+        int a = n - 1 - (int)(rng() % window);
+        int b = n - 1 - (int)(rng() % window);
+        if (rng() % 3 == 0 || a == b) sg.addNot(a);
+        else sg.addNand(a, b);
+    }
+    sg.strash = {};
+    return sg;
+}
+
+// findMatches as it was before the signature table
+int findMatchesLadder(const SubjectGraph &sg, const vector<int> &fanout, int node, Match *out) {
+    const SgNode &n = sg.nodes[node];
+    int k = 0;
+    auto inner = [&](int id, GateType t) { return sg.nodes[id].type == t && fanout[id] == 1; };
+    if (n.type == GateType::NOT) {
+        int c = n.in0;
+        out[k++] = {GateType::NOT, 1, {c}};
+        if (inner(c, GateType::NAND2)) {
+            int x = sg.nodes[c].in0, y = sg.nodes[c].in1;
+            out[k++] = {GateType::AND, 2, {x, y}};
+            if (inner(x, GateType::NOT) && inner(y, GateType::NOT))
+                out[k++] = {GateType::NOR2, 2, {sg.nodes[x].in0, sg.nodes[y].in0}};
+            if (inner(x, GateType::NAND2) && inner(y, GateType::NOT))
+                out[k++] = {GateType::AOI21, 3, {sg.nodes[x].in0, sg.nodes[x].in1, sg.nodes[y].in0}};
+            if (inner(y, GateType::NAND2) && inner(x, GateType::NOT))
+                out[k++] = {GateType::AOI21, 3, {sg.nodes[y].in0, sg.nodes[y].in1, sg.nodes[x].in0}};
+            if (inner(x, GateType::NAND2) && inner(y, GateType::NAND2))
+                out[k++] = {GateType::AOI22, 4, {sg.nodes[x].in0, sg.nodes[x].in1,
+                                                 sg.nodes[y].in0, sg.nodes[y].in1}};
+        }
+    } else if (n.type == GateType::NAND2) {
+        out[k++] = {GateType::NAND2, 2, {n.in0, n.in1}};
+        if (inner(n.in0, GateType::NOT) && inner(n.in1, GateType::NOT))
+            out[k++] = {GateType::OR, 2, {sg.nodes[n.in0].in0, sg.nodes[n.in1].in0}};
+    }
+    return k;
+}
+
+// Folds the matches into a checksum so the work is not optimized away. No
+// chain of multiplies, which would cost more than the matching itself.
+inline uint64_t mix(uint64_t h, const Match *m, int k) {
+    for (int j = 0; j < k; j++) {
+        h += (uint64_t)m[j].cell << (8 * j);
+        for (int l = 0; l < m[j].numLeaves; l++) h += (uint64_t)m[j].leaves[l] << (l + j);
+    }
+    return h;
+}
+
+int main(int argc, char *argv[]) {
+    int gates = argc > 1 ? atoi(argv[1]) : 5000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    SubjectGraph sg = generateGraph(gates);
+    int n = sg.size();
+    vector<int> fanout(n, 0);
+    for (const SgNode &s : sg.nodes) {
+        if (s.in0 >= 0) fanout[s.in0]++;
+        if (s.in1 >= 0) fanout[s.in1]++;
+    }
+    cout << "Subject graph: " << n << " nodes" << endl;
+
+    auto time = [&](const char *label, auto &&match) {
+        uint64_t h = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = NUM_INPUTS; i < n; i++) {
+                Match m[MAX_MATCHES];
+                h = mix(h, m, match(i, m));
+            }
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() / rounds;
+        cout << label << ms << " ms per sweep, " << ms * 1e6 / (n - NUM_INPUTS) << " ns per node" << endl;
+        return h;
+    };
+
+    uint64_t ladder = time("if-ladder:            ", [&](int i, Match *m) {
+        return findMatchesLadder(sg, fanout, i, m);
+    });
+    uint64_t lookup = time("signature + lookup:   ", [&](int i, Match *m) {
+        return findMatches(sg, fanout, i, m);
+    });
+    vector<uint8_t> code, shape(n);
+    auto shapes = [&]() {
+        computeShapeCodes(sg, fanout, code);
+        for (int i = 0; i < n; i++) shape[i] = shapeFromCodes(sg, code, i);
+    };
+    shapes();
+    auto t0 = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) shapes();
+    double sigMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() / rounds;
+    uint64_t pre = time("precomputed lookup:   ", [&](int i, Match *m) {
+        return matchShape(sg, i, shape[i], m);
+    });
+    cout << "signature pass:       " << sigMs << " ms per sweep, " << sigMs * 1e6 / (n - NUM_INPUTS)
+         << " ns per node (" << shapeTable().size() << "-entry table)" << endl;
+
+    if (lookup != ladder || pre != ladder) {
+        cerr << "Error: the matchers disagree!" << endl;
+        return 1;
+    }
+    return 0;
+}
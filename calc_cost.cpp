@@ -1,392 +1,598 @@
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <unordered_map>
-#include <vector>
-#include <memory>
-#include <algorithm>
-#include <limits>
-
-using namespace std;
-
-enum GateType { INPUT, OUTPUT, AND, OR, NOT, NAND, NOR, AOI21, AOI22, UNKNOWN };
-
-struct Node {
-    string name;
-    GateType type;
-    vector<shared_ptr<Node>> children;
-    int minCost = -1; // Cache for minimal cost
-};
-
-string gateTypeToStr(GateType type);
-void parseInput(const string& input_file);
-void printTree(shared_ptr<Node> node, int depth = 0);
-shared_ptr<Node> convertToNandNot(shared_ptr<Node> node);
-int calculateMinCost(shared_ptr<Node> node);
-void writeOutput(int cost, const string& output_file);
-
-unordered_map<string, shared_ptr<Node>> nodes;
-string outputNodeName;
-
-GateType strToGateType(const string& s) {
-    if (s == "INPUT") return INPUT;
-    if (s == "OUTPUT") return OUTPUT;
-    if (s == "AND") return AND;
-    if (s == "OR") return OR;
-    if (s == "NOT") return NOT;
-    if (s == "NAND") return NAND;
-    if (s == "NOR") return NOR;
-    return UNKNOWN;
-}
-
-int main() {
-    parseInput("yuck_file.txt");
-    
-    if (nodes.find("F") == nodes.end()) {
-        cerr << "F node was not constructed correctly." << endl;
-        return 1;
-    }
-    
-    cout << "Original tree:\n";
-    printTree(nodes["F"], 0);
-    
-    cout << "\nConverting to NAND-NOT tree...\n";
-    auto nandTree = convertToNandNot(nodes["F"]);
-    
-    cout << "Printing NAND-NOT tree:\n";
-    printTree(nandTree, 0);
-    
-    int minCost = calculateMinCost(nandTree);
-    cout << "\nMinimal cost: " << minCost << endl;
-    
-    writeOutput(minCost, "output.txt");
-    
-    return 0;
-}
-
-void writeOutput(int cost, const string& output_file) {
-    ofstream file(output_file);
-    if (!file) {
-        cerr << "Could not open output file: " << output_file << endl;
-        exit(1);
-    }
-    file << cost;
-    file.close();
-    cout << "Cost written to " << output_file << endl;
-}
-
-void parseInput(const string& input_file) {
-    ifstream file(input_file);
-    string line;
-
-    if (!file) {
-        cerr << "Could not open input file: " << input_file << endl;
-        exit(1);
-    }
-
-    while (getline(file, line)) {
-        istringstream iss(line);
-        string a, b, c;
-
-        if (!(iss >> a)) continue;
-
-        // Handle input declarations like "a INPUT"
-        if (line.find("INPUT") != string::npos) {
-            nodes[a] = make_shared<Node>(Node{a, INPUT, {}});
-        }
-        // Handle output declaration like "F OUTPUT"
-        else if (line.find("OUTPUT") != string::npos) {
-            outputNodeName = a;
-        }
-        // Handle gate definitions like "t1 = AND b c"
-        else if (line.find('=') != string::npos) {
-            string target, equals, gate, in1, in2;
-            istringstream gateLine(line);
-            gateLine >> target >> equals >> gate >> in1;
-
-            auto newNode = make_shared<Node>();
-            newNode->name = target;
-            newNode->type = strToGateType(gate);
-
-            // Ensure child nodes exist
-            if (nodes.find(in1) == nodes.end())
-                nodes[in1] = make_shared<Node>(Node{in1, INPUT, {}});
-            newNode->children.push_back(nodes[in1]);
-
-            // Try to read second input if present (not for NOT)
-            if (gateLine >> in2) {
-                if (nodes.find(in2) == nodes.end())
-                    nodes[in2] = make_shared<Node>(Node{in2, INPUT, {}});
-                newNode->children.push_back(nodes[in2]);
-            }
-
-            nodes[target] = newNode;
-        }
-    }
-
-    // Make sure "F" is assigned correctly
-    if (!outputNodeName.empty() && nodes.find(outputNodeName) != nodes.end()) {
-        nodes["F"] = nodes[outputNodeName];
-    } else {
-        cerr << "Error: Could not identify or find output node." << endl;
-    }
-
-    cout << "Parsing completed. Total nodes: " << nodes.size() << endl;
-}
-
-// Convert a gate to its NAND-NOT representation
-shared_ptr<Node> convertToNandNot(shared_ptr<Node> node) {
-    if (!node) return nullptr;
-    
-    // Base cases
-    if (node->type == INPUT) {
-        return node;
-    }
-    if (node->type == OUTPUT) {
-        auto convertedChild = convertToNandNot(node->children[0]);
-        auto outputNode = make_shared<Node>();
-        outputNode->name = node->name;
-        outputNode->type = OUTPUT;
-        outputNode->children = {convertedChild};
-        return outputNode;
-    }
-    
-    // Handle direct NAND pattern
-    if (node->type == NAND) {
-        auto childA = convertToNandNot(node->children[0]);
-        auto childB = convertToNandNot(node->children[1]);
-        
-        auto nandNode = make_shared<Node>();
-        nandNode->name = "NAND(" + childA->name + "," + childB->name + ")";
-        nandNode->type = NAND;
-        nandNode->children = {childA, childB};
-        return nandNode;
-    }
-    
-    // Handle direct NOT pattern
-    if (node->type == NOT) {
-        auto child = convertToNandNot(node->children[0]);
-        
-        // Special case: NOT(AND) -> NAND
-        if (node->children[0]->type == AND) {
-            auto childA = convertToNandNot(node->children[0]->children[0]);
-            auto childB = convertToNandNot(node->children[0]->children[1]);
-            
-            auto nandNode = make_shared<Node>();
-            nandNode->name = "NAND(" + childA->name + "," + childB->name + ")";
-            nandNode->type = NAND;
-            nandNode->children = {childA, childB};
-            return nandNode;
-        }
-        
-        // Special case: NOT(OR) -> NAND(NOT, NOT)
-        if (node->children[0]->type == OR) {
-            auto childA = convertToNandNot(node->children[0]->children[0]);
-            auto childB = convertToNandNot(node->children[0]->children[1]);
-            
-            auto notA = make_shared<Node>();
-            notA->name = "NOT(" + childA->name + ")";
-            notA->type = NOT;
-            notA->children = {childA};
-            
-            auto notB = make_shared<Node>();
-            notB->name = "NOT(" + childB->name + ")";
-            notB->type = NOT;
-            notB->children = {childB};
-            
-            auto nandNode = make_shared<Node>();
-            nandNode->name = "NAND(" + notA->name + "," + notB->name + ")";
-            nandNode->type = NAND;
-            nandNode->children = {notA, notB};
-            return nandNode;
-        }
-        
-        // Special case: NOT(NOT(x)) -> x
-        if (node->children[0]->type == NOT) {
-            return convertToNandNot(node->children[0]->children[0]);
-        }
-        
-        // Standard NOT
-        auto notNode = make_shared<Node>();
-        notNode->name = "NOT(" + child->name + ")";
-        notNode->type = NOT;
-        notNode->children = {child};
-        return notNode;
-    }
-    
-    // Handle AND -> NOT(NAND)
-    if (node->type == AND) {
-        auto childA = convertToNandNot(node->children[0]);
-        auto childB = convertToNandNot(node->children[1]);
-        
-        auto nandNode = make_shared<Node>();
-        nandNode->name = "NAND(" + childA->name + "," + childB->name + ")";
-        nandNode->type = NAND;
-        nandNode->children = {childA, childB};
-        
-        auto notNode = make_shared<Node>();
-        notNode->name = "NOT(" + nandNode->name + ")";
-        notNode->type = NOT;
-        notNode->children = {nandNode};
-        return notNode;
-    }
-    
-    // Handle OR -> NAND(NOT, NOT)
-    if (node->type == OR) {
-        auto childA = convertToNandNot(node->children[0]);
-        auto childB = convertToNandNot(node->children[1]);
-        
-        auto notA = make_shared<Node>();
-        notA->name = "NOT(" + childA->name + ")";
-        notA->type = NOT;
-        notA->children = {childA};
-        
-        auto notB = make_shared<Node>();
-        notB->name = "NOT(" + childB->name + ")";
-        notB->type = NOT;
-        notB->children = {childB};
-        
-        auto nandNode = make_shared<Node>();
-        nandNode->name = "NAND(" + notA->name + "," + notB->name + ")";
-        nandNode->type = NAND;
-        nandNode->children = {notA, notB};
-        return nandNode;
-    }
-    
-    // Handle NOR -> NOT(OR) -> NOT(NAND(NOT, NOT))
-    if (node->type == NOR) {
-        auto childA = convertToNandNot(node->children[0]);
-        auto childB = convertToNandNot(node->children[1]);
-        
-        auto notA = make_shared<Node>();
-        notA->name = "NOT(" + childA->name + ")";
-        notA->type = NOT;
-        notA->children = {childA};
-        
-        auto notB = make_shared<Node>();
-        notB->name = "NOT(" + childB->name + ")";
-        notB->type = NOT;
-        notB->children = {childB};
-        
-        auto nandNode = make_shared<Node>();
-        nandNode->name = "NAND(" + notA->name + "," + notB->name + ")";
-        nandNode->type = NAND;
-        nandNode->children = {notA, notB};
-        
-        auto notNode = make_shared<Node>();
-        notNode->name = "NOT(" + nandNode->name + ")";
-        notNode->type = NOT;
-        notNode->children = {nandNode};
-        return notNode;
-    }
-    
-    cerr << "Unsupported gate type during conversion: " << node->name << endl;
-    return nullptr;
-}
-
-// Calculate the minimal cost by considering all technology options
-int calculateMinCost(shared_ptr<Node> node) {
-    if (!node) return 0;
-    
-    // If cost is already calculated, return it
-    if (node->minCost != -1) return node->minCost;
-    
-    // Base case: input nodes have cost 0
-    if (node->type == INPUT) {
-        node->minCost = 0;
-        return 0;
-    }
-    
-    // For OUTPUT, the cost is the cost of its child
-    if (node->type == OUTPUT) {
-        node->minCost = calculateMinCost(node->children[0]);
-        return node->minCost;
-    }
-    
-    // Calculate minimal costs for all children
-    for (auto& child : node->children) {
-        calculateMinCost(child);
-    }
-    
-    // Now consider different ways to implement this node
-    int minCost = numeric_limits<int>::max();
-    
-    // Identify the pattern at this node
-    if (node->type == NOT) {
-        // 1. Use NOT gate directly (cost = 2)
-        minCost = 2 + node->children[0]->minCost;
-    }
-    else if (node->type == NAND && node->children.size() == 2) {
-        // 1. Use NAND2 directly (cost = 3)
-        int nandCost = 3 + node->children[0]->minCost + node->children[1]->minCost;
-        minCost = min(minCost, nandCost);
-        
-        // Check for AOI21 pattern: NAND(a, NAND(b, c))
-        if (node->children[1]->type == NAND && node->children[1]->children.size() == 2) {
-            int aoi21Cost = 7 + node->children[0]->minCost + 
-                            node->children[1]->children[0]->minCost + 
-                            node->children[1]->children[1]->minCost;
-            minCost = min(minCost, aoi21Cost);
-        }
-        
-        // Check for AOI21 pattern: NAND(NAND(a, b), c)
-        if (node->children[0]->type == NAND && node->children[0]->children.size() == 2) {
-            int aoi21Cost = 7 + node->children[1]->minCost + 
-                            node->children[0]->children[0]->minCost + 
-                            node->children[0]->children[1]->minCost;
-            minCost = min(minCost, aoi21Cost);
-        }
-        
-        // Check for AOI22 pattern: NAND(NAND(a, b), NAND(c, d))
-        if (node->children[0]->type == NAND && node->children[0]->children.size() == 2 &&
-            node->children[1]->type == NAND && node->children[1]->children.size() == 2) {
-            int aoi22Cost = 7 + node->children[0]->children[0]->minCost + 
-                            node->children[0]->children[1]->minCost +
-                            node->children[1]->children[0]->minCost + 
-                            node->children[1]->children[1]->minCost;
-            minCost = min(minCost, aoi22Cost);
-        }
-    }
-    else {
-        // Fallback for any other pattern
-        if (node->type == NAND) {
-            minCost = 3; // NAND2 cost
-        } else {
-            minCost = 2; // Default to NOT cost
-        }
-        
-        // Add children costs
-        for (auto& child : node->children) {
-            minCost += child->minCost;
-        }
-    }
-    
-    node->minCost = minCost;
-    return minCost;
-}
-
-void printTree(shared_ptr<Node> node, int depth) {
-    if (!node) return;
-
-    for (int i = 0; i < depth; ++i) cout << "  ";
-    cout << node->name << " [" << gateTypeToStr(node->type) << "]" << endl;
-
-    for (auto child : node->children) {
-        printTree(child, depth + 1);
-    }
-}
-
-string gateTypeToStr(GateType type) {
-    switch(type) {
-        case INPUT: return "INPUT";
-        case OUTPUT: return "OUTPUT";
-        case AND: return "AND";
-        case OR: return "OR";
-        case NOT: return "NOT";
-        case NAND: return "NAND";
-        case NOR: return "NOR";
-        case AOI21: return "AOI21";
-        case AOI22: return "AOI22";
-        default: return "UNKNOWN";
-    }
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <set>
+
+#include "cell_library.h"
+#include "netlist.h"
+
+using namespace std;
+
+struct Node {
+    string name;
+    GateType type;
+    vector<shared_ptr<Node>> children;
+    int minCost = -1; // Cache for minimal cost
+    int fanout = 0;           // readers in the NAND-NOT graph
+    bool duplicate = false;   // shared, but rebuilt by each reader instead
+    vector<shared_ptr<Node>> leaves;   // nodes the chosen cell reads
+    int dups = 0;             // shared nodes the chosen cell absorbs
+};
+
+// A primary input (or a signal read before it is defined)
+static shared_ptr<Node> makeInput(const string &name) {
+    auto n = make_shared<Node>();
+    n->name = name;
+    n->type = GateType::INPUT;
+    return n;
+}
+
+void parseInput(const string& input_file);
+void printTree(shared_ptr<Node> node, int depth = 0);
+shared_ptr<Node> convertToNandNot(shared_ptr<Node> node);
+shared_ptr<Node> convertGate(shared_ptr<Node> node);
+vector<shared_ptr<Node>> countFanout(shared_ptr<Node> root);
+int calculateMinCost(shared_ptr<Node> node);
+int chooseDuplication(shared_ptr<Node> root, const vector<shared_ptr<Node>>& graph, int& dups);
+void writeOutput(int cost, const string& output_file);
+
+unordered_map<string, shared_ptr<Node>> nodes;
+string outputNodeName;
+unordered_map<Node*, shared_ptr<Node>> converted;   // so shared gates stay shared
+
+int main(int argc, char* argv[]) {
+    string inputFile = argc > 1 ? argv[1] : "yuck_file.txt";
+    string outputFile = argc > 2 ? argv[2] : "output.txt";
+    // convertToNandNot() has no visited set and would never return on a loop
+    if (reportFileLoops(inputFile) > 0) return 1;
+    parseInput(inputFile);
+    
+    if (nodes.find("F") == nodes.end()) {
+        cerr << "F node was not constructed correctly." << endl;
+        return 1;
+    }
+    
+    cout << "Original tree:\n";
+    printTree(nodes["F"], 0);
+    
+    cout << "\nConverting to NAND-NOT tree...\n";
+    auto nandTree = convertToNandNot(nodes["F"]);
+    
+    cout << "Printing NAND-NOT tree:\n";
+    printTree(nandTree, 0);
+    
+    vector<shared_ptr<Node>> graph = countFanout(nandTree);
+    int dups = 0;
+    int minCost = chooseDuplication(nandTree, graph, dups);
+    cout << "\nMinimal cost: " << minCost << endl;
+    cout << "Duplicated shared nodes: " << dups << endl;
+    
+    writeOutput(minCost, outputFile);
+    
+    return 0;
+}
+
+void writeOutput(int cost, const string& output_file) {
+    ofstream file(output_file);
+    if (!file) {
+        cerr << "Could not open output file: " << output_file << endl;
+        exit(1);
+    }
+    file << cost;
+    file.close();
+    cout << "Cost written to " << output_file << endl;
+}
+
+void parseInput(const string& input_file) {
+    ifstream file(input_file);
+    string line;
+
+    if (!file) {
+        cerr << "Could not open input file: " << input_file << endl;
+        exit(1);
+    }
+
+    while (getline(file, line)) {
+        istringstream iss(line);
+        string a, b, c;
+
+        if (!(iss >> a)) continue;
+
+        // Handle input declarations like "a INPUT"
+        if (line.find("INPUT") != string::npos) {
+            nodes[a] = makeInput(a);
+        }
+        // Handle output declaration like "F OUTPUT"
+        else if (line.find("OUTPUT") != string::npos) {
+            outputNodeName = a;
+        }
+        // Handle gate definitions like "t1 = AND b c"
+        else if (line.find('=') != string::npos) {
+            string target, equals, gate, in1, in2;
+            istringstream gateLine(line);
+            gateLine >> target >> equals >> gate >> in1;
+
+            auto newNode = make_shared<Node>();
+            newNode->name = target;
+            newNode->type = parseGateType(gate);
+
+            // Ensure child nodes exist
+            if (nodes.find(in1) == nodes.end())
+                nodes[in1] = makeInput(in1);
+            newNode->children.push_back(nodes[in1]);
+
+            // Try to read second input if present (not for NOT)
+            if (gateLine >> in2) {
+                if (nodes.find(in2) == nodes.end())
+                    nodes[in2] = makeInput(in2);
+                newNode->children.push_back(nodes[in2]);
+            }
+
+            nodes[target] = newNode;
+        }
+    }
+
+    // Make sure "F" is assigned correctly
+    if (!outputNodeName.empty() && nodes.find(outputNodeName) != nodes.end()) {
+        nodes["F"] = nodes[outputNodeName];
+    } else {
+        cerr << "Error: Could not identify or find output node." << endl;
+    }
+
+    cout << "Parsing completed. Total nodes: " << nodes.size() << endl;
+}
+
+// Convert a gate to its NAND-NOT representation, once per gate
+shared_ptr<Node> convertToNandNot(shared_ptr<Node> node) {
+    if (!node) return nullptr;
+    auto it = converted.find(node.get());
+    if (it != converted.end()) return it->second;
+    auto result = convertGate(node);
+    converted[node.get()] = result;
+    return result;
+}
+
+shared_ptr<Node> convertGate(shared_ptr<Node> node) {
+    
+    // Base cases
+    if (node->type == GateType::INPUT) {
+        return node;
+    }
+    if (node->type == GateType::OUTPUT) {
+        auto convertedChild = convertToNandNot(node->children[0]);
+        auto outputNode = make_shared<Node>();
+        outputNode->name = node->name;
+        outputNode->type = GateType::OUTPUT;
+        outputNode->children = {convertedChild};
+        return outputNode;
+    }
+    
+    // Handle direct NAND pattern
+    if (node->type == GateType::NAND2) {
+        auto childA = convertToNandNot(node->children[0]);
+        auto childB = convertToNandNot(node->children[1]);
+        
+        auto nandNode = make_shared<Node>();
+        nandNode->name = "NAND(" + childA->name + "," + childB->name + ")";
+        nandNode->type = GateType::NAND2;
+        nandNode->children = {childA, childB};
+        return nandNode;
+    }
+    
+    // Handle direct NOT pattern
+    if (node->type == GateType::NOT) {
+        auto child = convertToNandNot(node->children[0]);
+        
+        // Special case: NOT(AND) -> NAND
+        if (node->children[0]->type == GateType::AND) {
+            auto childA = convertToNandNot(node->children[0]->children[0]);
+            auto childB = convertToNandNot(node->children[0]->children[1]);
+            
+            auto nandNode = make_shared<Node>();
+            nandNode->name = "NAND(" + childA->name + "," + childB->name + ")";
+            nandNode->type = GateType::NAND2;
+            nandNode->children = {childA, childB};
+            return nandNode;
+        }
+        
+        // Special case: NOT(OR) -> NAND(NOT, NOT)
+        if (node->children[0]->type == GateType::OR) {
+            auto childA = convertToNandNot(node->children[0]->children[0]);
+            auto childB = convertToNandNot(node->children[0]->children[1]);
+            
+            auto notA = make_shared<Node>();
+            notA->name = "NOT(" + childA->name + ")";
+            notA->type = GateType::NOT;
+            notA->children = {childA};
+            
+            auto notB = make_shared<Node>();
+            notB->name = "NOT(" + childB->name + ")";
+            notB->type = GateType::NOT;
+            notB->children = {childB};
+            
+            auto nandNode = make_shared<Node>();
+            nandNode->name = "NAND(" + notA->name + "," + notB->name + ")";
+            nandNode->type = GateType::NAND2;
+            nandNode->children = {notA, notB};
+            return nandNode;
+        }
+        
+        // Special case: NOT(NOT(x)) -> x
+        if (node->children[0]->type == GateType::NOT) {
+            return convertToNandNot(node->children[0]->children[0]);
+        }
+        
+        // Standard NOT
+        auto notNode = make_shared<Node>();
+        notNode->name = "NOT(" + child->name + ")";
+        notNode->type = GateType::NOT;
+        notNode->children = {child};
+        return notNode;
+    }
+    
+    // Handle AND -> NOT(NAND)
+    if (node->type == GateType::AND) {
+        auto childA = convertToNandNot(node->children[0]);
+        auto childB = convertToNandNot(node->children[1]);
+        
+        auto nandNode = make_shared<Node>();
+        nandNode->name = "NAND(" + childA->name + "," + childB->name + ")";
+        nandNode->type = GateType::NAND2;
+        nandNode->children = {childA, childB};
+        
+        auto notNode = make_shared<Node>();
+        notNode->name = "NOT(" + nandNode->name + ")";
+        notNode->type = GateType::NOT;
+        notNode->children = {nandNode};
+        return notNode;
+    }
+    
+    // Handle OR -> NAND(NOT, NOT)
+    if (node->type == GateType::OR) {
+        auto childA = convertToNandNot(node->children[0]);
+        auto childB = convertToNandNot(node->children[1]);
+        
+        auto notA = make_shared<Node>();
+        notA->name = "NOT(" + childA->name + ")";
+        notA->type = GateType::NOT;
+        notA->children = {childA};
+        
+        auto notB = make_shared<Node>();
+        notB->name = "NOT(" + childB->name + ")";
+        notB->type = GateType::NOT;
+        notB->children = {childB};
+        
+        auto nandNode = make_shared<Node>();
+        nandNode->name = "NAND(" + notA->name + "," + notB->name + ")";
+        nandNode->type = GateType::NAND2;
+        nandNode->children = {notA, notB};
+        return nandNode;
+    }
+    
+    // Handle NOR -> NOT(OR) -> NOT(NAND(NOT, NOT))
+    if (node->type == GateType::NOR2) {
+        auto childA = convertToNandNot(node->children[0]);
+        auto childB = convertToNandNot(node->children[1]);
+        
+        auto notA = make_shared<Node>();
+        notA->name = "NOT(" + childA->name + ")";
+        notA->type = GateType::NOT;
+        notA->children = {childA};
+        
+        auto notB = make_shared<Node>();
+        notB->name = "NOT(" + childB->name + ")";
+        notB->type = GateType::NOT;
+        notB->children = {childB};
+        
+        auto nandNode = make_shared<Node>();
+        nandNode->name = "NAND(" + notA->name + "," + notB->name + ")";
+        nandNode->type = GateType::NAND2;
+        nandNode->children = {notA, notB};
+        
+        auto notNode = make_shared<Node>();
+        notNode->name = "NOT(" + nandNode->name + ")";
+        notNode->type = GateType::NOT;
+        notNode->children = {nandNode};
+        return notNode;
+    }
+    
+    cerr << "Unsupported gate type during conversion: " << node->name << endl;
+    return nullptr;
+}
+
+// Counts the readers of every node of the NAND-NOT graph once, and returns
+// its nodes
+vector<shared_ptr<Node>> countFanout(shared_ptr<Node> root) {
+    vector<shared_ptr<Node>> graph;
+    if (!root) return graph;
+    unordered_map<Node*, bool> seen;
+    vector<shared_ptr<Node>> stack = {root};
+    root->fanout++;
+    seen[root.get()] = true;
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        graph.push_back(node);
+        for (auto& child : node->children) {
+            child->fanout++;
+            if (seen[child.get()]) continue;
+            seen[child.get()] = true;
+            stack.push_back(child);
+        }
+    }
+    return graph;
+}
+
+// A node with more than one reader is built once on its own, unless it is
+// marked to be duplicated into its readers
+bool isShared(const shared_ptr<Node>& node) {
+    return node->fanout > 1 && !node->duplicate;
+}
+
+// Cost a cell pays for reading a node; shared nodes are paid for once in
+// coverCost()
+int leafCost(const shared_ptr<Node>& node) {
+    int cost = calculateMinCost(node);
+    return isShared(node) ? 0 : cost;
+}
+
+// Calculate the minimal cost by considering all technology options
+int calculateMinCost(shared_ptr<Node> node) {
+    if (!node) return 0;
+    
+    // If cost is already calculated, return it
+    if (node->minCost != -1) return node->minCost;
+    
+    // Base case: input nodes have cost 0
+    if (node->type == GateType::INPUT) {
+        node->minCost = 0;
+        return 0;
+    }
+    
+    // For OUTPUT, the cost is the cost of its child
+    if (node->type == GateType::OUTPUT) {
+        node->minCost = leafCost(node->children[0]);
+        node->leaves = node->children;
+        return node->minCost;
+    }
+    
+    // Calculate minimal costs for all children
+    for (auto& child : node->children) {
+        calculateMinCost(child);
+    }
+    
+    // Now consider different ways to implement this node
+    int minCost = numeric_limits<int>::max();
+    vector<shared_ptr<Node>> leaves = node->children;
+    int dups = 0;
+    
+    // A pattern that absorbs a node with other readers duplicates it. While
+    // that node is still built on its own, the pattern has to beat the plain
+    // NAND2, which reads it for free.
+    auto consider = [&](int cost, vector<shared_ptr<Node>> patternLeaves, vector<shared_ptr<Node>> absorbed) {
+        int d = 0;
+        for (auto& a : absorbed) {
+            if (a->fanout > 1) d++;
+            if (isShared(a)) return;
+        }
+        if (cost < minCost) {
+            minCost = cost;
+            leaves = patternLeaves;
+            dups = d;
+        }
+    };
+    
+    // Identify the pattern at this node
+    if (node->type == GateType::NOT) {
+        // 1. Use NOT gate directly (cost = 2)
+        minCost = NOT_COST + leafCost(node->children[0]);
+    }
+    else if (node->type == GateType::NAND2 && node->children.size() == 2) {
+        auto& c0 = node->children[0];
+        auto& c1 = node->children[1];
+        
+        // 1. Use NAND2 directly (cost = 3)
+        int nandCost = NAND2_COST + leafCost(c0) + leafCost(c1);
+        minCost = min(minCost, nandCost);
+        
+        // Check for AOI21 pattern: NAND(a, NAND(b, c))
+        if (c1->type == GateType::NAND2 && c1->children.size() == 2) {
+            int aoi21Cost = AOI21_COST + leafCost(c0) + 
+                            leafCost(c1->children[0]) + 
+                            leafCost(c1->children[1]);
+            consider(aoi21Cost, {c0, c1->children[0], c1->children[1]}, {c1});
+        }
+        
+        // Check for AOI21 pattern: NAND(NAND(a, b), c)
+        if (c0->type == GateType::NAND2 && c0->children.size() == 2) {
+            int aoi21Cost = AOI21_COST + leafCost(c1) + 
+                            leafCost(c0->children[0]) + 
+                            leafCost(c0->children[1]);
+            consider(aoi21Cost, {c1, c0->children[0], c0->children[1]}, {c0});
+        }
+        
+        // Check for AOI22 pattern: NAND(NAND(a, b), NAND(c, d))
+        if (c0->type == GateType::NAND2 && c0->children.size() == 2 &&
+            c1->type == GateType::NAND2 && c1->children.size() == 2) {
+            int aoi22Cost = AOI22_COST + leafCost(c0->children[0]) + 
+                            leafCost(c0->children[1]) +
+                            leafCost(c1->children[0]) + 
+                            leafCost(c1->children[1]);
+            consider(aoi22Cost, {c0->children[0], c0->children[1], c1->children[0], c1->children[1]}, {c0, c1});
+        }
+    }
+    else {
+        // Fallback for any other pattern
+        if (node->type == GateType::NAND2) {
+            minCost = NAND2_COST;
+        } else {
+            minCost = NOT_COST; // Default to NOT cost
+        }
+        
+        // Add children costs
+        for (auto& child : node->children) {
+            minCost += leafCost(child);
+        }
+    }
+    
+    node->minCost = minCost;
+    node->leaves = leaves;
+    node->dups = dups;
+    return minCost;
+}
+
+// Total cost of the cover: the root's tree plus, once each, every shared
+// node the chosen cells read. A shared node that all its readers absorb is
+// not built on its own. dups counts the cells that duplicate one.
+int coverCost(shared_ptr<Node> root, const vector<shared_ptr<Node>>& graph, int& dups) {
+    for (auto& node : graph) node->minCost = -1;
+    int total = calculateMinCost(root);
+    dups = 0;
+    unordered_map<Node*, bool> seen;
+    vector<shared_ptr<Node>> stack = {root};
+    seen[root.get()] = true;
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        dups += node->dups;
+        for (auto& leaf : node->leaves) {
+            if (seen[leaf.get()]) continue;
+            seen[leaf.get()] = true;
+            if (isShared(leaf)) total += leaf->minCost;
+            stack.push_back(leaf);
+        }
+    }
+    return total;
+}
+
+// Nodes whose patterns read the cost or check the sharing of a node up to
+// this many levels below them (NAND(a, NAND(b, c)) reads b and c)
+static const int PATTERN_DEPTH = 2;
+
+// The NAND-NOT graph in topological order (children first), with the
+// readers of each node as indices into it
+struct GraphOrder {
+    vector<shared_ptr<Node>> nodes;
+    vector<vector<int>> readers;
+};
+
+GraphOrder graphOrder(shared_ptr<Node> root) {
+    GraphOrder order;
+    unordered_map<Node*, int> index;
+    vector<pair<shared_ptr<Node>, size_t>> stack = {{root, 0}};
+    index[root.get()] = -1;
+    while (!stack.empty()) {
+        shared_ptr<Node> node = stack.back().first;
+        size_t& next = stack.back().second;
+        if (next < node->children.size()) {
+            shared_ptr<Node> child = node->children[next++];
+            if (index.emplace(child.get(), -1).second) stack.push_back({child, 0});
+            continue;
+        }
+        index[node.get()] = order.nodes.size();
+        order.nodes.push_back(node);
+        stack.pop_back();
+    }
+    order.readers.resize(order.nodes.size());
+    for (size_t i = 0; i < order.nodes.size(); i++) {
+        for (auto& child : order.nodes[i]->children) order.readers[index.at(child.get())].push_back(i);
+    }
+    return order;
+}
+
+// Adds the readers of node i, up to PATTERN_DEPTH levels up, to dirty
+void addReaders(const GraphOrder& order, int i, set<int>& dirty) {
+    vector<int> level = {i}, next;
+    for (int d = 0; d < PATTERN_DEPTH && !level.empty(); d++) {
+        next.clear();
+        for (int v : level) {
+            for (int r : order.readers[v]) {
+                if (dirty.insert(r).second) next.push_back(r);
+            }
+        }
+        level.swap(next);
+    }
+}
+
+// Decides while costing, bottom-up, whether each shared node is built once
+// or duplicated into its readers. Duplicating one re-costs only the readers
+// above it, up to the nearest shared nodes, and is kept when their change
+// undercuts building the node once. One full costing then checks the
+// result against the cover with nothing duplicated.
+int chooseDuplication(shared_ptr<Node> root, const vector<shared_ptr<Node>>& graph, int& dups) {
+    if (!root) return 0;
+    int base = coverCost(root, graph, dups);
+    GraphOrder order = graphOrder(root);
+    int n = order.nodes.size();
+
+    struct Saved {
+        Node* node;
+        int minCost;
+        vector<shared_ptr<Node>> leaves;
+        int dups;
+    };
+    for (int s = 0; s < n; s++) {
+        const shared_ptr<Node>& shared = order.nodes[s];
+        if (shared->fanout < 2 || shared == root) continue;
+        // built once, it is paid for once if a reader's cell reads it
+        bool built = false;
+        for (int r : order.readers[s]) {
+            const vector<shared_ptr<Node>>& leaves = order.nodes[r]->leaves;
+            built = built || find(leaves.begin(), leaves.end(), shared) != leaves.end();
+        }
+        shared->duplicate = true;
+        int delta = built ? -shared->minCost : 0;
+        vector<Saved> saved;
+        set<int> dirty;
+        addReaders(order, s, dirty);
+        // in topological order, so every node is re-costed once, after its children
+        while (!dirty.empty()) {
+            int i = *dirty.begin();
+            dirty.erase(dirty.begin());
+            Node* node = order.nodes[i].get();
+            saved.push_back({node, node->minCost, node->leaves, node->dups});
+            node->minCost = -1;
+            int cost = calculateMinCost(order.nodes[i]);
+            if (cost == saved.back().minCost) continue;
+            // a shared node's readers read it for free; past it, only the
+            // total changes
+            if (isShared(order.nodes[i]) || order.nodes[i] == root) {
+                delta += cost - saved.back().minCost;
+            } else {
+                addReaders(order, i, dirty);
+            }
+        }
+        if (delta < 0) continue;
+        shared->duplicate = false;
+        for (auto it = saved.rbegin(); it != saved.rend(); ++it) {
+            it->node->minCost = it->minCost;
+            it->node->leaves = it->leaves;
+            it->node->dups = it->dups;
+        }
+    }
+    int d = 0;
+    int cost = coverCost(root, graph, d);
+    if (cost <= base) {
+        dups = d;
+        return cost;
+    }
+    // the local estimates missed a change further up: duplicate nothing
+    for (auto& node : graph) node->duplicate = false;
+    return coverCost(root, graph, dups);
+}
+
+void printTree(shared_ptr<Node> node, int depth) {
+    if (!node) return;
+
+    for (int i = 0; i < depth; ++i) cout << "  ";
+    cout << node->name << " [" << gateTypeName(node->type) << "]" << endl;
+
+    for (auto child : node->children) {
+        printTree(child, depth + 1);
+    }
 }
\ No newline at end of file
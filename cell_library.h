@@ -0,0 +1,118 @@
+// cell_library.h
+// Gate types and the technology table shared by every mapper in this folder.
+#ifndef CELL_LIBRARY_H
+#define CELL_LIBRARY_H
+
+#include <cstdint>
+#include <string>
+
+// Every gate/cell the mappers know about. The value doubles as the index into
+// the cost and delay tables below, so keep COUNT last.
+enum class GateType : uint8_t {
+    AND,
+    OR,
+    NOT,
+    INPUT,
+    OUTPUT,
+    NAND2,
+    NOR2,
+    AOI21,
+    AOI22,
+    CONST0,
+    CONST1,
+    UNKNOWN,
+    COUNT
+};
+
+static constexpr int GATE_TYPE_COUNT = static_cast<int>(GateType::COUNT);
+
+// Area cost of each type when it is implemented as one cell of the technology
+// table (AND/OR as AND2/OR2). INPUT, OUTPUT, the tie-offs and UNKNOWN are free.
+static constexpr int CELL_COST[GATE_TYPE_COUNT] = {
+    4,  // AND2
+    4,  // OR2
+    2,  // NOT
+    0,  // INPUT
+    0,  // OUTPUT
+    3,  // NAND2
+    6,  // NOR2
+    7,  // AOI21
+    7,  // AOI22
+    0,  // CONST0
+    0,  // CONST1
+    0   // UNKNOWN
+};
+
+// Intrinsic delay of each cell in unit gate delays. The technology table only
+// gives areas, so these follow the usual inverter = 1 convention.
+static constexpr int CELL_DELAY[GATE_TYPE_COUNT] = {
+    2,  // AND2
+    2,  // OR2
+    1,  // NOT
+    0,  // INPUT
+    0,  // OUTPUT
+    1,  // NAND2
+    2,  // NOR2
+    2,  // AOI21
+    2,  // AOI22
+    0,  // CONST0
+    0,  // CONST1
+    0   // UNKNOWN
+};
+
+inline constexpr int cellCost(GateType t) { return CELL_COST[static_cast<int>(t)]; }
+inline constexpr int cellDelay(GateType t) { return CELL_DELAY[static_cast<int>(t)]; }
+
+// Fingerprint of the cost and delay tables. Anything derived from the library
+// and kept on disk (npn4.db, the result cache) stores it to notice changes.
+inline constexpr uint64_t cellLibraryHash() {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int t = 0; t < GATE_TYPE_COUNT; t++) {
+        h = (h ^ (uint64_t)CELL_COST[t]) * 0x100000001b3ull;
+        h = (h ^ (uint64_t)CELL_DELAY[t]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Named costs kept for the pattern code in the individual mappers
+static constexpr int NOT_COST   = cellCost(GateType::NOT);
+static constexpr int NAND2_COST = cellCost(GateType::NAND2);
+static constexpr int AND2_COST  = cellCost(GateType::AND);
+static constexpr int NOR2_COST  = cellCost(GateType::NOR2);
+static constexpr int OR2_COST   = cellCost(GateType::OR);
+static constexpr int AOI21_COST = cellCost(GateType::AOI21);
+static constexpr int AOI22_COST = cellCost(GateType::AOI22);
+
+// Converts a netlist keyword to its gate type ("NAND"/"NOR" are accepted as
+// the 2-input cells)
+inline GateType parseGateType(const std::string &s) {
+    if (s == "AND") return GateType::AND;
+    if (s == "OR") return GateType::OR;
+    if (s == "NOT") return GateType::NOT;
+    if (s == "INPUT") return GateType::INPUT;
+    if (s == "OUTPUT") return GateType::OUTPUT;
+    if (s == "NAND2" || s == "NAND") return GateType::NAND2;
+    if (s == "NOR2" || s == "NOR") return GateType::NOR2;
+    if (s == "AOI21") return GateType::AOI21;
+    if (s == "AOI22") return GateType::AOI22;
+    return GateType::UNKNOWN;
+}
+
+inline const char *gateTypeName(GateType t) {
+    switch (t) {
+        case GateType::AND: return "AND";
+        case GateType::OR: return "OR";
+        case GateType::NOT: return "NOT";
+        case GateType::INPUT: return "INPUT";
+        case GateType::OUTPUT: return "OUTPUT";
+        case GateType::NAND2: return "NAND2";
+        case GateType::NOR2: return "NOR2";
+        case GateType::AOI21: return "AOI21";
+        case GateType::AOI22: return "AOI22";
+        case GateType::CONST0: return "CONST0";
+        case GateType::CONST1: return "CONST1";
+        default: return "UNKNOWN";
+    }
+}
+
+#endif
@@ -0,0 +1,418 @@
+// compressed_input.h
+// Reads a netlist file that may be compressed, decompressing as it goes so
+// that only a bounded window of the text is ever in memory. The format comes
+// from the first bytes, not the file name:
+//   gzip       one stream through zlib (concatenated members included)
+//   BGZF       gzip made of independent blocks that record their own size
+//              (bgzip, samtools); a window of blocks is inflated in parallel
+//   zstd       frames found one by one and decompressed in parallel; needs a
+//              build with -DTECH_MAP_ZSTD -lzstd. A frame too large for the
+//              window is decompressed as a stream instead.
+// Link with -lz.
+//
+//   InputFile in;
+//   if (!in.open(fname)) ...
+//   while (size_t n = in.read(buf, sizeof buf)) ...
+//   if (!in.error.empty()) ...         // corrupt or truncated data
+#ifndef COMPRESSED_INPUT_H
+#define COMPRESSED_INPUT_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include <zlib.h>
+#ifdef TECH_MAP_ZSTD
+#include <zstd.h>
+#endif
+
+#include "netlist.h"
+
+static const size_t INPUT_CHUNK = 1 << 16;          // compressed bytes read at a time
+static const size_t INPUT_WINDOW = 4 << 20;         // compressed bytes decoded per parallel window
+static const size_t INPUT_MAX_UNIT = 8 << 20;       // larger zstd frames are streamed
+
+enum class InputFormat { PLAIN, GZIP, BGZF, ZSTD };
+
+inline const char *inputFormatName(InputFormat f) {
+    switch (f) {
+        case InputFormat::GZIP: return "gzip";
+        case InputFormat::BGZF: return "BGZF";
+        case InputFormat::ZSTD: return "zstd";
+        default: return "plain";
+    }
+}
+
+// Format of fname from its magic bytes (PLAIN if it can't be read)
+inline InputFormat detectInputFormat(const std::string &fname) {
+    std::ifstream f(fname, std::ios::binary);
+    unsigned char h[18] = {};
+    f.read((char *)h, sizeof h);
+    size_t n = (size_t)f.gcount();
+    if (n >= 4 && h[0] == 0x28 && h[1] == 0xB5 && h[2] == 0x2F && h[3] == 0xFD) return InputFormat::ZSTD;
+    if (n < 3 || h[0] != 0x1F || h[1] != 0x8B || h[2] != 8) return InputFormat::PLAIN;
+    // BGZF: FEXTRA with a "BC" subfield first
+    if (n == 18 && (h[3] & 4) && h[12] == 'B' && h[13] == 'C' && h[14] == 2 && h[15] == 0) return InputFormat::BGZF;
+    return InputFormat::GZIP;
+}
+
+class InputFile {
+public:
+    InputFormat format = InputFormat::PLAIN;
+    std::string error;        // set when the data turns out corrupt or truncated
+    int threads = 0;          // decoders per window (0: one per core)
+
+    InputFile() = default;
+    InputFile(const InputFile &) = delete;
+    InputFile &operator=(const InputFile &) = delete;
+
+    ~InputFile() {
+        if (gzipOpen) inflateEnd(&zs);
+#ifdef TECH_MAP_ZSTD
+        if (stream) ZSTD_freeDStream(stream);
+#endif
+    }
+
+    bool open(const std::string &fname) {
+        f.open(fname, std::ios::binary);
+        if (!f.is_open()) {
+            std::cerr << "Failed to open file: " << fname << std::endl;
+            return false;
+        }
+        format = detectInputFormat(fname);
+        if (format == InputFormat::GZIP) {
+            // 32: accept the gzip header
+            if (inflateInit2(&zs, 15 + 32) != Z_OK) return fail("cannot start zlib");
+            gzipOpen = true;
+            in.resize(INPUT_CHUNK);
+        }
+#ifndef TECH_MAP_ZSTD
+        if (format == InputFormat::ZSTD) {
+            std::cerr << fname << ": zstd input needs a build with -DTECH_MAP_ZSTD -lzstd" << std::endl;
+            return false;
+        }
+#endif
+        if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        return true;
+    }
+
+    // Fills buf with up to n bytes of text; returns 0 at the end or on error
+    size_t read(char *buf, size_t n) {
+        if (!error.empty()) return 0;
+        switch (format) {
+            case InputFormat::PLAIN:
+                f.read(buf, n);
+                return (size_t)f.gcount();
+            case InputFormat::GZIP: return readGzip(buf, n);
+            default: return readWindowed(buf, n);
+        }
+    }
+
+private:
+    std::ifstream f;
+    std::vector<char> in;     // compressed bytes not yet consumed
+    size_t inPos = 0, inEnd = 0;
+
+    bool fail(const std::string &msg) {
+        if (error.empty()) error = msg;
+        return false;
+    }
+
+    // Moves the unread compressed bytes to the front and reads more after
+    // them; false at the end of the file
+    bool refill() {
+        if (inPos > 0) {
+            std::memmove(in.data(), in.data() + inPos, inEnd - inPos);
+            inEnd -= inPos;
+            inPos = 0;
+        }
+        if (inEnd == in.size()) in.resize(in.size() * 2);
+        f.read(in.data() + inEnd, in.size() - inEnd);
+        inEnd += (size_t)f.gcount();
+        return f.gcount() > 0;
+    }
+
+    // gzip: one inflate stream, restarted at each new member
+    z_stream zs = {};
+    bool gzipOpen = false;
+    bool memberDone = false;
+
+    size_t readGzip(char *buf, size_t n) {
+        zs.next_out = (Bytef *)buf;
+        zs.avail_out = (uInt)n;
+        while (zs.avail_out > 0) {
+            if (inPos == inEnd) {
+                inPos = inEnd = 0;
+                if (!refill()) {
+                    if (!memberDone) fail("truncated gzip data");
+                    break;
+                }
+            }
+            if (memberDone) {
+                inflateReset(&zs);
+                memberDone = false;
+            }
+            zs.next_in = (Bytef *)in.data() + inPos;
+            zs.avail_in = (uInt)(inEnd - inPos);
+            int r = inflate(&zs, Z_NO_FLUSH);
+            inPos = inEnd - zs.avail_in;
+            if (r == Z_STREAM_END) {
+                memberDone = true;
+            } else if (r != Z_OK && r != Z_BUF_ERROR) {
+                fail(std::string("corrupt gzip data (") + (zs.msg ? zs.msg : "zlib error") + ")");
+                break;
+            }
+        }
+        return n - zs.avail_out;
+    }
+
+    // BGZF blocks and zstd frames decode independently: a window of them is
+    // read, decoded over several threads and then handed out in order
+    struct Unit {
+        std::string packed, text;
+        std::string error;
+    };
+    std::vector<Unit> window;
+    size_t unit = 0, unitPos = 0;   // next byte handed out
+    bool inputDone = false;
+#ifdef TECH_MAP_ZSTD
+    ZSTD_DStream *stream = nullptr;   // set once a frame is too large for a window
+    size_t streamHint = 0;            // nonzero while a frame is unfinished
+#endif
+
+    size_t readWindowed(char *buf, size_t n) {
+        size_t got = 0;
+        while (got < n) {
+            if (unit == window.size()) {
+#ifdef TECH_MAP_ZSTD
+                if (stream) return got + readZstdStream(buf + got, n - got);
+#endif
+                if (inputDone || !fillWindow()) break;
+                continue;
+            }
+            const Unit &u = window[unit];
+            size_t k = std::min(n - got, u.text.size() - unitPos);
+            std::memcpy(buf + got, u.text.data() + unitPos, k);
+            got += k;
+            unitPos += k;
+            if (unitPos == u.text.size()) {
+                unit++;
+                unitPos = 0;
+            }
+        }
+        return got;
+    }
+
+    bool fillWindow() {
+        window.clear();
+        unit = unitPos = 0;
+        size_t bytes = 0;
+        while (bytes < INPUT_WINDOW) {
+            Unit u;
+            if (!nextUnit(u.packed)) break;
+            bytes += u.packed.size();
+            window.push_back(std::move(u));
+        }
+        if (!error.empty()) return false;
+        // units are spread over the threads round-robin
+        int t = (int)std::min(window.size(), (size_t)threads);
+        std::vector<std::thread> pool;
+        for (int k = 1; k < t; k++) pool.emplace_back([this, k, t] { decodeUnits(k, t); });
+        decodeUnits(0, t);
+        for (std::thread &th : pool) th.join();
+        for (const Unit &u : window)
+            if (!u.error.empty()) return fail(u.error);
+#ifdef TECH_MAP_ZSTD
+        return !window.empty() || stream;
+#else
+        return !window.empty();
+#endif
+    }
+
+    void decodeUnits(int first, int step) {
+#ifdef TECH_MAP_ZSTD
+        ZSTD_DCtx *dctx = format == InputFormat::ZSTD ? ZSTD_createDCtx() : nullptr;
+#endif
+        for (size_t k = first; k < window.size(); k += step) {
+#ifdef TECH_MAP_ZSTD
+            if (dctx) {
+                decodeZstd(dctx, window[k]);
+                continue;
+            }
+#endif
+            decodeBgzf(window[k]);
+        }
+#ifdef TECH_MAP_ZSTD
+        if (dctx) ZSTD_freeDCtx(dctx);
+#endif
+    }
+
+    // The compressed bytes of the next block or frame; false at the end
+    bool nextUnit(std::string &packed) {
+        if (inputDone) return false;
+        if (in.empty()) in.resize(INPUT_CHUNK);
+        if (format == InputFormat::BGZF) {
+            if (!need(18)) return inEnd > inPos ? fail("truncated BGZF data") : false;
+            const unsigned char *h = (const unsigned char *)in.data() + inPos;
+            if (h[0] != 0x1F || h[1] != 0x8B || !(h[3] & 4) || h[12] != 'B' || h[13] != 'C')
+                return fail("corrupt BGZF block header");
+            size_t size = (size_t)(h[16] | h[17] << 8) + 1;   // BSIZE is the block size - 1
+            if (!need(size)) return fail("truncated BGZF data");
+            packed.assign(in.data() + inPos, size);
+            inPos += size;
+            return true;
+        }
+#ifdef TECH_MAP_ZSTD
+        for (;;) {
+            if (inPos == inEnd && !need(1)) return false;
+            size_t size = ZSTD_findFrameCompressedSize(in.data() + inPos, inEnd - inPos);
+            if (!ZSTD_isError(size)) {
+                packed.assign(in.data() + inPos, size);
+                inPos += size;
+                return true;
+            }
+            if (inEnd - inPos >= INPUT_MAX_UNIT) {
+                // decode the rest as one stream, starting from the bytes held
+                stream = ZSTD_createDStream();
+                ZSTD_initDStream(stream);
+                inputDone = true;
+                return false;
+            }
+            if (!need(inEnd - inPos + 1)) return fail("truncated zstd data");
+        }
+#else
+        return false;
+#endif
+    }
+
+    // Makes at least k unread compressed bytes available; false if the file
+    // ends first (with no bytes left over, that is the clean end)
+    bool need(size_t k) {
+        while (inEnd - inPos < k) {
+            if (!refill()) {
+                if (inEnd == inPos) inputDone = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void decodeBgzf(Unit &u) {
+        const unsigned char *p = (const unsigned char *)u.packed.data();
+        size_t extra = (size_t)(p[10] | p[11] << 8);
+        size_t start = 12 + extra, end = u.packed.size() - 8;
+        if (start > end) {
+            u.error = "corrupt BGZF block";
+            return;
+        }
+        uint32_t crc = p[end] | p[end + 1] << 8 | p[end + 2] << 16 | (uint32_t)p[end + 3] << 24;
+        uint32_t size = p[end + 4] | p[end + 5] << 8 | p[end + 6] << 16 | (uint32_t)p[end + 7] << 24;
+        u.text.resize(size);
+        z_stream s = {};
+        inflateInit2(&s, -15);   // raw deflate
+        s.next_in = (Bytef *)p + start;
+        s.avail_in = (uInt)(end - start);
+        s.next_out = (Bytef *)&u.text[0];
+        s.avail_out = size;
+        int r = inflate(&s, Z_FINISH);
+        inflateEnd(&s);
+        if (r != Z_STREAM_END || s.avail_out != 0 || crc32(0, (const Bytef *)u.text.data(), size) != crc)
+            u.error = "corrupt BGZF block";
+        u.packed.clear();
+        u.packed.shrink_to_fit();
+    }
+
+#ifdef TECH_MAP_ZSTD
+    static void decodeZstd(ZSTD_DCtx *dctx, Unit &u) {
+        unsigned long long size = ZSTD_getFrameContentSize(u.packed.data(), u.packed.size());
+        if (size == ZSTD_CONTENTSIZE_ERROR) {
+            u.error = "corrupt zstd frame";
+            return;
+        }
+        if (size != ZSTD_CONTENTSIZE_UNKNOWN) {
+            u.text.resize((size_t)size);
+            size_t r = ZSTD_decompressDCtx(dctx, &u.text[0], u.text.size(), u.packed.data(), u.packed.size());
+            if (ZSTD_isError(r) || r != size) u.error = "corrupt zstd frame";
+        } else {
+            // no size in the header: grow as it decodes
+            ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+            ZSTD_inBuffer src = {u.packed.data(), u.packed.size(), 0};
+            size_t r = 1;
+            while (r != 0) {
+                size_t old = u.text.size();
+                u.text.resize(old + INPUT_CHUNK);
+                ZSTD_outBuffer dst = {&u.text[old], INPUT_CHUNK, 0};
+                r = ZSTD_decompressStream(dctx, &dst, &src);
+                u.text.resize(old + dst.pos);
+                if (ZSTD_isError(r) || (r != 0 && src.pos == src.size && dst.pos == 0)) {
+                    u.error = "corrupt zstd frame";
+                    break;
+                }
+            }
+        }
+        u.packed.clear();
+        u.packed.shrink_to_fit();
+    }
+
+    size_t readZstdStream(char *buf, size_t n) {
+        ZSTD_outBuffer dst = {buf, n, 0};
+        while (dst.pos < dst.size) {
+            if (inPos == inEnd) {
+                inPos = inEnd = 0;
+                if (!refill()) {
+                    if (streamHint != 0) fail("truncated zstd data");
+                    break;
+                }
+            }
+            ZSTD_inBuffer src = {in.data() + inPos, inEnd - inPos, 0};
+            streamHint = ZSTD_decompressStream(stream, &dst, &src);
+            inPos += src.pos;
+            if (ZSTD_isError(streamHint)) {
+                fail("corrupt zstd data");
+                break;
+            }
+        }
+        return dst.pos;
+    }
+#endif
+};
+
+// readNetlist for any InputFile format. Plain files go to readNetlist.
+inline bool readNetlistFile(const std::string &fname, Netlist &nl) {
+    if (detectInputFormat(fname) == InputFormat::PLAIN) return readNetlist(fname, nl);
+    InputFile in;
+    if (!in.open(fname)) return false;
+    std::vector<char> buf(INPUT_CHUNK);
+    std::string line;
+    int lineNo = 0;
+    auto parse = [&]() {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (parseNetlistLine(line, nl)) return true;
+        std::cerr << fname << ":" << lineNo << ": cannot parse '" << line << "'" << std::endl;
+        return false;
+    };
+    while (size_t n = in.read(buf.data(), buf.size())) {
+        for (const char *p = buf.data(), *end = p + n; p < end;) {
+            const char *eol = (const char *)std::memchr(p, '\n', end - p);
+            line.append(p, eol ? eol : end);
+            if (!eol) break;
+            if (!parse()) return false;
+            line.clear();
+            p = eol + 1;
+        }
+    }
+    if (!in.error.empty()) {
+        std::cerr << fname << ": " << in.error << std::endl;
+        return false;
+    }
+    if (!line.empty() && !parse()) return false;
+    return !nl.outputs.empty();
+}
+
+#endif
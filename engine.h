@@ -0,0 +1,169 @@
+// engine.h
+// Common interface over the mapping strategies in this repo, so one can be
+// picked by name at run time. The shared-header mapper runs in process; the
+// older stand-alone programs run as subprocesses ("prog input output") and
+// their cost is read back from the output file.
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <csignal>
+#include <sys/wait.h>
+
+#include "mapper.h"
+#include "exact_cover.h"
+
+struct EngineResult {
+    int cost = -1;          // -1 when the engine failed
+    std::string error;
+};
+
+class MapperEngine {
+public:
+    virtual ~MapperEngine() {}
+    virtual std::string name() const = 0;
+    virtual std::string description() const = 0;
+    // Parses inputFile, maps it and returns the total cost
+    virtual EngineResult run(const std::string &inputFile) = 0;
+};
+
+// TechnologyMapper with the optional exact and choice passes
+class CoreEngine : public MapperEngine {
+public:
+    CoreEngine(const std::string &n, bool exact, bool choices)
+        : engineName(n), useExact(exact), useChoices(choices) {}
+
+    std::string name() const override { return engineName; }
+    std::string description() const override {
+        std::string d = "subject graph DP";
+        if (useChoices) d += " with choices";
+        if (useExact) d += ", exact small cones";
+        return d;
+    }
+
+    EngineResult run(const std::string &inputFile) override {
+        EngineResult r;
+        TechnologyMapper tm;
+        tm.choices = useChoices;
+        if (!tm.readNetlist(inputFile)) {
+            r.error = "parse failed";
+            return r;
+        }
+        r.cost = tm.calculateMinimalCost();
+        if (r.cost >= 0 && useExact) r.cost = calculateExactCost(tm);
+        if (r.cost < 0) r.error = "no cover";
+        return r;
+    }
+
+private:
+    std::string engineName;
+    bool useExact;
+    bool useChoices;
+};
+
+// One of the stand-alone mapper programs, built separately into binDir
+class ExternalEngine : public MapperEngine {
+public:
+    ExternalEngine(const std::string &n, const std::string &desc, const std::string &binDir,
+                   int timeoutSec)
+        : engineName(n), engineDesc(desc), exe(binDir + "/" + n), timeout(timeoutSec) {}
+
+    std::string name() const override { return engineName; }
+    std::string description() const override {
+        return access(exe.c_str(), X_OK) == 0 ? engineDesc : engineDesc + " (not built: " + exe + ")";
+    }
+
+    EngineResult run(const std::string &inputFile) override {
+        EngineResult r;
+        if (access(exe.c_str(), X_OK) != 0) {
+            r.error = "not built (" + exe + ")";
+            return r;
+        }
+        char outPath[] = "/tmp/engine_out_XXXXXX";
+        int fd = mkstemp(outPath);
+        if (fd < 0) {
+            r.error = "no temp file";
+            return r;
+        }
+        close(fd);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // the programs chat on stdout; keep only the cost file
+            int devnull = open("/dev/null", O_WRONLY);
+            if (devnull >= 0) {
+                dup2(devnull, 1);
+                dup2(devnull, 2);
+            }
+            if (timeout > 0) alarm(timeout);   // survives the exec
+            execl(exe.c_str(), exe.c_str(), inputFile.c_str(), outPath, (char *)nullptr);
+            _exit(127);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0) {
+            r.error = "fork failed";
+        } else if (WIFSIGNALED(status)) {
+            r.error = WTERMSIG(status) == SIGALRM ? "timeout" : "killed by signal " + std::to_string(WTERMSIG(status));
+        } else if (WEXITSTATUS(status) != 0) {
+            r.error = "exit status " + std::to_string(WEXITSTATUS(status));
+        } else {
+            std::ifstream f(outPath);
+            if (!(f >> r.cost)) {
+                r.cost = -1;
+                r.error = "no cost in output";
+            }
+        }
+        unlink(outPath);
+        return r;
+    }
+
+private:
+    std::string engineName;
+    std::string engineDesc;
+    std::string exe;
+    int timeout;
+};
+
+// Every known engine. The stand-alone programs are looked up in binDir under
+// their source name (get_em_all is C++ without the extension).
+inline std::vector<std::unique_ptr<MapperEngine>> makeEngines(const std::string &binDir = ".",
+                                                              int timeoutSec = 60) {
+    std::vector<std::unique_ptr<MapperEngine>> engines;
+    engines.emplace_back(new CoreEngine("dp", false, false));
+    engines.emplace_back(new CoreEngine("dp-choices", false, true));
+    engines.emplace_back(new CoreEngine("exact", true, false));
+    engines.emplace_back(new CoreEngine("exact-choices", true, true));
+
+    static const char *const programs[][2] = {
+        {"final_tm", "memoized eval() pattern ladder"},
+        {"TMC", "memoized evaluate() pattern ladder"},
+        {"exc_test", "memoized eval() pattern ladder"},
+        {"attempt2", "TechnologyMapper class, pattern ladder"},
+        {"67testcase", "TechnologyMapper class, pattern ladder"},
+        {"get_em_all", "TechnologyMapper class, pattern ladder"},
+        {"calc_cost", "explicit NAND-NOT tree, single output"},
+        {"techMapV", "NAND-NOT tree with DP"},
+        {"TM418", "NAND/NOT cost sweep"},
+        {"421test", "NAND/NOT cost sweep"},
+        {"technology_mapping", "NAND-NOT tree costing"},
+    };
+    for (const auto &p : programs)
+        engines.emplace_back(new ExternalEngine(p[0], p[1], binDir, timeoutSec));
+    return engines;
+}
+
+inline MapperEngine *findEngine(const std::vector<std::unique_ptr<MapperEngine>> &engines,
+                                const std::string &name) {
+    for (const auto &e : engines)
+        if (e->name() == name) return e.get();
+    return nullptr;
+}
+
+#endif
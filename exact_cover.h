@@ -0,0 +1,246 @@
+// exact_cover.h
+// Exact covering for small cones. The DP in mapper.h is only optimal when no
+// logic is shared. This searches every cover of a cone, including the ones
+// that duplicate a multi-fanout node inside several cells.
+#ifndef EXACT_COVER_H
+#define EXACT_COVER_H
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <cstdint>
+
+#include "mapper.h"
+
+static const int MAX_EXACT_NODES = 30;
+
+// Outputs whose cones share logic are solved together as one cone
+struct ExactCone {
+    std::vector<int> nodes;   // non-input subject nodes (class representatives), in topological order
+    std::vector<int> roots;   // subject nodes of the outputs in the group
+    int dpCost = 0;           // cost of the DP cover of these nodes
+    int exactCost = -1;       // -1 when the cone was too big to search
+    std::vector<std::pair<int, Match>> choice;   // optimal cover, member node -> cell
+};
+
+struct ExactStats {
+    int cones = 0;
+    int solved = 0;
+    int improved = 0;
+    int saved = 0;
+};
+
+// Branch-and-bound over the set of nodes that still need a cell. Nodes are
+// decided from the last in topological order down and every leaf comes before
+// its root, so that set (a cut of the cone) is the whole search state and is
+// memoized as a bitmask. With choice classes, a node stands for its class and
+// may be implemented by a match rooted at any member.
+class ExactConeSolver {
+public:
+    ExactConeSolver(const SubjectGraph &sg, const std::vector<int> &fanout, ExactCone &c)
+        : cone(c) {
+        int n = (int)cone.nodes.size();
+        std::unordered_map<int, int> local;
+        for (int i = 0; i < n; i++) local[cone.nodes[i]] = i;
+        matches.resize(n);
+        members.resize(n);
+        leafMask.resize(n);
+        minRoot.assign(n, std::numeric_limits<int>::max());
+        for (int i = 0; i < n; i++) {
+            for (int mb = cone.nodes[i]; mb >= 0; mb = sg.nextChoice[mb]) {
+                Match m[MAX_MATCHES];
+                int k = findMatches(sg, fanout, mb, m, true);
+                for (int j = 0; j < k; j++) {
+                    matches[i].push_back(m[j]);
+                    members[i].push_back(mb);
+                }
+            }
+            // cheapest cells first so the bound cuts in early
+            std::vector<size_t> idx(matches[i].size());
+            std::iota(idx.begin(), idx.end(), 0);
+            std::stable_sort(idx.begin(), idx.end(), [&](size_t a, size_t b) {
+                return cellCost(matches[i][a].cell) < cellCost(matches[i][b].cell);
+            });
+            std::vector<Match> sorted;
+            std::vector<int> sortedMembers;
+            for (size_t j : idx) {
+                sorted.push_back(matches[i][j]);
+                sortedMembers.push_back(members[i][j]);
+            }
+            matches[i].swap(sorted);
+            members[i].swap(sortedMembers);
+            for (const Match &mt : matches[i]) {
+                uint32_t mask = 0;
+                for (int l = 0; l < mt.numLeaves; l++) {
+                    auto it = local.find(sg.repr[mt.leaves[l]]);
+                    if (it != local.end()) mask |= 1u << it->second;
+                }
+                leafMask[i].push_back(mask);
+                minRoot[i] = std::min(minRoot[i], cellCost(mt.cell));
+            }
+        }
+        for (int r : cone.roots) {
+            auto it = local.find(sg.repr[r]);
+            if (it != local.end()) rootMask |= 1u << it->second;
+        }
+    }
+
+    // Returns the optimal cost and fills cone.choice, or keeps the DP cover
+    // (and returns its cost) when nothing cheaper exists
+    int solve() {
+        int cost = search(rootMask);
+        if (cost >= cone.dpCost) return cone.dpCost;
+        uint32_t pending = rootMask;
+        while (pending) {
+            int p = 31 - __builtin_clz(pending);
+            int idx = memo[pending].second;
+            cone.choice.push_back({members[p][idx], matches[p][idx]});
+            pending = (pending & ~(1u << p)) | leafMask[p][idx];
+        }
+        return cost;
+    }
+
+private:
+    ExactCone &cone;
+    std::vector<std::vector<Match>> matches;
+    std::vector<std::vector<int>> members;   // class member each match is rooted at
+    std::vector<std::vector<uint32_t>> leafMask;
+    std::vector<int> minRoot;    // cheapest cell rooted at each node
+    uint32_t rootMask = 0;
+    std::unordered_map<uint32_t, std::pair<int, int>> memo;   // cost, match index
+
+    // Every pending node needs its own cell, so the cheapest cell per node
+    // summed over the set never overestimates
+    int lowerBound(uint32_t pending) const {
+        int lb = 0;
+        while (pending) {
+            int p = __builtin_ctz(pending);
+            lb += minRoot[p];
+            pending &= pending - 1;
+        }
+        return lb;
+    }
+
+    int search(uint32_t pending) {
+        if (pending == 0) return 0;
+        auto it = memo.find(pending);
+        if (it != memo.end()) return it->second.first;
+
+        int p = 31 - __builtin_clz(pending);
+        uint32_t rest = pending & ~(1u << p);
+        int best = std::numeric_limits<int>::max();
+        int bestIdx = -1;
+        for (size_t j = 0; j < matches[p].size(); j++) {
+            int c = cellCost(matches[p][j].cell);
+            uint32_t next = rest | leafMask[p][j];
+            if (c + lowerBound(next) >= best) continue;
+            c += search(next);
+            if (c < best) {
+                best = c;
+                bestIdx = (int)j;
+            }
+        }
+        memo[pending] = {best, bestIdx};
+        return best;
+    }
+};
+
+// Groups the outputs into cones that share no subject nodes. A node reached
+// from an output brings its whole choice class with it.
+inline std::vector<ExactCone> collectCones(const TechnologyMapper &tm) {
+    const SubjectGraph &sg = tm.graph;
+    int numOut = (int)sg.outputs.size();
+    std::vector<int> parent(numOut);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::function<int(int)> find = [&](int x) {
+        return parent[x] == x ? x : parent[x] = find(parent[x]);
+    };
+
+    std::vector<int> owner(sg.size(), -1);
+    for (int o = 0; o < numOut; o++) {
+        std::vector<int> stack = {sg.outputs[o]};
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            if (sg.nodes[id].type == GateType::INPUT) continue;
+            if (owner[id] >= 0) {
+                parent[find(owner[id])] = find(o);
+                continue;
+            }
+            owner[id] = o;
+            for (int m = sg.repr[id]; m >= 0; m = sg.nextChoice[m]) stack.push_back(m);
+            stack.push_back(sg.nodes[id].in0);
+            if (sg.nodes[id].in1 >= 0) stack.push_back(sg.nodes[id].in1);
+        }
+    }
+
+    std::vector<int> coneOf(numOut, -1);
+    std::vector<ExactCone> cones;
+    for (int o = 0; o < numOut; o++) {
+        int g = find(o);
+        if (coneOf[g] < 0) {
+            coneOf[g] = (int)cones.size();
+            cones.emplace_back();
+        }
+        cones[coneOf[g]].roots.push_back(sg.outputs[o]);
+    }
+    // a class is ordered by its newest member, which is still older than
+    // any node that reads the class
+    std::vector<int> key(sg.size(), -1);
+    for (int id = 0; id < sg.size(); id++) key[sg.repr[id]] = id;
+    std::vector<int> reps;
+    for (int id = 0; id < sg.size(); id++) {
+        if (owner[id] >= 0 && sg.repr[id] == id) reps.push_back(id);
+    }
+    std::sort(reps.begin(), reps.end(), [&](int a, int b) { return key[a] < key[b]; });
+    for (int id : reps) cones[coneOf[find(owner[id])]].nodes.push_back(id);
+    for (int id : tm.cover) {
+        cones[coneOf[find(owner[id])]].dpCost += cellCost(tm.best[id].cell);
+    }
+    return cones;
+}
+
+// Re-maps every cone of at most MAX_EXACT_NODES nodes exactly, solving the
+// cones in parallel; larger cones keep the DP cover. Call after
+// calculateMinimalCost(). Returns the new total cost.
+inline int calculateExactCost(TechnologyMapper &tm, ExactStats *stats = nullptr, int threads = 0) {
+    std::vector<ExactCone> cones = collectCones(tm);
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < (int)cones.size(); i = next++) {
+            ExactCone &c = cones[i];
+            if ((int)c.nodes.size() > MAX_EXACT_NODES) continue;
+            ExactConeSolver solver(tm.graph, tm.fanout, c);
+            c.exactCost = solver.solve();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread &t : pool) t.join();
+
+    ExactStats st;
+    st.cones = (int)cones.size();
+    for (const ExactCone &c : cones) {
+        if (c.exactCost < 0) continue;
+        st.solved++;
+        if (c.choice.empty()) continue;
+        st.improved++;
+        st.saved += c.dpCost - c.exactCost;
+        for (const auto &ch : c.choice) {
+            tm.best[ch.first] = ch.second;
+            tm.chosen[tm.graph.repr[ch.first]] = ch.first;
+        }
+    }
+    if (stats) *stats = st;
+    return tm.extractCover();
+}
+
+#endif
@@ -7,11 +7,12 @@
 #include <limits>
 #include <algorithm>
 
+#include "cell_library.h"
+
 using namespace std;
 
-enum class NodeType {
-    AND, OR, NOT, INPUT, OUTPUT, NAND2, NOR2, AOI21, AOI22
-};
+// Gate types come from the shared technology table
+using NodeType = GateType;
 
 struct Node {
     string name;
@@ -22,14 +23,6 @@ struct Node {
     Node() : type(NodeType::INPUT), cost(-1), visited(false) {}
 };
 
-static const int NOT_COST = 2;
-static const int NAND2_COST = 3;
-static const int AND2_COST = 4;
-static const int NOR2_COST = 6;
-static const int OR2_COST = 4;
-static const int AOI21_COST = 7;
-static const int AOI22_COST = 7;
-
 static string trim(const string &s) {
     size_t f = s.find_first_not_of(" \t\r\n");
     if (f == string::npos) return "";
@@ -170,15 +163,17 @@ int eval(const string &nm) {
     return n.cost = best;
 }
 
-int main() {
-    if (!readNetlist("input8.txt")) return 1;
+int main(int argc, char* argv[]) {
+    string inputFile = argc > 1 ? argv[1] : "input8.txt";
+    string outputFile = argc > 2 ? argv[2] : "output.txt";
+    if (!readNetlist(inputFile)) return 1;
     for (auto &p : nodes) {
         p.second.visited = false;
         p.second.cost = -1;
     }
     int c = eval(outputNode);
     if (c < 0) return 1;
-    ofstream out("output.txt"); out << c;
+    ofstream out(outputFile); out << c;
     cout << "Minimal cost: " << c << endl;
     return 0;
 }
@@ -6,48 +6,35 @@
 #include <algorithm>
 #include <sstream>
 #include <limits>
+#include <string_view>
+#include <cctype>
+#include <sys/resource.h>
 
-using namespace std;
-
-unordered_map<string, Node> nodes;
-string outputNode;
-
-// Gates used in the circuit
-enum class NodeType {
-    AND,
-    OR,
-    NOT,
-    INPUT,
-    OUTPUT,
-    NAND2,
-    NOR2,
-    AOI21,
-    AOI22
-};
+#include "cell_library.h"
+#include "netlist.h"
+#include "packed_netlist.h"
 
+using namespace std;
 
-struct Node {
-    string name;
-    NodeType type;
-    vector<string> inputs;
-    int cost;
-    bool visited;
+// Gate types come from the shared technology table
+using NodeType = GateType;
 
-    Node() :
-      type(NodeType::INPUT),
-      cost(-1),
-      visited(false) 
-      {}
-};
+// Every signal is a 24-byte PackedNode; names live in the netlist's arena
+PackedNetlist nodes;
+string outputNode;
 
-// Constants of gate costs given in technology table
-static const int NOT_COST   = 2;
-static const int NAND2_COST = 3;
-static const int AND2_COST  = 4;
-static const int NOR2_COST  = 6;
-static const int OR2_COST   = 4;
-static const int AOI21_COST = 7;
-static const int AOI22_COST = 7;
+// Splits a line into whitespace-separated tokens, like >> would
+static void splitTokens(const string &line, vector<string_view> &tok) {
+    tok.clear();
+    size_t p = 0, n = line.size();
+    while (p < n) {
+        while (p < n && isspace((unsigned char)line[p])) p++;
+        size_t q = p;
+        while (q < n && !isspace((unsigned char)line[q])) q++;
+        if (q > p) tok.push_back(string_view(line).substr(p, q - p));
+        p = q;
+    }
+}
 
 // Processes input file 
 bool readNetlist(const string &fname) {
@@ -59,135 +46,125 @@ bool readNetlist(const string &fname) {
         return false;
     } 
 
-    
-    while (getline(f, line)) {
+    vector<string_view> tok;
+    vector<uint32_t> in;
+    bool full = false;
+    auto intern = [&](string_view s) {
+        uint32_t id = nodes.intern(s);
+        full = full || id == PackedNetlist::NONE;
+        return id;
+    };
+    while (getline(f, line) && !full) {
         if (line.empty() || line.rfind("Test", 0) == 0 || line.rfind("Script", 0) == 0)
             continue;
-        istringstream iss(line);
-        string nm, op;
-        iss >> nm >> op;
+        splitTokens(line, tok);
+        if (tok.size() < 2) continue;
+        string_view nm = tok[0], op = tok[1];
         if (op == "INPUT") {
-            Node &n = nodes[nm];
-            n.name = nm;
-            n.type = NodeType::INPUT;
-            n.cost = 0;
+            uint32_t id = intern(nm);
+            if (full) break;
+            nodes.node(id).type = NodeType::INPUT;
+            nodes.node(id).cost = 0;
         } else if (op == "OUTPUT") {
-            outputNode = nm;
-        } else if (op == "=") {
-            string gt;
-            iss >> gt;
-            Node &n = nodes[nm];
-            n.name = nm;
-            if (gt == "NOT") {
-                n.type = NodeType::NOT;
-                string a; iss >> a;
-                n.inputs = {a};
-            } else if (gt == "AND") {
-                n.type = NodeType::AND;
-                string a, b; iss >> a >> b;
-                n.inputs = {a, b};
-            } else if (gt == "OR") {
-                n.type = NodeType::OR;
-                string a, b; iss >> a >> b;
-                n.inputs = {a, b};
-            } else if (gt == "NAND2") {
-                n.type = NodeType::NAND2;
-                string a, b; iss >> a >> b;
-                n.inputs = {a, b};
-            } else if (gt == "NOR2") {
-                n.type = NodeType::NOR2;
-                string a, b; iss >> a >> b;
-                n.inputs = {a, b};
+            outputNode = string(nm);
+        } else if (op == "=" && tok.size() > 2) {
+            uint32_t id = intern(nm);
+            string gt(tok[2]);
+            // AND and OR take every input given; the other gates a fixed number
+            size_t want = 0;
+            NodeType t = NodeType::UNKNOWN;
+            if (tok.size() == 3) {
+                // "F = t5" just renames another signal
+                t = NodeType::OUTPUT;
+            } else if (gt == "NOT") {
+                t = NodeType::NOT; want = 1;
+            } else if (gt == "AND" || gt == "OR") {
+                t = gt == "AND" ? NodeType::AND : NodeType::OR; want = tok.size() - 3;
+            } else if (gt == "NAND2" || gt == "NOR2") {
+                t = gt == "NAND2" ? NodeType::NAND2 : NodeType::NOR2; want = 2;
             } else if (gt == "AOI21") {
-                n.type = NodeType::AOI21;
-                string a, b, c; iss >> a >> b >> c;
-                n.inputs = {a, b, c};
+                t = NodeType::AOI21; want = 3;
             } else if (gt == "AOI22") {
-                n.type = NodeType::AOI22;
-                string a, b, c, d; iss >> a >> b >> c >> d;
-                n.inputs = {a, b, c, d};
-            } else if (iss.peek() == EOF) {
-                n.type = NodeType::OUTPUT;
-                n.inputs = {gt};
+                t = NodeType::AOI22; want = 4;
             }
+            if (t == NodeType::UNKNOWN) continue;
+            in.clear();
+            if (t == NodeType::OUTPUT) in.push_back(intern(tok[2]));
+            for (size_t k = 3; k < tok.size() && k < 3 + want; k++) in.push_back(intern(tok[k]));
+            if (full) break;
+            nodes.node(id).type = t;
+            nodes.setFanins(id, in.data(), in.size());
         }
     }
-    return !outputNode.empty();
+    if (full) {
+        cerr << "Netlist too large: more than 4G signals or 4 GB of names" << endl;
+        return false;
+    }
+    return !outputNode.empty() && intern(outputNode) != PackedNetlist::NONE;
 }
 
+int eval(uint32_t id);
+
     int calculateMinimalCost() {
-        for (auto &p : nodes) {
-            p.second.visited = false;
-            p.second.cost = -1;
+        for (uint32_t id = 0; id < nodes.size(); id++) {
+            nodes.node(id).flags &= ~PackedNode::VISITED;
+            nodes.node(id).cost = -1;
         }
-        return eval(outputNode);
+        return eval(nodes.find(outputNode));
     }
 
-private:
-    //recursively computes the minimum cost to implement the sub-circuit with a root of (name)
-    int eval(const string &nm) {
-        Node &n = nodes[nm];
+    //recursively computes the minimum cost to implement the sub-circuit with a root of (id)
+    int eval(uint32_t id) {
+        PackedNode &n = nodes.node(id);
+        FaninRange in = nodes.fanins(id);
         // --- NOT-node patterns ---
-        if (n.type == NodeType::NOT) {
-            const string &c = n.inputs[0];
+        if (n.type == NodeType::NOT && in.size() == 1) {
+            uint32_t c = in[0];
+            const PackedNode &cn = nodes.node(c);
+            FaninRange cin = nodes.fanins(c);
             // double-negation: NOT(NOT(x)) -> x
-            if (nodes[c].type == NodeType::NOT){
-                return eval(nodes[c].inputs[0]);
+            if (cn.type == NodeType::NOT && cin.size() == 1){
+                return eval(cin[0]);
             }
             // NOT(OR(a,b)) -> NOR2(a,b)
-            if (nodes[c].type == NodeType::OR) {
-                auto &in = nodes[c].inputs;
-                int c0 = eval(in[0]);
-                int c1 = eval(in[1]);
+            if (cn.type == NodeType::OR && cin.size() == 2) {
+                int c0 = eval(cin[0]);
+                int c1 = eval(cin[1]);
                 return (c0 < 0 || c1 < 0) ? -1 : c0 + c1 + NOR2_COST;
             }
             // NOT(OR(AND,...)) -> AOI21/AOI22
-            if (nodes[c].type == NodeType::OR) {
-                auto &in = nodes[c].inputs;
-                bool a0 = nodes[in[0]].type == NodeType::AND;
-                bool a1 = nodes[in[1]].type == NodeType::AND;
+            if (cn.type == NodeType::OR && cin.size() == 2) {
+                FaninRange v0 = nodes.fanins(cin[0]), v1 = nodes.fanins(cin[1]);
+                bool a0 = nodes.node(cin[0]).type == NodeType::AND && v0.size() == 2;
+                bool a1 = nodes.node(cin[1]).type == NodeType::AND && v1.size() == 2;
                 // AOI21
                 if (a0 && !a1) {
-                    auto &v = nodes[in[0]].inputs;
-                    int x = eval(v[0]), y = eval(v[1]), z = eval(in[1]);
+                    int x = eval(v0[0]), y = eval(v0[1]), z = eval(cin[1]);
                     return (x < 0 || y < 0 || z < 0) ? -1 : x + y + z + AOI21_COST;
                 }
                 if (!a0 && a1) {
-                    auto &v = nodes[in[1]].inputs;
-                    int x = eval(v[0]), y = eval(v[1]), z = eval(in[0]);
+                    int x = eval(v1[0]), y = eval(v1[1]), z = eval(cin[0]);
                     return (x < 0 || y < 0 || z < 0) ? -1 : x + y + z + AOI21_COST;
                 }
                 // AOI22
                 if (a0 && a1) {
-                    auto &v0 = nodes[in[0]].inputs, &v1 = nodes[in[1]].inputs;
                     int x = eval(v0[0]), y = eval(v0[1]), u = eval(v1[0]), v2 = eval(v1[1]);
                     return (x < 0 || y < 0 || u < 0 || v2 < 0) ? -1 : x + y + u + v2 + AOI22_COST;
                 }
             }
         }
         // --- AND-node patterns ---
-        if (n.type == NodeType::AND) {
-            auto &in = n.inputs;
-            // Pattern: AND(AND(a,b), NOT(OR(c,d))) -> NOR2(NAND2(a,b), OR(c,d))
-            if (nodes[in[0]].type == NodeType::AND &&
-                nodes[in[1]].type == NodeType::NOT &&
-                nodes[nodes[in[1]].inputs[0]].type == NodeType::OR) {
-                auto &ab = nodes[in[0]].inputs;
-                auto &cd = nodes[nodes[in[1]].inputs[0]].inputs;
-                int ca = eval(ab[0]); if (ca < 0) return -1;
-                int cb = eval(ab[1]); if (cb < 0) return -1;
-                int cc = eval(cd[0]); if (cc < 0) return -1;
-                int cdv = eval(cd[1]); if (cdv < 0) return -1;
-                int costNand = ca + cb + NAND2_COST;
-                int costOr = cc + cdv + OR2_COST;
-                return costNand + costOr + NOR2_COST;
-            }
-            // Pattern: AND(NOT(OR(c,d)), AND(a,b)) -> NOR2(OR(c,d), NAND2(a,b))
-            if (nodes[in[1]].type == NodeType::AND &&
-                nodes[in[0]].type == NodeType::NOT &&
-                nodes[nodes[in[0]].inputs[0]].type == NodeType::OR) {
-                auto &ab = nodes[in[1]].inputs;
-                auto &cd = nodes[nodes[in[0]].inputs[0]].inputs;
+        if (n.type == NodeType::AND && in.size() == 2) {
+            // (and, not) are the two inputs in either order; not must read an OR2
+            for (int k = 0; k < 2; k++) {
+                uint32_t andIn = in[k], notIn = in[1 - k];
+                FaninRange ab = nodes.fanins(andIn), notFanins = nodes.fanins(notIn);
+                if (nodes.node(andIn).type != NodeType::AND || ab.size() != 2 ||
+                    nodes.node(notIn).type != NodeType::NOT || notFanins.size() != 1)
+                    continue;
+                FaninRange cd = nodes.fanins(notFanins[0]);
+                if (nodes.node(notFanins[0]).type != NodeType::OR || cd.size() != 2) continue;
+                // Pattern: AND(AND(a,b), NOT(OR(c,d))) -> NOR2(NAND2(a,b), OR(c,d)), and mirrored
                 int ca = eval(ab[0]); if (ca < 0) return -1;
                 int cb = eval(ab[1]); if (cb < 0) return -1;
                 int cc = eval(cd[0]); if (cc < 0) return -1;
@@ -198,34 +175,36 @@ private:
             }
         }
         // memo
-        if (n.visited && n.cost >= 0){
+        if ((n.flags & PackedNode::VISITED) && n.cost >= 0){
             return n.cost;
         } 
-        n.visited = true;
-        // base
-        if (n.type == NodeType::INPUT){
+        n.flags |= PackedNode::VISITED;
+        // base; a signal nothing defines is read like an input
+        if (n.type == NodeType::INPUT || n.type == NodeType::UNKNOWN){
             return n.cost = 0;
         }  
         if (n.type == NodeType::OUTPUT){
-            return n.cost = eval(n.inputs[0]);
+            return n.cost = eval(in[0]);
         } 
         // generic sum
         int sum = 0;
-        for (auto &ch : n.inputs) {
+        for (uint32_t ch : in) {
             int c = eval(ch);
             if (c < 0) return -1;
             sum += c;
         }
+        // a wide AND/OR is a chain of 2-input gates
+        int gates2 = max(1, (int)in.size() - 1);
         int best = numeric_limits<int>::max();
         switch (n.type) {
             case NodeType::NOT:
                 best = min(NOT_COST + sum, NAND2_COST + sum);
                 break;
             case NodeType::AND:
-                best = min(AND2_COST + sum, NAND2_COST + NOT_COST + sum);
+                best = gates2 * min(AND2_COST, NAND2_COST + NOT_COST) + sum;
                 break;
             case NodeType::OR:
-                best = min({OR2_COST + sum, NOR2_COST + NOT_COST + sum, 2*NOT_COST + NAND2_COST + sum});
+                best = gates2 * min({OR2_COST, NOR2_COST + NOT_COST, 2*NOT_COST + NAND2_COST}) + sum;
                 break;
             case NodeType::NAND2:
                 best = NAND2_COST + sum;
@@ -244,18 +223,49 @@ private:
         }
         return n.cost = best;
     }
-};
 
-int main() {
-    if (!readNetlist("input.txt")){
+// Prints the bytes held per part of the netlist and the peak RSS
+void reportMemory() {
+    PackedMemory m = nodes.memory();
+    double gates = max<uint32_t>(1, nodes.size());
+    auto mb = [](size_t b) { return b / 1048576.0; };
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    cout.setf(ios::fixed);
+    cout.precision(1);
+    cout << "Memory: " << nodes.size() << " signals; nodes " << mb(m.nodes) << " MB (" << sizeof(PackedNode)
+         << " B each), wide fan-ins " << mb(m.pool) << " MB, names " << mb(m.names) << " MB + index "
+         << mb(m.index) << " MB; " << mb(m.total()) << " MB total, " << m.total() / gates
+         << " B/signal; peak RSS " << ru.ru_maxrss / 1024.0 << " MB" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> files;
+    bool memory = false;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--memory") memory = true;
+        else files.push_back(argv[i]);
+    }
+    string inputFile = files.size() > 0 ? files[0] : "input.txt";
+    string outputFile = files.size() > 1 ? files[1] : "output.txt";
+    if (!readNetlist(inputFile)){
         return 1;
     } 
+    // eval() would recurse around a loop forever
+    vector<vector<int>> loops = findLoopsIn((int)nodes.size(), [](int v) { return nodes.fanins(v); });
+    for (const vector<int> &loop : loops) {
+        cerr << "Combinational loop:";
+        for (int id : loop) cerr << " " << nodes.name(id);
+        cerr << endl;
+    }
+    if (!loops.empty()) return 1;
     int c = calculateMinimalCost();
     if (c < 0){
         return 1;
     } 
-    ofstream out("output.txt");
+    ofstream out(outputFile);
     out << c;
     cout << "Minimal cost: " << c << endl;
+    if (memory) reportMemory();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,266 @@
+// fraig.h
+// Merges functionally equivalent signals before the subject graph is built,
+// FRAIG style. Every signal gets a 256-bit signature from bit-parallel
+// simulation of random input patterns; signals whose signatures agree (or
+// are complements) are candidates, and a candidate pair is merged once an
+// exhaustive simulation over the union of their supports confirms it. Pairs
+// with more than FRAIG_MAX_SUPPORT inputs cannot be confirmed that way and
+// are left alone. The same sum of products built twice is then mapped once.
+#ifndef FRAIG_H
+#define FRAIG_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <cstdint>
+
+#include "netlist.h"
+#include "subject_graph.h"
+
+static const int FRAIG_WORDS = 4;          // 256 random patterns
+static const int FRAIG_MAX_SUPPORT = 16;   // exhaustive check: 2^16 patterns
+static const int FRAIG_MAX_TRIES = 4;      // candidates checked per signal
+static const int FRAIG_MAX_CONE = 4096;    // gates simulated per check
+
+struct FraigStats {
+    int gatesBefore = 0;     // cells in the cone (not counting inputs, buffers, tie-offs)
+    int gatesAfter = 0;
+    int merged = 0;          // signals replaced by an equivalent one
+    int complemented = 0;    // of those, replaced by the inverse of one
+    int constants = 0;       // of those, found to be constant
+    int disproved = 0;       // candidates the exhaustive check rejected
+    int unproven = 0;        // candidates with too large a support to check
+};
+
+// Evaluates one gate over words of patterns: out[w] for w < words
+inline void simulateGate(GateType t, const std::vector<const uint64_t *> &in, int words, uint64_t *out) {
+    for (int w = 0; w < words; w++) {
+        uint64_t v = 0;
+        switch (t) {
+            case GateType::OUTPUT: v = in[0][w]; break;
+            case GateType::NOT: v = ~in[0][w]; break;
+            case GateType::AND:
+                v = ~0ull;
+                for (const uint64_t *x : in) v &= x[w];
+                break;
+            case GateType::OR:
+                for (const uint64_t *x : in) v |= x[w];
+                break;
+            case GateType::NAND2: v = ~(in[0][w] & in[1][w]); break;
+            case GateType::NOR2: v = ~(in[0][w] | in[1][w]); break;
+            case GateType::AOI21: v = ~((in[0][w] & in[1][w]) | in[2][w]); break;
+            case GateType::AOI22: v = ~((in[0][w] & in[1][w]) | (in[2][w] & in[3][w])); break;
+            case GateType::CONST1: v = ~0ull; break;
+            default: break;   // CONST0
+        }
+        out[w] = v;
+    }
+}
+
+// Works on the netlist in place (readers are redirected and merged signals
+// rewritten) and copies the surviving cones out at the end.
+class NetlistFraig {
+public:
+    NetlistFraig(Netlist &n, FraigStats &s) : work(n), st(s) {}
+
+    bool run(Netlist &out) {
+        if (reportLoops(work) > 0) return false;
+        st.gatesBefore = countGates(work);
+        int c0 = work.intern("0"), c1 = work.intern("1");
+        std::vector<int> order;
+        if (!topoOrder(work, order)) return false;
+        int n = work.size();
+
+        // random simulation, in topological order
+        sig.assign((size_t)n * FRAIG_WORDS, 0);
+        std::mt19937_64 rng(41);
+        for (int id : order) {
+            const Gate &g = work.gates[id];
+            if (g.type == GateType::INPUT) {
+                for (int w = 0; w < FRAIG_WORDS; w++) sig[(size_t)id * FRAIG_WORDS + w] = rng();
+                continue;
+            }
+            in.clear();
+            for (int i : g.inputs) in.push_back(&sig[(size_t)i * FRAIG_WORDS]);
+            simulateGate(g.type, in, FRAIG_WORDS, &sig[(size_t)id * FRAIG_WORDS]);
+        }
+
+        // buckets by signature, complemented so that pattern 0 reads 0
+        pos.assign(n, 0);
+        for (size_t k = 0; k < order.size(); k++) pos[order[k]] = (int)k;
+        // buckets are chains through next, oldest first: (head, tail)
+        std::unordered_map<uint64_t, std::pair<int, int>> buckets;
+        buckets.reserve(order.size());
+        std::vector<int> next(n, -1);
+        std::vector<int> repl(n, -1);
+        std::vector<char> neg(n, 0);
+        buckets[key(c0)] = {c0, c0};
+        for (int id : order) {
+            GateType t = work.gates[id].type;
+            if (t == GateType::INPUT || t == GateType::OUTPUT || t == GateType::CONST0 || t == GateType::CONST1)
+                continue;
+            const std::vector<int> &ins = work.gates[id].inputs;
+            auto found = buckets.emplace(key(id), std::make_pair(id, id));
+            if (found.second) continue;
+            int tries = 0;
+            for (int cand = found.first->second.first; cand >= 0 && tries < FRAIG_MAX_TRIES; cand = next[cand], tries++) {
+                bool inv = phase(id) != phase(cand);
+                if (!sameSignature(id, cand, inv)) continue;
+                if (inv && t == GateType::NOT && ins[0] == cand) break;   // already its inverter
+                int r = prove(id, cand, inv);
+                if (r < 0) {
+                    st.unproven++;
+                    continue;
+                }
+                if (r == 0) {
+                    st.disproved++;
+                    continue;
+                }
+                if (cand == c0 && inv) {
+                    cand = c1;
+                    inv = false;
+                }
+                repl[id] = cand;
+                neg[id] = inv;
+                st.merged++;
+                if (inv) st.complemented++;
+                if (cand == c0 || cand == c1) st.constants++;
+                break;
+            }
+            if (repl[id] < 0) {
+                next[found.first->second.second] = id;
+                found.first->second.second = id;
+            }
+        }
+
+        // readers of a merged signal read its replacement; the signal itself
+        // stays as a buffer (or inverter) only for an output that names it
+        for (Gate &g : work.gates) {
+            for (int &i : g.inputs) {
+                if (repl[i] >= 0 && !neg[i]) i = repl[i];
+            }
+        }
+        for (int id = 0; id < n; id++) {
+            if (repl[id] < 0) continue;
+            work.gates[id].type = neg[id] ? GateType::NOT : GateType::OUTPUT;
+            work.gates[id].inputs = {repl[id]};
+        }
+        extractCone(work, work.outputs, out);
+        st.gatesAfter = countGates(out);
+        return true;
+    }
+
+private:
+    Netlist &work;
+    FraigStats &st;
+    std::vector<uint64_t> sig;                // id * FRAIG_WORDS + word
+    std::vector<int> pos;                     // place in the topological order
+    // prove() only
+    std::vector<int> local;                   // id -> slot in vals, -1 when unused
+    std::vector<int> cone, vars;
+    std::vector<uint64_t> vals;
+    std::vector<const uint64_t *> in;
+
+    int phase(int id) const { return (int)(sig[(size_t)id * FRAIG_WORDS] & 1); }
+
+    uint64_t key(int id) const {
+        uint64_t flip = phase(id) ? ~0ull : 0, h = 0;
+        for (int w = 0; w < FRAIG_WORDS; w++) h = (h ^ (sig[(size_t)id * FRAIG_WORDS + w] ^ flip)) * 0x9E3779B97F4A7C15ull;
+        return h;
+    }
+
+    bool sameSignature(int a, int b, bool inv) const {
+        uint64_t flip = inv ? ~0ull : 0;
+        for (int w = 0; w < FRAIG_WORDS; w++) {
+            if (sig[(size_t)a * FRAIG_WORDS + w] != (sig[(size_t)b * FRAIG_WORDS + w] ^ flip)) return false;
+        }
+        return true;
+    }
+
+    static int countGates(const Netlist &n) {
+        int c = 0;
+        for (const Gate &g : n.gates) {
+            if (g.type != GateType::INPUT && g.type != GateType::OUTPUT &&
+                g.type != GateType::CONST0 && g.type != GateType::CONST1 && g.type != GateType::UNKNOWN) c++;
+        }
+        return c;
+    }
+
+    // Simulates a and b on every assignment of their inputs: 1 when a equals
+    // b (or NOT b, with inv), 0 when not, -1 when the check is too large
+    int prove(int a, int b, bool inv) {
+        // the two cones and their inputs, given up once either is too large
+        if (local.size() < work.gates.size()) local.assign(work.gates.size(), -1);
+        cone.assign(1, a);
+        vars.clear();
+        local[a] = 0;
+        if (local[b] < 0) {
+            local[b] = 0;
+            cone.push_back(b);
+        }
+        bool tooLarge = false;
+        for (size_t k = 0; k < cone.size() && !tooLarge; k++) {
+            int id = cone[k];
+            if (work.gates[id].type == GateType::INPUT) {
+                vars.push_back(id);
+                tooLarge = vars.size() > (size_t)FRAIG_MAX_SUPPORT;
+            }
+            for (int i : work.gates[id].inputs) {
+                if (local[i] >= 0) continue;
+                local[i] = 0;
+                cone.push_back(i);
+            }
+            tooLarge = tooLarge || cone.size() > (size_t)FRAIG_MAX_CONE;
+        }
+        int result = -1;
+        if (!tooLarge) result = simulateCones(a, b, inv);
+        for (int id : cone) local[id] = -1;
+        return result;
+    }
+
+    int simulateCones(int a, int b, bool inv) {
+        std::sort(cone.begin(), cone.end(), [&](int x, int y) { return pos[x] < pos[y]; });
+        for (size_t k = 0; k < cone.size(); k++) local[cone[k]] = (int)k;
+        int k = (int)vars.size();
+        int words = k <= 6 ? 1 : 1 << (k - 6);
+        vals.assign(cone.size() * words, 0);
+        static const uint64_t VAR_MASK[6] = {0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull,
+                                             0xF0F0F0F0F0F0F0F0ull, 0xFF00FF00FF00FF00ull,
+                                             0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull};
+        for (int v = 0; v < k; v++) {
+            uint64_t *x = &vals[(size_t)local[vars[v]] * words];
+            for (int w = 0; w < words; w++) x[w] = v < 6 ? VAR_MASK[v] : ((w >> (v - 6)) & 1 ? ~0ull : 0);
+        }
+        for (int id : cone) {
+            const Gate &g = work.gates[id];
+            if (g.type == GateType::INPUT) continue;
+            in.clear();
+            for (int i : g.inputs) in.push_back(&vals[(size_t)local[i] * words]);
+            simulateGate(g.type, in, words, &vals[(size_t)local[id] * words]);
+        }
+        // with fewer than 6 variables only the low 2^k bits are patterns
+        uint64_t mask = k >= 6 ? ~0ull : (1ull << (1 << k)) - 1;
+        uint64_t flip = inv ? ~0ull : 0;
+        const uint64_t *x = &vals[(size_t)local[a] * words], *y = &vals[(size_t)local[b] * words];
+        for (int w = 0; w < words; w++) {
+            if ((x[w] ^ y[w] ^ flip) & mask) return 0;
+        }
+        return 1;
+    }
+};
+
+// Writes the netlist with equivalent signals merged to out (output cones
+// only; names kept). nl is rewritten on the way and only good for being
+// thrown away. Returns false, like buildSubjectGraph, on loops or malformed
+// gates.
+inline bool fraigNetlist(Netlist &nl, Netlist &out, FraigStats *stats = nullptr) {
+    FraigStats st;
+    NetlistFraig f(nl, st);
+    bool ok = f.run(out);
+    if (stats) *stats = st;
+    return ok;
+}
+
+#endif
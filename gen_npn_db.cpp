@@ -0,0 +1,45 @@
+// gen_npn_db.cpp
+// Builds the NPN database (npn_db.h) for the cell library compiled into
+// cell_library.h and writes it out. tech_map --npn rebuilds the file on its
+// own when it is missing or stale; this is for shipping it and for looking
+// at the table.
+//
+// Build: g++ -std=c++17 -O2 -o gen_npn_db gen_npn_db.cpp
+// Run:   ./gen_npn_db [npn4.db]
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "npn_db.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    string path = argc > 1 ? argv[1] : "npn4.db";
+    NpnDatabase db;
+    auto t0 = chrono::steady_clock::now();
+    db.generate();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    if (!db.write(path)) {
+        cerr << "Cannot write " << path << endl;
+        return 1;
+    }
+
+    // cost of each class in its own phase, bucketed
+    vector<int> histogram;
+    int cells = 0;
+    for (size_t k = 0; k < db.classes.size(); k++) {
+        const NpnEntry &e = db.entries[k * NPN_PHASES];
+        if ((int)histogram.size() <= e.cost) histogram.resize(e.cost + 1, 0);
+        histogram[e.cost]++;
+        for (int ph = 0; ph < NPN_PHASES; ph++) cells += (int)db.entries[k * NPN_PHASES + ph].cells.size();
+    }
+    cout << "Wrote " << path << ": " << db.classes.size() << " classes, " << cells << " cells, "
+         << ms << " ms" << endl;
+    cout << "Cost  classes" << endl;
+    for (size_t c = 0; c < histogram.size(); c++) {
+        if (histogram[c]) cout << c << "\t" << histogram[c] << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,318 @@
+// hierarchy.h
+// Hierarchical netlists: modules defined once and instantiated by name.
+//
+//   MODULE fa
+//   a INPUT
+//   b INPUT
+//   s = OR a b
+//   s OUTPUT
+//   ENDMODULE
+//   u1 INST fa x y        (module inputs by position)
+//   F = NOT u1.s          (module outputs as instance.port)
+//
+// Lines outside any MODULE block are the top level. Every module is mapped
+// once per boundary condition (which inputs are tied to 0/1 and which
+// outputs are read) and that cover is reused for all instances that share
+// it, so the work grows with the unique logic instead of the flattened size.
+// Cells never cross a module boundary.
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "mapper.h"
+#include "exact_cover.h"
+
+struct Instance {
+    std::string name;
+    std::string module;
+    std::vector<int> pins;   // signals of the parent driving the module inputs
+    int lineNo = 0;
+};
+
+struct Module {
+    std::string name;
+    Netlist body;              // instance outputs ("u1.s") are INPUTs of the body
+    std::vector<int> inputs;   // ports, in declaration order
+    std::vector<Instance> instances;
+};
+
+// One module mapped under one boundary condition
+struct ModuleMapping {
+    int cost = -1;           // including everything instantiated below it
+    int gates = 0;           // gates of its own logic that were mapped
+    int flatGates = 0;       // gates once the instances below are flattened
+    int flatInstances = 0;   // instances below it, flattened
+    std::string cover;
+};
+
+struct HierStats {
+    int modules = 0;   // modules defined
+    int mapped = 0;    // module/boundary combinations mapped
+    int reused = 0;    // instances that reused an earlier mapping
+};
+
+// True when the file uses MODULE blocks or instances
+inline bool isHierarchical(const std::string &fname) {
+    std::ifstream f(fname);
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, 7, "MODULE ") == 0 || line.find(" INST ") != std::string::npos) return true;
+    }
+    return false;
+}
+
+class HierarchicalMapper {
+public:
+    bool choices = false;
+    bool simplify = false;
+    bool fraig = false;
+    bool exact = false;
+    const NpnDatabase *npn = nullptr;
+    std::vector<Module> modules;   // modules[0] is the top level
+    std::unordered_map<std::string, int> moduleIds;
+    std::unordered_map<std::string, ModuleMapping> mapped;   // by boundary key
+    std::vector<std::string> mapOrder;   // keys in the order they were mapped, top last
+    HierStats stats;
+
+    bool readDesign(const std::string &fname) {
+        std::ifstream f(fname);
+        if (!f.is_open()) {
+            std::cerr << "Failed to open file: " << fname << std::endl;
+            return false;
+        }
+        modules.assign(1, Module());
+        moduleIds.clear();
+        int cur = 0;
+        int lineNo = 0;
+        std::string line;
+        auto fail = [&](const std::string &msg) {
+            std::cerr << fname << ":" << lineNo << ": " << msg << std::endl;
+            return false;
+        };
+        while (std::getline(f, line)) {
+            lineNo++;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            std::istringstream iss(line);
+            std::string nm, op;
+            iss >> nm >> op;
+            if (nm == "MODULE") {
+                if (cur != 0 || op.empty()) return fail("MODULE needs a name and cannot be nested");
+                if (moduleIds.count(op)) return fail("module '" + op + "' is defined twice");
+                moduleIds[op] = cur = (int)modules.size();
+                modules.emplace_back();
+                modules.back().name = op;
+                continue;
+            }
+            if (nm == "ENDMODULE") {
+                if (cur == 0) return fail("ENDMODULE without MODULE");
+                cur = 0;
+                continue;
+            }
+            Module &m = modules[cur];
+            if (op == "INST") {
+                Instance inst;
+                inst.name = nm;
+                inst.lineNo = lineNo;
+                if (!(iss >> inst.module)) return fail("INST needs a module name");
+                std::string p;
+                while (iss >> p) inst.pins.push_back(m.body.intern(p));
+                m.instances.push_back(std::move(inst));
+                continue;
+            }
+            if (!parseNetlistLine(line, m.body)) return fail("cannot parse '" + line + "'");
+            auto it = m.body.ids.find(nm);
+            if (op == "INPUT" && it != m.body.ids.end()) m.inputs.push_back(it->second);
+        }
+        if (cur != 0) return fail("missing ENDMODULE for module '" + modules[cur].name + "'");
+
+        // instance outputs become inputs of the instantiating module
+        for (Module &m : modules) {
+            for (const Instance &inst : m.instances) {
+                lineNo = inst.lineNo;
+                auto it = moduleIds.find(inst.module);
+                if (it == moduleIds.end()) return fail("unknown module '" + inst.module + "'");
+                const Module &def = modules[it->second];
+                if (inst.pins.size() != def.inputs.size())
+                    return fail("instance '" + inst.name + "' has " + std::to_string(inst.pins.size()) +
+                                " inputs, module '" + def.name + "' takes " + std::to_string(def.inputs.size()));
+                for (int o : def.body.outputs) {
+                    int id = m.body.intern(inst.name + "." + def.body.names[o]);
+                    if (m.body.gates[id].type != GateType::UNKNOWN)
+                        return fail("signal '" + m.body.names[id] + "' is driven twice");
+                    m.body.gates[id].type = GateType::INPUT;
+                }
+            }
+        }
+        stats.modules = (int)modules.size() - 1;
+        return !modules[0].body.outputs.empty();
+    }
+
+    // Maps the top level and, through it, every module instantiated with
+    // a new boundary condition. Returns the total area, or -1 on failure.
+    int calculateMinimalCost() {
+        mapped.clear();
+        mapOrder.clear();
+        stats.mapped = stats.reused = 0;
+        active.assign(modules.size(), 0);
+        const ModuleMapping *top = mapModule(0, std::string(modules[0].inputs.size(), 'x'),
+                                             std::vector<char>(modules[0].body.outputs.size(), 1));
+        return top ? top->cost : -1;
+    }
+
+    const ModuleMapping &topMapping() const { return mapped.at(mapOrder.back()); }
+
+    // Prints each mapped module as a MODULE block named by its boundary key
+    // (module:inputs:outputs, x = free input, 0/1 = tied), then the top level
+    void writeCover(std::ostream &out) const {
+        for (const std::string &key : mapOrder) {
+            bool isTop = &key == &mapOrder.back();
+            if (!isTop) out << "MODULE " << key << "\n";
+            out << mapped.at(key).cover;
+            if (!isTop) out << "ENDMODULE\n";
+        }
+    }
+
+private:
+    std::vector<char> active;   // modules on the current mapping path
+
+    std::string boundaryKey(int m, const std::string &tie, const std::vector<char> &used) const {
+        std::string key = modules[m].name + ":" + tie + ":";
+        for (char u : used) key += u ? '1' : '0';
+        return key;
+    }
+
+    // Marks the instances of mod whose outputs the signals in roots depend
+    // on, directly or through the pins of other live instances
+    std::vector<char> liveInstances(const Module &mod, const std::vector<int> &roots) const {
+        const Netlist &body = mod.body;
+        std::vector<int> owner(body.gates.size(), -1);   // instance driving each signal
+        for (size_t k = 0; k < mod.instances.size(); k++) {
+            const Instance &inst = mod.instances[k];
+            const Module &def = modules[moduleIds.at(inst.module)];
+            for (int o : def.body.outputs) owner[body.ids.at(inst.name + "." + def.body.names[o])] = (int)k;
+        }
+        std::vector<char> live(mod.instances.size(), 0), seen(body.gates.size(), 0);
+        std::vector<int> stack(roots);
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            if (seen[id]) continue;
+            seen[id] = 1;
+            int k = owner[id];
+            if (k >= 0 && !live[k]) {
+                live[k] = 1;
+                stack.insert(stack.end(), mod.instances[k].pins.begin(), mod.instances[k].pins.end());
+            }
+            stack.insert(stack.end(), body.gates[id].inputs.begin(), body.gates[id].inputs.end());
+        }
+        return live;
+    }
+
+    const ModuleMapping *mapModule(int m, const std::string &tie, const std::vector<char> &used) {
+        const Module &mod = modules[m];
+        std::string key = boundaryKey(m, tie, used);
+        auto found = mapped.find(key);
+        if (found != mapped.end()) {
+            stats.reused++;
+            return &found->second;
+        }
+        if (active[m]) {
+            std::cerr << "Module '" << mod.name << "' instantiates itself" << std::endl;
+            return nullptr;
+        }
+        active[m] = 1;
+
+        // the cones of the read outputs and of the pins of live instances,
+        // with the tied inputs turned into constants
+        Netlist nl = mod.body;
+        for (size_t i = 0; i < tie.size(); i++) {
+            if (tie[i] != 'x') nl.gates[mod.inputs[i]].type = tie[i] == '0' ? GateType::CONST0 : GateType::CONST1;
+        }
+        std::vector<int> outs;
+        for (size_t i = 0; i < used.size(); i++) {
+            if (used[i]) outs.push_back(mod.body.outputs[i]);
+        }
+        std::vector<char> live = liveInstances(mod, outs);
+        size_t firstPin = outs.size();
+        for (size_t k = 0; k < mod.instances.size(); k++) {
+            if (live[k]) outs.insert(outs.end(), mod.instances[k].pins.begin(), mod.instances[k].pins.end());
+        }
+
+        TechnologyMapper tm;
+        tm.choices = choices;
+        tm.simplify = simplify;
+        tm.fraig = fraig;
+        tm.npn = npn;
+        extractCone(nl, outs, tm.netlist);
+        ModuleMapping r;
+        r.cost = 0;
+        if (!outs.empty()) {
+            if (!tm.buildGraph() || (r.cost = tm.calculateMinimalCost()) < 0) {
+                std::cerr << "Module '" << mod.name << "' could not be mapped" << std::endl;
+                active[m] = 0;
+                return nullptr;
+            }
+            if (exact) r.cost = calculateExactCost(tm);
+            for (const Gate &g : tm.netlist.gates) {
+                if (g.type != GateType::INPUT && g.type != GateType::OUTPUT &&
+                    g.type != GateType::CONST0 && g.type != GateType::CONST1) r.gates++;
+            }
+            std::ostringstream cover;
+            tm.writeCover(cover);
+            r.cover = cover.str();
+        }
+        r.flatGates = r.gates;
+
+        // a pin is tied when it reduces to a constant here (always with
+        // --simplify, otherwise only for a direct 0/1); an instance output
+        // is read when it survived into the mapped cones
+        const Netlist &mn = tm.netlist;
+        size_t pin = firstPin;
+        for (size_t k = 0; k < mod.instances.size(); k++) {
+            if (!live[k]) continue;
+            const Instance &inst = mod.instances[k];
+            int c = moduleIds.at(inst.module);
+            const Module &def = modules[c];
+            std::string childTie;
+            std::vector<std::string> pinNames;
+            for (size_t i = 0; i < inst.pins.size(); i++) {
+                int id = mn.outputs[pin++];
+                pinNames.push_back(mn.names[id]);
+                while (mn.gates[id].type == GateType::OUTPUT) id = mn.gates[id].inputs[0];
+                GateType t = mn.gates[id].type;
+                childTie += t == GateType::CONST0 ? '0' : t == GateType::CONST1 ? '1' : 'x';
+            }
+            std::vector<char> childUsed;
+            bool any = false;
+            for (int o : def.body.outputs) {
+                childUsed.push_back(mn.ids.count(inst.name + "." + def.body.names[o]) > 0);
+                any = any || childUsed.back();
+            }
+            if (!any) continue;   // its readers folded away (--simplify)
+            const ModuleMapping *child = mapModule(c, childTie, childUsed);
+            if (!child) {
+                active[m] = 0;
+                return nullptr;
+            }
+            r.cost += child->cost;
+            r.flatGates += child->flatGates;
+            r.flatInstances += 1 + child->flatInstances;
+            r.cover += inst.name + " INST " + boundaryKey(c, childTie, childUsed);
+            for (const std::string &p : pinNames) r.cover += " " + p;
+            r.cover += "\n";
+        }
+
+        active[m] = 0;
+        stats.mapped++;
+        mapOrder.push_back(key);
+        return &(mapped[key] = std::move(r));
+    }
+};
+
+#endif
@@ -0,0 +1,618 @@
+// mapper.h
+// Covers the NAND2/NOT subject graph with cells from the technology table.
+// Same idea as the eval() pattern ladders in the older mappers, but run as one
+// bottom-up sweep over the subject graph with labels stored per node.
+#ifndef MAPPER_H
+#define MAPPER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+#include "cell_library.h"
+#include "netlist.h"
+#include "subject_graph.h"
+#include "simplify.h"
+#include "fraig.h"
+#include "npn_db.h"
+#include "compressed_input.h"
+#include "pipeline.h"
+#include "aiger.h"
+
+// One way to implement a subject node with a single library cell
+struct Match {
+    GateType cell;
+    uint8_t numLeaves;
+    int leaves[4];
+};
+
+static const int MAX_MATCHES = 8;
+static const int MAX_CUTS = 8;
+
+// A cut of a node: up to 4 leaves (sorted) and the node's function of them,
+// leaf l being input l of the truth table
+struct Cut {
+    uint8_t n;
+    int leaves[4];
+    uint16_t tt;
+};
+
+// Re-expresses a truth table over the leaves from as one over to, a superset
+inline uint16_t stretchCut(uint16_t tt, const Cut &from, const Cut &to) {
+    int pos[4] = {0, 0, 0, 0};
+    for (int i = 0, j = 0; i < from.n; i++) {
+        while (to.leaves[j] != from.leaves[i]) j++;
+        pos[i] = j;
+    }
+    uint16_t r = 0;
+    for (int x = 0; x < 16; x++) {
+        int y = 0;
+        for (int i = 0; i < from.n; i++) y |= ((x >> pos[i]) & 1) << i;
+        r |= (uint16_t)(((tt >> y) & 1) << x);
+    }
+    return r;
+}
+
+// Shape signatures. Every pattern lies within three levels of its root, so
+// the cell candidates of a node only depend on the types of that cone and
+// on which of its inner nodes have a single fan-out. Each node in the cone
+// gets a 2-bit code (SHAPE_NOT / SHAPE_NAND when it may sit inside a cell,
+// SHAPE_LEAF otherwise) and the codes are packed into one byte:
+//   NOT root:   bit 7 clear, bits 0-1 child, 2-3 child.in0, 4-5 child.in1
+//               (the last two only when the child is SHAPE_NAND)
+//   NAND2 root: bit 7 set, bits 0-1 in0, 2-3 in1
+// The candidates of a signature come from one table lookup.
+static const uint8_t SHAPE_LEAF = 0;
+static const uint8_t SHAPE_NOT = 1;
+static const uint8_t SHAPE_NAND = 2;
+static const uint8_t SHAPE_NONE = 0x7F;   // inputs: no cell roots there
+static const int SHAPE_COUNT = 256;
+
+// One pattern of the table. Nodes of the cone are numbered like a binary
+// heap: 1 is the root, 2k and 2k + 1 are in0 and in1 of node k.
+struct ShapePattern {
+    GateType cell;
+    uint8_t numLeaves;
+    uint8_t leaves[4];
+};
+
+struct ShapeEntry {
+    uint8_t count = 0;
+    uint8_t numNeeded = 0;
+    uint8_t needed[8];   // cone nodes the patterns read, parents first
+    ShapePattern patterns[MAX_MATCHES];
+};
+
+inline uint8_t shapeCode(const SubjectGraph &sg, const std::vector<int> &fanout, int id, bool allowShared) {
+    if (id < 0 || (!allowShared && fanout[id] != 1)) return SHAPE_LEAF;
+    GateType t = sg.nodes[id].type;
+    return t == GateType::NOT ? SHAPE_NOT : t == GateType::NAND2 ? SHAPE_NAND : SHAPE_LEAF;
+}
+
+// Unless allowShared is set, nodes inside a pattern (everything but the root
+// and the leaves) must have a single fan-out, otherwise the cell would
+// duplicate logic still needed elsewhere.
+inline uint8_t shapeSignature(const SubjectGraph &sg, const std::vector<int> &fanout, int node,
+                              bool allowShared = false) {
+    const SgNode &n = sg.nodes[node];
+    if (n.type == GateType::NAND2)
+        return (uint8_t)(0x80 | shapeCode(sg, fanout, n.in0, allowShared) |
+                         shapeCode(sg, fanout, n.in1, allowShared) << 2);
+    if (n.type != GateType::NOT) return SHAPE_NONE;
+    uint8_t c = shapeCode(sg, fanout, n.in0, allowShared);
+    if (c != SHAPE_NAND) return c;
+    const SgNode &m = sg.nodes[n.in0];
+    return (uint8_t)(c | shapeCode(sg, fanout, m.in0, allowShared) << 2 |
+                     shapeCode(sg, fanout, m.in1, allowShared) << 4);
+}
+
+// Shape codes of all nodes, stored at id + 1 so a missing fan-in (-1)
+// reads SHAPE_LEAF. One pass with no branches on the node type.
+inline void computeShapeCodes(const SubjectGraph &sg, const std::vector<int> &fanout, std::vector<uint8_t> &code) {
+    static const struct TypeShapes {
+        uint8_t code[GATE_TYPE_COUNT] = {};
+        TypeShapes() {
+            code[(int)GateType::NOT] = SHAPE_NOT;
+            code[(int)GateType::NAND2] = SHAPE_NAND;
+        }
+    } types;
+    int n = sg.size();
+    code.resize(n + 1);
+    code[0] = SHAPE_LEAF;
+    for (int i = 0; i < n; i++) code[i + 1] = (uint8_t)(fanout[i] == 1) * types.code[(int)sg.nodes[i].type];
+}
+
+// shapeSignature from the codes: every case is computed, then selected
+inline uint8_t shapeFromCodes(const SubjectGraph &sg, const std::vector<uint8_t> &code, int node) {
+    const SgNode &s = sg.nodes[node];
+    uint8_t c0 = code[s.in0 + 1], c1 = code[s.in1 + 1];
+    const SgNode &m = sg.nodes[std::max(s.in0, 0)];
+    uint8_t deep = (uint8_t)(code[m.in0 + 1] << 2 | code[m.in1 + 1] << 4);
+    uint8_t notSig = (uint8_t)(c0 | (c0 == SHAPE_NAND ? deep : 0));
+    uint8_t nandSig = (uint8_t)(0x80 | c0 | c1 << 2);
+    return s.type == GateType::NAND2 ? nandSig : s.type == GateType::NOT ? notSig : SHAPE_NONE;
+}
+
+// The cell patterns of every signature, built once
+inline const std::vector<ShapeEntry> &shapeTable() {
+    static std::vector<ShapeEntry> table;
+    if (!table.empty()) return table;
+    table.resize(SHAPE_COUNT);
+    for (int sig = 0; sig < SHAPE_COUNT; sig++) {
+        ShapeEntry &e = table[sig];
+        bool need[16] = {};
+        auto add = [&](GateType cell, std::initializer_list<uint8_t> leaves) {
+            ShapePattern &p = e.patterns[e.count++];
+            p.cell = cell;
+            p.numLeaves = (uint8_t)leaves.size();
+            int l = 0;
+            for (uint8_t x : leaves) {
+                p.leaves[l++] = x;
+                for (int k = x; k > 1; k /= 2) need[k] = true;
+            }
+        };
+        if (sig == SHAPE_NONE) continue;
+        if (sig & 0x80) {
+            add(GateType::NAND2, {2, 3});
+            // NAND(NOT a, NOT b) = OR2
+            if ((sig & 3) == SHAPE_NOT && (sig >> 2 & 3) == SHAPE_NOT) add(GateType::OR, {4, 6});
+        } else {
+            int c = sig & 3, x = sig >> 2 & 3, y = sig >> 4 & 3;
+            add(GateType::NOT, {2});
+            if (c == SHAPE_NAND) {
+                // NOT(NAND(x,y)) = AND2
+                add(GateType::AND, {4, 5});
+                // NOT(NAND(NOT a, NOT b)) = NOR2
+                if (x == SHAPE_NOT && y == SHAPE_NOT) add(GateType::NOR2, {8, 10});
+                // NOT(NAND(NAND(a,b), NOT c)) = AOI21
+                if (x == SHAPE_NAND && y == SHAPE_NOT) add(GateType::AOI21, {8, 9, 10});
+                if (y == SHAPE_NAND && x == SHAPE_NOT) add(GateType::AOI21, {10, 11, 8});
+                // NOT(NAND(NAND(a,b), NAND(c,d))) = AOI22
+                if (x == SHAPE_NAND && y == SHAPE_NAND) add(GateType::AOI22, {8, 9, 10, 11});
+            }
+        }
+        for (int k = 2; k < 16; k++)
+            if (need[k]) e.needed[e.numNeeded++] = (uint8_t)k;
+    }
+    return table;
+}
+
+// Fills the cone nodes the patterns of e read (cone[1] is node)
+inline void shapeCone(const SubjectGraph &sg, int node, const ShapeEntry &e, int *cone) {
+    cone[1] = node;
+    for (int j = 0; j < e.numNeeded; j++) {
+        int k = e.needed[j];
+        const SgNode &p = sg.nodes[cone[k >> 1]];
+        cone[k] = (k & 1) ? p.in1 : p.in0;
+    }
+}
+
+inline Match shapeMatch(const ShapePattern &p, const int *cone) {
+    Match m = {p.cell, p.numLeaves, {}};
+    for (int l = 0; l < p.numLeaves; l++) m.leaves[l] = cone[p.leaves[l]];
+    return m;
+}
+
+// Lists the cell patterns of a node whose signature is known
+inline int matchShape(const SubjectGraph &sg, int node, uint8_t sig, Match *out) {
+    const ShapeEntry &e = shapeTable()[sig];
+    int cone[16];
+    shapeCone(sg, node, e, cone);
+    for (int k = 0; k < e.count; k++) out[k] = shapeMatch(e.patterns[k], cone);
+    return e.count;
+}
+
+// Lists every cell pattern rooted at node
+inline int findMatches(const SubjectGraph &sg, const std::vector<int> &fanout, int node, Match *out,
+                       bool allowShared = false) {
+    return matchShape(sg, node, shapeSignature(sg, fanout, node, allowShared), out);
+}
+
+// Covers the subject graph. When the graph has choice classes, every member
+// of a class gets a label and the class is implemented by its cheapest
+// member (chosen); leaves always refer to a class through that member.
+class TechnologyMapper {
+public:
+    Netlist netlist;
+    SubjectGraph graph;
+    bool choices = false;        // record alternative structures while building
+    bool lazyParse = false;      // parse only the lines inside the output cones
+    std::vector<std::string> requestedOutputs;   // map these instead of the OUTPUT lines
+    bool simplify = false;       // fold constants and trivial logic before building
+    bool fraig = false;          // merge functionally equivalent signals before building
+    bool pipelined = false;      // tokenize on a second thread and build while reading
+    const NpnDatabase *npn = nullptr;   // also price 4-input cuts by their cheapest formula
+    ConeStats coneStats;
+    SimplifyStats simplifyStats;
+    FraigStats fraigStats;
+    PipelineStats pipelineStats;
+    bool aiger = false;          // the last file read was binary AIGER
+    AigerStats aigerStats;
+    std::vector<int> fanout;     // uses of each node inside the output cones
+    std::vector<int> label;      // best cost of the tree rooted at each node
+    std::vector<uint8_t> shapeCodes;  // shape code of each node under fanout, at id + 1
+    std::vector<Match> best;     // match that gives label (UNKNOWN: a cut, see cutFunc)
+    std::vector<uint16_t> cutFunc;   // function of the cut when best is one
+    std::vector<int> uses;       // uses of each class, by representative
+    std::vector<int> chosen;     // member implementing each class, by representative
+    std::vector<int> cover;      // nodes implemented by a cell, outputs first
+
+    bool readNetlist(const std::string &fname) {
+        aiger = isAigerFile(fname);
+        if (lazyParse) {
+            // the lazy reader indexes the file's text in place
+            if (aiger || detectInputFormat(fname) != InputFormat::PLAIN) {
+                std::cerr << fname << ": --lazy needs an uncompressed text netlist" << std::endl;
+                return false;
+            }
+            if (!readNetlistCone(fname, netlist, requestedOutputs, &coneStats)) return false;
+        } else {
+            // keep only the cones of the mapped outputs
+            Netlist full;
+            // the graph can be built while reading when nothing has to see
+            // the whole netlist first
+            bool stream = requestedOutputs.empty() && !simplify && !fraig && !choices;
+            bool streamed = false;
+            if (aiger) {
+                if (!readAiger(fname, full, stream ? &graph : nullptr, &aigerStats)) return false;
+                streamed = stream;
+            } else if (pipelined) {
+                if (!readNetlistPipelined(fname, full, stream ? &graph : nullptr, &pipelineStats)) return false;
+                streamed = pipelineStats.streamed;
+            } else if (!readNetlistFile(fname, full)) {
+                return false;
+            }
+            if (streamed) {
+                // gates outside the output cones stay in, unread
+                coneStats.signals = coneStats.kept = full.size();
+                netlist = std::move(full);
+                return true;
+            }
+            std::vector<int> outs = full.outputs;
+            if (!requestedOutputs.empty()) {
+                outs.clear();
+                for (const std::string &o : requestedOutputs) {
+                    auto it = full.ids.find(o);
+                    if (it == full.ids.end()) {
+                        std::cerr << "Unknown output '" << o << "'" << std::endl;
+                        return false;
+                    }
+                    outs.push_back(it->second);
+                }
+            }
+            extractCone(full, outs, netlist, &coneStats);
+        }
+        return buildGraph();
+    }
+
+    // Builds the subject graph of netlist, which must already hold only the
+    // cones to map (readNetlist does this; the hierarchical mapper fills
+    // netlist itself)
+    bool buildGraph() {
+        if (simplify) {
+            Netlist s;
+            if (!simplifyNetlist(netlist, s, &simplifyStats)) return false;
+            netlist = std::move(s);
+        }
+        if (fraig) {
+            Netlist f;
+            if (!fraigNetlist(netlist, f, &fraigStats)) return false;
+            netlist = std::move(f);
+        }
+        if (!buildSubjectGraph(netlist, graph, choices)) return false;
+        // the builder already emits nodes in DFS order from the outputs;
+        // alternatives are appended after it and need to be moved in
+        if (graph.choiceClasses > 0) reorderSubjectGraph(graph);
+        return true;
+    }
+
+    // Forgets the netlist, the graph and the last mapping but keeps their
+    // storage, so a mapper reused for many netlists allocates little
+    void clear() {
+        netlist.names.clear();
+        netlist.ids.clear();
+        netlist.gates.clear();
+        netlist.outputs.clear();
+        graph.nodes.clear();
+        graph.level.clear();
+        graph.source.clear();
+        graph.repr.clear();
+        graph.nextChoice.clear();
+        graph.outputs.clear();
+        graph.strash.clear();
+        graph.choiceClasses = graph.choiceNodes = 0;
+        cover.clear();
+        coneStats = ConeStats();
+        simplifyStats = SimplifyStats();
+        fraigStats = FraigStats();
+        pipelineStats = PipelineStats();
+        aiger = false;
+        aigerStats = AigerStats();
+    }
+
+    // Maps every output and returns the total area, or -1 on failure
+    int calculateMinimalCost() {
+        int n = graph.size();
+        chosen.resize(n);
+        for (int i = 0; i < n; i++) chosen[i] = i;
+        computeFanout();
+        mapNodes(false);
+        int total = extractCover();
+        // An alternative only pays off if the rest of the cover stops using
+        // the structure it replaces, so re-map with the fanout of the last
+        // cover while that keeps getting cheaper
+        for (int pass = 0; pass < MAX_CHOICE_PASSES && graph.choiceClasses > 0; pass++) {
+            std::vector<int> f = fanout, u = uses, lb = label, ch = chosen, cv = cover;
+            std::vector<Match> bs = best;
+            std::vector<uint16_t> cf = cutFunc;
+            computeFanout();
+            mapNodes(true);
+            int t = extractCover();
+            if (t >= total) {
+                fanout.swap(f); uses.swap(u); label.swap(lb); chosen.swap(ch); cover.swap(cv);
+                best.swap(bs);
+                cutFunc.swap(cf);
+                break;
+            }
+            total = t;
+        }
+        return total;
+    }
+
+    // Node that implements the function of subject node id
+    int impl(int id) const { return chosen[graph.repr[id]]; }
+
+    // Name used for a subject node in the cover listing
+    std::string nodeName(int id) const {
+        int r = graph.repr[id];
+        if (graph.source[r] >= 0) return netlist.names[graph.source[r]];
+        return "_n" + std::to_string(r);
+    }
+
+    // Lists every choice class whose alternative the mapper used, with the
+    // cost of the original structure and of the chosen one
+    void writeChoiceReport(std::ostream &out) const {
+        int used = 0, saved = 0;
+        for (int r = 0; r < graph.size(); r++) {
+            if (graph.repr[r] != r || graph.nextChoice[r] < 0 || chosen[r] == r) continue;
+            used++;
+            saved += label[r] - label[chosen[r]];
+            out << "  " << nodeName(r) << ": " << label[r] << " -> " << label[chosen[r]]
+                << " (saved " << label[r] - label[chosen[r]] << ")\n";
+        }
+        int base = graph.size() - graph.choiceNodes;
+        out << "Choices: " << graph.choiceClasses << " classes, " << graph.choiceNodes
+            << " extra nodes (" << (base ? 100 * graph.choiceNodes / base : 0) << "% of "
+            << base << "), " << used << " used, saved " << saved << "\n";
+    }
+
+    // Prints the chosen cells as a netlist, one "x = CELL a b" per line
+    void writeCover(std::ostream &out) const {
+        for (int id : cover) {
+            const Match &m = best[id];
+            if (m.cell == GateType::UNKNOWN) {
+                std::vector<std::string> leaves;
+                for (int l = 0; l < m.numLeaves; l++) leaves.push_back(nodeName(m.leaves[l]));
+                npn->writeFormula(out, nodeName(id), cutFunc[id], leaves);
+                continue;
+            }
+            out << nodeName(id) << " = " << gateTypeName(m.cell);
+            for (int l = 0; l < m.numLeaves; l++) out << " " << nodeName(m.leaves[l]);
+            out << "\n";
+        }
+        for (size_t i = 0; i < netlist.outputs.size(); i++) {
+            std::string name = netlist.names[netlist.outputs[i]];
+            if (name != nodeName(graph.outputs[i]))
+                out << name << " = " << nodeName(graph.outputs[i]) << "\n";
+        }
+    }
+
+    // Walks the chosen matches down from the outputs and sums their cells
+    int extractCover() {
+        cover.clear();
+        std::vector<char> done(graph.size(), 0);
+        std::vector<int> stack(graph.outputs.begin(), graph.outputs.end());
+        int total = 0;
+        while (!stack.empty()) {
+            int id = impl(stack.back());
+            stack.pop_back();
+            if (done[id] || graph.nodes[id].type == GateType::INPUT) continue;
+            done[id] = 1;
+            cover.push_back(id);
+            total += matchCost(id);
+            for (int l = 0; l < best[id].numLeaves; l++) stack.push_back(best[id].leaves[l]);
+        }
+        return total;
+    }
+
+    // Area of the cell (or cut formula) chosen for node id
+    int matchCost(int id) const {
+        return best[id].cell == GateType::UNKNOWN ? npn->cost(cutFunc[id]) : cellCost(best[id].cell);
+    }
+
+private:
+    static const int MAX_CHOICE_PASSES = 4;
+    std::vector<std::vector<Cut>> cuts;   // non-trivial cuts of each node
+
+    // A leaf that is shared or a primary input is paid for on its own
+    int leafCost(int leaf) const {
+        int r = graph.repr[leaf];
+        return uses[r] > 1 ? 0 : label[chosen[r]];
+    }
+
+    // Labels every node with fanout, in id order. Members of a class are newer
+    // than every class they read, so each class is settled before it is used.
+    void mapNodes(bool useChoices) {
+        int n = graph.size();
+        label.assign(n, 0);
+        best.assign(n, Match{GateType::INPUT, 0, {}});
+        if (npn) {
+            cutFunc.assign(n, 0);
+            cuts.assign(n, {});
+        }
+        for (int i = 0; i < n; i++) chosen[i] = i;
+        computeShapeCodes(graph, fanout, shapeCodes);
+        const std::vector<ShapeEntry> &table = shapeTable();
+        for (int i = 0; i < n; i++) {
+            if (fanout[i] == 0 || graph.nodes[i].type == GateType::INPUT) continue;
+            // price the patterns of the node's shape straight from its cone
+            const ShapeEntry &e = table[shapeFromCodes(graph, shapeCodes, i)];
+            int cone[16];
+            shapeCone(graph, i, e, cone);
+            int bestCost = std::numeric_limits<int>::max(), bestK = 0;
+            for (int j = 0; j < e.count; j++) {
+                const ShapePattern &p = e.patterns[j];
+                int c = cellCost(p.cell);
+                for (int l = 0; l < p.numLeaves; l++) c += leafCost(cone[p.leaves[l]]);
+                if (c < bestCost) {
+                    bestCost = c;
+                    bestK = j;
+                }
+            }
+            best[i] = shapeMatch(e.patterns[bestK], cone);
+            if (npn) mapCuts(i, bestCost);
+            label[i] = bestCost;
+            int r = graph.repr[i];
+            if (useChoices && i != r && label[i] < label[chosen[r]]) chosen[r] = i;
+        }
+    }
+
+    // Enumerates the cuts of node i from those of its fan-ins and takes the
+    // cheapest one when its formula beats the best single cell. As with the
+    // cell patterns, a cut only grows through fan-ins with one fan-out.
+    void mapCuts(int i, int &bestCost) {
+        const SgNode &s = graph.nodes[i];
+        std::vector<Cut> &cs = cuts[i];
+        auto faninCuts = [&](int id) {
+            std::vector<Cut> r = {Cut{1, {id}, NPN_VAR[0]}};
+            if (fanout[id] == 1 && graph.nodes[id].type != GateType::INPUT)
+                r.insert(r.end(), cuts[id].begin(), cuts[id].end());
+            return r;
+        };
+        if (s.type == GateType::NOT) {
+            for (Cut c : faninCuts(s.in0)) {
+                c.tt = (uint16_t)~c.tt;
+                cs.push_back(c);
+            }
+        } else if (s.type == GateType::NAND2) {
+            std::vector<Cut> as = faninCuts(s.in0), bs = faninCuts(s.in1);
+            for (const Cut &a : as) {
+                for (const Cut &b : bs) {
+                    Cut c;
+                    int u[8];
+                    int *end = std::set_union(a.leaves, a.leaves + a.n, b.leaves, b.leaves + b.n, u);
+                    if (end - u > 4) continue;
+                    std::copy(u, end, c.leaves);
+                    c.n = (uint8_t)(end - u);
+                    c.tt = (uint16_t)~(stretchCut(a.tt, a, c) & stretchCut(b.tt, b, c));
+                    cs.push_back(c);
+                }
+            }
+        }
+        std::stable_sort(cs.begin(), cs.end(), [](const Cut &a, const Cut &b) { return a.n < b.n; });
+        std::vector<Cut> kept;
+        for (const Cut &c : cs) {
+            bool dup = false;
+            for (const Cut &k : kept) dup = dup || (k.n == c.n && std::equal(c.leaves, c.leaves + c.n, k.leaves));
+            if (!dup && (int)kept.size() < MAX_CUTS) kept.push_back(c);
+        }
+        cs.swap(kept);
+        for (const Cut &c : cs) {
+            int cost = npn->cost(c.tt);
+            for (int l = 0; l < c.n; l++) cost += leafCost(c.leaves[l]);
+            if (cost < bestCost) {
+                bestCost = cost;
+                best[i] = Match{GateType::UNKNOWN, c.n, {}};
+                std::copy(c.leaves, c.leaves + c.n, best[i].leaves);
+                cutFunc[i] = c.tt;
+            }
+        }
+    }
+
+    // Counts the uses of every node in the current cover, where each class is
+    // implemented by its chosen member. Nodes only found in the other members
+    // are counted within the cone of one member at a time (the members exclude
+    // each other), and every member gets a label.
+    void computeFanout() {
+        int n = graph.size();
+        fanout.assign(n, 0);
+        for (int o : graph.outputs) fanout[o]++;
+        if (graph.choiceClasses == 0) {
+            for (int i = n - 1; i >= 0; i--) {
+                if (fanout[i] == 0) continue;
+                const SgNode &s = graph.nodes[i];
+                if (s.in0 >= 0) fanout[s.in0]++;
+                if (s.in1 >= 0) fanout[s.in1]++;
+            }
+            uses = fanout;
+            return;
+        }
+
+        uses.assign(n, 0);
+        for (int o : graph.outputs) {
+            if (impl(o) != o) fanout[impl(o)]++;
+            uses[graph.repr[o]]++;
+        }
+        std::vector<char> active(n, 0), labelled(n, 0);
+        std::vector<int> stack(graph.outputs.begin(), graph.outputs.end());
+        std::vector<int> members;
+        auto addClass = [&](int id) {
+            for (int m = graph.repr[id]; m >= 0; m = graph.nextChoice[m]) members.push_back(m);
+        };
+        while (!stack.empty()) {
+            int id = impl(stack.back());
+            stack.pop_back();
+            if (active[id]) continue;
+            active[id] = labelled[id] = 1;
+            addClass(id);
+            const SgNode &s = graph.nodes[id];
+            for (int in : {s.in0, s.in1}) {
+                if (in < 0) continue;
+                fanout[in]++;
+                if (impl(in) != in) fanout[impl(in)]++;
+                uses[graph.repr[in]]++;
+                stack.push_back(in);
+            }
+        }
+
+        std::vector<int> localFanout(n, 0), localUses(n, 0), cone;
+        for (size_t k = 0; k < members.size(); k++) {
+            int m = members[k];
+            if (labelled[m]) continue;
+            cone.assign(1, m);
+            labelled[m] = 1;
+            for (size_t c = 0; c < cone.size(); c++) {
+                const SgNode &s = graph.nodes[cone[c]];
+                for (int in : {s.in0, s.in1}) {
+                    if (in < 0 || active[in]) continue;
+                    localFanout[in]++;
+                    if (!active[impl(in)]) localUses[graph.repr[in]]++;
+                    if (labelled[in]) continue;
+                    labelled[in] = 1;
+                    cone.push_back(in);
+                    addClass(in);
+                }
+            }
+            for (int id : cone) {
+                for (int in : {graph.nodes[id].in0, graph.nodes[id].in1}) {
+                    if (in < 0) continue;
+                    fanout[in] = std::max(fanout[in], localFanout[in]);
+                    uses[graph.repr[in]] = std::max(uses[graph.repr[in]], localUses[graph.repr[in]]);
+                }
+            }
+            for (int id : cone) {
+                for (int in : {graph.nodes[id].in0, graph.nodes[id].in1}) {
+                    if (in < 0) continue;
+                    localFanout[in] = 0;
+                    localUses[graph.repr[in]] = 0;
+                }
+            }
+            fanout[m] = std::max(fanout[m], 1);
+        }
+    }
+};
+
+#endif
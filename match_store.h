@@ -0,0 +1,182 @@
+// match_store.h
+// Every candidate match of a mapped subject graph, kept in one flat buffer so
+// the cover can be re-priced under other cell costs without parsing or
+// pattern matching again. The matches and the shared/tree split only depend
+// on the graph, not on the costs, so a re-cost is one linear DP sweep.
+//
+//   MatchStore ms;
+//   ms.build(tm);                      // after tm.calculateMinimalCost()
+//   CostTable c = defaultCostTable();
+//   c[(int)GateType::NAND2] = 2;
+//   int area = ms.cost(c);
+#ifndef MATCH_STORE_H
+#define MATCH_STORE_H
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "cell_library.h"
+#include "mapper.h"
+
+using CostTable = std::array<int, GATE_TYPE_COUNT>;
+
+inline CostTable defaultCostTable() {
+    CostTable c;
+    for (int t = 0; t < GATE_TYPE_COUNT; t++) c[t] = CELL_COST[t];
+    return c;
+}
+
+class MatchStore {
+public:
+    // Slots are the mapped nodes in topological order, from 1; slot 0 stands
+    // for every leaf that is paid for on its own (inputs and shared nodes)
+    // and always costs 0.
+    std::vector<uint32_t> nodeEnd;   // slot -> end of its matches in code
+    // Per match: the cell, then 4 leaf slots (unused ones point at slot 0),
+    // so the sweep runs without branching on the pattern
+    std::vector<uint32_t> code;
+    std::vector<uint32_t> roots;     // slots whose label is paid: outputs and shared nodes
+
+    // Records the matches of tm's last mapping. Cut formulas (--npn) and
+    // choice classes are priced outside the cell table, so those mappings
+    // cannot be stored.
+    bool build(const TechnologyMapper &tm) {
+        const SubjectGraph &g = tm.graph;
+        if (tm.npn || g.choiceClasses > 0) return false;
+        int n = g.size();
+        std::vector<uint32_t> slot(n, 0);
+        nodeEnd.assign(1, 0);
+        code.clear();
+        roots.clear();
+        for (int i = 0; i < n; i++) {
+            if (tm.fanout[i] == 0 || g.nodes[i].type == GateType::INPUT) continue;
+            Match m[MAX_MATCHES];
+            int k = findMatches(g, tm.fanout, i, m);
+            for (int j = 0; j < k; j++) {
+                code.push_back((uint32_t)m[j].cell);
+                for (int l = 0; l < 4; l++) {
+                    int leaf = l < m[j].numLeaves ? m[j].leaves[l] : -1;
+                    code.push_back(leaf < 0 || tm.uses[leaf] > 1 ? 0 : slot[leaf]);
+                }
+            }
+            slot[i] = (uint32_t)nodeEnd.size();
+            nodeEnd.push_back((uint32_t)code.size());
+            if (tm.uses[i] > 1) roots.push_back(slot[i]);
+        }
+        // an output read once is paid for as the root of its own tree
+        std::vector<char> seen(n, 0);
+        for (int o : g.outputs) {
+            if (slot[o] == 0 || tm.uses[o] > 1 || seen[o]) continue;
+            seen[o] = 1;
+            roots.push_back(slot[o]);
+        }
+        label.assign(nodeEnd.size(), 0);
+        return true;
+    }
+
+    int nodes() const { return (int)nodeEnd.size() - 1; }
+
+    // Bytes held by the buffers
+    size_t bytes() const {
+        return (nodeEnd.capacity() + code.capacity() + roots.capacity() + label.capacity()) * sizeof(uint32_t);
+    }
+
+    // Area of the cover the tree DP picks under costs. Gives the same
+    // result as mapping again with costs compiled into CELL_COST.
+    int cost(const CostTable &costs) {
+        const uint32_t *c = code.data();
+        uint32_t pc = 0;
+        for (size_t s = 1; s < nodeEnd.size(); s++) {
+            uint32_t end = nodeEnd[s];
+            uint32_t best = UINT32_MAX;
+            for (; pc < end; pc += 5) {
+                uint32_t v = (uint32_t)costs[c[pc]] + label[c[pc + 1]] + label[c[pc + 2]] +
+                             label[c[pc + 3]] + label[c[pc + 4]];
+                best = std::min(best, v);
+            }
+            label[s] = best;
+        }
+        uint32_t total = 0;
+        for (uint32_t r : roots) total += label[r];
+        return (int)total;
+    }
+
+    // Prices every cost vector in costs, 16 at a time: each slot
+    // carries one label per lane and the min/add of the DP runs across the
+    // lanes together (AVX2 or AVX-512 when the build enables them)
+    void cost(const std::vector<CostTable> &costs, std::vector<int> &totals) {
+        totals.resize(costs.size());
+        size_t i = 0;
+        for (; i + 16 <= costs.size(); i += 16) costLanes<16>(&costs[i], &totals[i]);
+        for (; i + 8 <= costs.size(); i += 8) costLanes<8>(&costs[i], &totals[i]);
+        for (; i < costs.size(); i++) totals[i] = cost(costs[i]);
+    }
+
+    // One sweep over K cost vectors at once
+    template <int K>
+    void costLanes(const CostTable *costs, int *totals) {
+        // cell-major cost table so a match reads its K costs in one go
+        std::vector<uint32_t> cellCost(GATE_TYPE_COUNT * K);
+        for (int t = 0; t < GATE_TYPE_COUNT; t++)
+            for (int k = 0; k < K; k++) cellCost[t * K + k] = (uint32_t)costs[k][t];
+        if (lanes.size() < nodeEnd.size() * K) lanes.resize(nodeEnd.size() * K);
+        uint32_t *lab = lanes.data();
+        std::fill(lab, lab + K, 0u);
+        const uint32_t *c = code.data();
+        uint32_t pc = 0;
+        for (size_t s = 1; s < nodeEnd.size(); s++) {
+            uint32_t end = nodeEnd[s];
+            uint32_t *best = lab + s * K;
+            std::fill(best, best + K, UINT32_MAX);
+            for (; pc < end; pc += 5) {
+                minLanes<K>(best, cellCost.data() + c[pc] * K, lab + c[pc + 1] * K, lab + c[pc + 2] * K,
+                            lab + c[pc + 3] * K, lab + c[pc + 4] * K);
+            }
+        }
+        for (int k = 0; k < K; k++) totals[k] = 0;
+        for (uint32_t r : roots)
+            for (int k = 0; k < K; k++) totals[k] += (int)lab[r * K + k];
+    }
+
+private:
+    std::vector<uint32_t> label;   // by slot; label[0] stays 0
+    std::vector<uint32_t> lanes;   // slot * K + lane, for costLanes
+
+    // best = min(best, a + b + c + d + e), lane by lane
+    template <int K>
+    static void minLanes(uint32_t *best, const uint32_t *a, const uint32_t *b, const uint32_t *c,
+                         const uint32_t *d, const uint32_t *e) {
+#if defined(__AVX512F__)
+        if (K % 16 == 0) {
+            for (int k = 0; k < K; k += 16) {
+                __m512i v = _mm512_add_epi32(_mm512_loadu_si512(a + k), _mm512_loadu_si512(b + k));
+                v = _mm512_add_epi32(v, _mm512_loadu_si512(c + k));
+                v = _mm512_add_epi32(v, _mm512_add_epi32(_mm512_loadu_si512(d + k), _mm512_loadu_si512(e + k)));
+                // maskz form: GCC 12 warns on the plain one's undefined operand
+                _mm512_storeu_si512(best + k, _mm512_maskz_min_epu32(0xFFFF, _mm512_loadu_si512(best + k), v));
+            }
+            return;
+        }
+#endif
+#if defined(__AVX2__)
+        if (K % 8 == 0) {
+            for (int k = 0; k < K; k += 8) {
+                auto load = [&](const uint32_t *p) { return _mm256_loadu_si256((const __m256i *)(p + k)); };
+                __m256i v = _mm256_add_epi32(load(a), load(b));
+                v = _mm256_add_epi32(v, load(c));
+                v = _mm256_add_epi32(v, _mm256_add_epi32(load(d), load(e)));
+                _mm256_storeu_si256((__m256i *)(best + k), _mm256_min_epu32(load(best), v));
+            }
+            return;
+        }
+#endif
+        for (int k = 0; k < K; k++) best[k] = std::min(best[k], a[k] + b[k] + c[k] + d[k] + e[k]);
+    }
+};
+
+#endif
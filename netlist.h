@@ -0,0 +1,338 @@
+// netlist.h
+// Parsed netlist with interned signal names: every signal gets an int id and
+// gates refer to their fan-ins by id instead of by string.
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <string_view>
+#include <iterator>
+#include <algorithm>
+
+#include "cell_library.h"
+
+// Driver of one signal. Primary inputs are INPUT, a plain "x = y" is OUTPUT
+// (a buffer), the signals "0" and "1" are CONST0/CONST1, and a signal that is
+// used but never defined stays UNKNOWN.
+struct Gate {
+    GateType type = GateType::UNKNOWN;
+    std::vector<int> inputs;
+};
+
+struct Netlist {
+    std::vector<std::string> names;             // id -> signal name
+    std::unordered_map<std::string, int> ids;   // signal name -> id
+    std::vector<Gate> gates;                    // id -> driver
+    std::vector<int> outputs;                   // ids of the OUTPUT signals
+
+    int intern(const std::string &name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        int id = (int)names.size();
+        ids.emplace(name, id);
+        names.push_back(name);
+        gates.emplace_back();
+        if (name == "0") gates.back().type = GateType::CONST0;
+        if (name == "1") gates.back().type = GateType::CONST1;
+        return id;
+    }
+
+    int size() const { return (int)names.size(); }
+};
+
+// Parses one netlist line into nl. Returns false on a malformed line.
+inline bool parseNetlistLine(const std::string &line, Netlist &nl) {
+    if (line.empty() || line.rfind("Test", 0) == 0 || line.rfind("Script", 0) == 0)
+        return true;
+    std::istringstream iss(line);
+    std::string nm, op;
+    if (!(iss >> nm)) return true;
+    iss >> op;
+    if (op == "INPUT") {
+        nl.gates[nl.intern(nm)].type = GateType::INPUT;
+    } else if (op == "OUTPUT") {
+        nl.outputs.push_back(nl.intern(nm));
+    } else if (op == "=") {
+        std::string gt;
+        if (!(iss >> gt)) return false;
+        std::vector<std::string> args;
+        std::string a;
+        while (iss >> a) args.push_back(a);
+
+        int id = nl.intern(nm);
+        Gate &g = nl.gates[id];
+        if (args.empty()) {
+            // "F = t5" just renames another signal
+            g.type = GateType::OUTPUT;
+            args.push_back(gt);
+        } else {
+            g.type = parseGateType(gt);
+        }
+        if (g.type == GateType::UNKNOWN || g.type == GateType::INPUT) return false;
+
+        std::vector<int> in;
+        in.reserve(args.size());
+        for (const std::string &s : args) in.push_back(nl.intern(s));
+        nl.gates[id].inputs = std::move(in);   // intern() may have moved gates
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Reads a netlist file in the "t1 = AND b c" format. AND and OR may have any
+// number of inputs.
+inline bool readNetlist(const std::string &fname, Netlist &nl) {
+    std::ifstream f(fname);
+    if (!f.is_open()) {
+        std::cerr << "Failed to open file: " << fname << std::endl;
+        return false;
+    }
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(f, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!parseNetlistLine(line, nl)) {
+            std::cerr << fname << ":" << lineNo << ": cannot parse '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+    return !nl.outputs.empty();
+}
+
+// Checks that a gate has as many inputs as its type needs
+inline bool validArity(const Gate &g) {
+    size_t n = g.inputs.size();
+    switch (g.type) {
+        case GateType::INPUT:
+        case GateType::CONST0:
+        case GateType::CONST1: return n == 0;
+        case GateType::NOT:
+        case GateType::OUTPUT: return n == 1;
+        case GateType::AND:
+        case GateType::OR: return n >= 1;
+        case GateType::NAND2:
+        case GateType::NOR2: return n == 2;
+        case GateType::AOI21: return n == 3;
+        case GateType::AOI22: return n == 4;
+        default: return false;
+    }
+}
+
+// Finds every combinational loop with Tarjan's SCC algorithm, iteratively so
+// deep netlists don't overflow the stack. Each loop is a strongly connected
+// set of signals of size > 1, or a gate that reads itself. Linear in the
+// number of gate inputs. fanins(v) gives the inputs of signal v as a range
+// with size() and [], so other netlist layouts can share the check.
+template <typename Fanins>
+std::vector<std::vector<int>> findLoopsIn(int n, Fanins fanins) {
+    std::vector<int> index(n, -1), low(n, 0);
+    std::vector<char> onStack(n, 0);
+    std::vector<int> sccStack;
+    std::vector<std::pair<int, size_t>> dfs;   // signal, next input to follow
+    std::vector<std::vector<int>> loops;
+    int counter = 0;
+    for (int root = 0; root < n; root++) {
+        if (index[root] >= 0) continue;
+        dfs.push_back({root, 0});
+        index[root] = low[root] = counter++;
+        sccStack.push_back(root);
+        onStack[root] = 1;
+        while (!dfs.empty()) {
+            int v = dfs.back().first;
+            const auto &in = fanins(v);
+            if (dfs.back().second < in.size()) {
+                int w = in[dfs.back().second++];
+                if (index[w] < 0) {
+                    index[w] = low[w] = counter++;
+                    sccStack.push_back(w);
+                    onStack[w] = 1;
+                    dfs.push_back({w, 0});
+                } else if (onStack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+            dfs.pop_back();
+            if (!dfs.empty()) low[dfs.back().first] = std::min(low[dfs.back().first], low[v]);
+            if (low[v] != index[v]) continue;
+            std::vector<int> scc;
+            int w;
+            do {
+                w = sccStack.back();
+                sccStack.pop_back();
+                onStack[w] = 0;
+                scc.push_back(w);
+            } while (w != v);
+            bool selfLoop = false;
+            for (size_t k = 0; k < in.size(); k++) selfLoop = selfLoop || (int)in[k] == v;
+            if (scc.size() > 1 || selfLoop) {
+                std::sort(scc.begin(), scc.end());
+                loops.push_back(std::move(scc));
+            }
+        }
+    }
+    return loops;
+}
+
+inline std::vector<std::vector<int>> findLoops(const Netlist &nl) {
+    return findLoopsIn(nl.size(), [&](int v) -> const std::vector<int> & { return nl.gates[v].inputs; });
+}
+
+// Prints every loop as "Combinational loop: a b c" and returns how many
+// there are. A netlist with loops can't be mapped.
+inline int reportLoops(const Netlist &nl, std::ostream &err = std::cerr) {
+    std::vector<std::vector<int>> loops = findLoops(nl);
+    for (const std::vector<int> &loop : loops) {
+        err << "Combinational loop:";
+        for (int id : loop) err << " " << nl.names[id];
+        err << std::endl;
+    }
+    return (int)loops.size();
+}
+
+// Loop check for the programs that keep their own parser: reads fname with
+// parseNetlistLine, skipping lines it can't parse, and reports its loops
+inline int reportFileLoops(const std::string &fname, std::ostream &err = std::cerr) {
+    std::ifstream f(fname);
+    Netlist nl;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        parseNetlistLine(line, nl);
+    }
+    return reportLoops(nl, err);
+}
+
+// Sizes reported by the cone extraction
+struct ConeStats {
+    int signals = 0;   // signals (or definition lines, when lazy) in the file
+    int kept = 0;      // signals in the fan-in cone of the requested outputs
+};
+
+// Copies the transitive fan-in cone of outs into cone, renumbered densely.
+// Signal names, gate types and input order are kept, and outs become the
+// outputs of cone.
+inline void extractCone(const Netlist &nl, const std::vector<int> &outs, Netlist &cone,
+                        ConeStats *stats = nullptr) {
+    std::vector<int> newId(nl.size(), -1);
+    std::vector<int> stack, kept;
+    auto visit = [&](int id) {
+        if (newId[id] >= 0) return;
+        newId[id] = 0;
+        kept.push_back(id);
+        stack.push_back(id);
+    };
+    for (int o : outs) visit(o);
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        for (int in : nl.gates[id].inputs) visit(in);
+    }
+    // names go in in discovery order, with the table sized once
+    cone.ids.reserve(cone.ids.size() + kept.size());
+    cone.names.reserve(cone.names.size() + kept.size());
+    cone.gates.reserve(cone.gates.size() + kept.size());
+    for (int id : kept) newId[id] = cone.intern(nl.names[id]);
+    for (int id = 0; id < nl.size(); id++) {
+        if (newId[id] < 0) continue;
+        Gate &g = cone.gates[newId[id]];
+        g.type = nl.gates[id].type;
+        for (int in : nl.gates[id].inputs) g.inputs.push_back(newId[in]);
+    }
+    for (int o : outs) cone.outputs.push_back(newId[o]);
+    if (stats) {
+        stats->signals = nl.size();
+        stats->kept = cone.size();
+    }
+}
+
+// Reads only the fan-in cone of the requested outputs (all OUTPUT lines when
+// outputs is empty). The file is indexed by the name each line defines and a
+// line is parsed only once the cone reaches its signal, so gates outside the
+// cone never get an id, a name string or an input list.
+inline bool readNetlistCone(const std::string &fname, Netlist &nl,
+                            const std::vector<std::string> &outputs, ConeStats *stats = nullptr) {
+    std::ifstream f(fname, std::ios::binary);
+    if (!f.is_open()) {
+        std::cerr << "Failed to open file: " << fname << std::endl;
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+    struct LineRef { size_t start; size_t len; int lineNo; };
+    std::unordered_map<std::string_view, LineRef> defs;
+    std::unordered_map<std::string_view, char> declaredInput;
+    std::vector<std::string_view> declaredOutputs;
+    auto token = [&](size_t &p, size_t end) {
+        while (p < end && (text[p] == ' ' || text[p] == '\t')) p++;
+        size_t b = p;
+        while (p < end && text[p] != ' ' && text[p] != '\t') p++;
+        return std::string_view(text.data() + b, p - b);
+    };
+    int lineNo = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        size_t len = end - pos;
+        if (len > 0 && text[pos + len - 1] == '\r') len--;
+        lineNo++;
+        size_t p = pos;
+        std::string_view nm = token(p, pos + len);
+        std::string_view op = token(p, pos + len);
+        if (nm.empty() || nm.substr(0, 4) == "Test" || nm.substr(0, 6) == "Script") {
+            pos = end + 1;
+            continue;
+        }
+        if (op == "INPUT") {
+            declaredInput[nm] = 1;
+        } else if (op == "OUTPUT") {
+            declaredOutputs.push_back(nm);
+        } else if (op == "=") {
+            defs[nm] = {pos, len, lineNo};
+        } else {
+            std::cerr << fname << ":" << lineNo << ": cannot parse '" << text.substr(pos, len) << "'" << std::endl;
+            return false;
+        }
+        pos = end + 1;
+    }
+
+    std::vector<int> outs;
+    if (outputs.empty()) {
+        for (std::string_view o : declaredOutputs) outs.push_back(nl.intern(std::string(o)));
+    } else {
+        for (const std::string &o : outputs) {
+            if (!defs.count(o) && !declaredInput.count(o)) {
+                std::cerr << "Unknown output '" << o << "'" << std::endl;
+                return false;
+            }
+            outs.push_back(nl.intern(o));
+        }
+    }
+    // every signal interned so far or by a parsed line is in the cone
+    for (int next = 0; next < nl.size(); next++) {
+        std::string_view name = nl.names[next];
+        if (declaredInput.count(name)) nl.gates[next].type = GateType::INPUT;
+        auto it = defs.find(name);
+        if (it == defs.end()) continue;
+        std::string line = text.substr(it->second.start, it->second.len);
+        if (!parseNetlistLine(line, nl)) {
+            std::cerr << fname << ":" << it->second.lineNo << ": cannot parse '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+    nl.outputs = outs;
+    if (stats) {
+        stats->signals = (int)(defs.size() + declaredInput.size());
+        stats->kept = nl.size();
+    }
+    return !nl.outputs.empty();
+}
+
+#endif
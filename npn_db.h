@@ -0,0 +1,367 @@
+// npn_db.h
+// Cheapest implementation of every 4-input function in the cell library,
+// stored per NPN class (222 classes). The functions of an NPN class are
+// the same function up to input permutation, input negation and output
+// negation. Permuting inputs costs nothing, but negations cost inverters, so
+// each class keeps all 32 negation phases of its representative. Any 4-input
+// truth table is then priced by one lookup into the class map.
+//
+// Costs are for trees of cells over the 4 inputs, as in the mapper's DP:
+// an input may be read by several cells, an inner signal by one.
+#ifndef NPN_DB_H
+#define NPN_DB_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "cell_library.h"
+
+static const uint32_t NPN_DB_VERSION = 1;
+static const int NPN_PHASES = 32;   // input negation mask * 2 + output negation
+
+// Truth tables of the four inputs; bit x of a table is the value for the
+// input pattern x, with input i in bit i of x
+static const uint16_t NPN_VAR[4] = {0xAAAA, 0xCCCC, 0xF0F0, 0xFF00};
+
+// Operands of a formula cell: 0-3 are the inputs, 4/5 the constants 0/1,
+// 8 + k is cell k of the same formula
+static const uint8_t NPN_CONST0 = 4;
+static const uint8_t NPN_CELL = 8;
+static const uint8_t NPN_NONE = 0xFF;
+
+struct NpnCell {
+    GateType type;
+    uint8_t in[4];
+};
+
+// Cells in topological order; the last one (or root, for a bare input or
+// constant) is the output
+struct NpnEntry {
+    uint8_t cost = 0;
+    uint8_t root = 0;
+    std::vector<NpnCell> cells;
+};
+
+// The 24 orderings of 4 inputs
+inline const std::vector<std::vector<int>> &npnPerms() {
+    static std::vector<std::vector<int>> perms;
+    if (perms.empty()) {
+        std::vector<int> p = {0, 1, 2, 3};
+        do perms.push_back(p); while (std::next_permutation(p.begin(), p.end()));
+    }
+    return perms;
+}
+
+// g(x) = outNeg ^ f(y), where y_i = x_perm[i] ^ bit i of inMask
+inline uint16_t npnTransform(uint16_t f, const std::vector<int> &perm, int inMask, int outNeg) {
+    uint16_t g = 0;
+    for (int x = 0; x < 16; x++) {
+        int y = 0;
+        for (int i = 0; i < 4; i++) y |= (((x >> perm[i]) ^ (inMask >> i)) & 1) << i;
+        g |= (uint16_t)((((f >> y) & 1) ^ outNeg) << x);
+    }
+    return g;
+}
+
+class NpnDatabase {
+public:
+    std::vector<uint16_t> classes;   // representative (smallest truth table) of each class
+    std::vector<NpnEntry> entries;   // class * NPN_PHASES + phase
+    uint64_t libraryHash = 0;
+    bool regenerated = false;        // load() had to rebuild the table
+
+    // Cheapest tree cost of the function tt
+    int cost(uint16_t tt) const {
+        const Canon &c = canon[tt];
+        return entries[c.cls * NPN_PHASES + c.phase].cost;
+    }
+
+    // Reads path, or generates the table and writes it there when the file
+    // is missing or was built for a different library
+    bool load(const std::string &path) {
+        regenerated = false;
+        if (!read(path) || libraryHash != cellLibraryHash()) {
+            generate();
+            regenerated = true;
+            if (!write(path)) std::cerr << "Cannot write " << path << std::endl;
+        }
+        buildCanon();
+        return true;
+    }
+
+    // Exhaustive search in order of cost: every function reachable at cost
+    // c is found before any at c + 1. Two side tables hold the cheapest
+    // pair of subtrees whose AND (resp. OR) gives a function, without the
+    // cell that combines them, which prices AND2/NAND2, OR2/NOR2 and the AOI
+    // sum terms alike. A few seconds.
+    void generate() {
+        const int N = 1 << 16;
+        const uint8_t INF = 0xFF;
+        cost_.assign(N, INF);
+        std::vector<uint8_t> andPair(N, INF), orPair(N, INF);
+        how.assign(N, How());
+        andArgs.assign(N, {0, 0});
+        orArgs.assign(N, {0, 0});
+        std::vector<std::vector<uint16_t>> byCost(256), andByCost(256), orByCost(256);
+
+        int found = 0;
+        auto reach = [&](uint16_t f, int c, GateType t, uint16_t a, uint16_t b) {
+            if (cost_[f] != INF) return;
+            cost_[f] = (uint8_t)c;
+            how[f] = {t, a, b};
+            byCost[c].push_back(f);
+            found++;
+        };
+        for (int i = 0; i < 4; i++) reach(NPN_VAR[i], 0, GateType::INPUT, 0, 0);
+        reach(0, 0, GateType::CONST0, 0, 0);
+        reach(0xFFFF, 0, GateType::CONST1, 0, 0);
+
+        const int NOT_C = cellCost(GateType::NOT), AND_C = cellCost(GateType::AND);
+        const int NAND_C = cellCost(GateType::NAND2), OR_C = cellCost(GateType::OR);
+        const int NOR_C = cellCost(GateType::NOR2), AOI21_C = cellCost(GateType::AOI21);
+        const int AOI22_C = cellCost(GateType::AOI22);
+        for (int c = 0; c < 255 && found < N; c++) {
+            if (c >= NOT_C)
+                for (uint16_t f : byCost[c - NOT_C]) reach((uint16_t)~f, c, GateType::NOT, f, 0);
+            if (c >= AND_C) for (uint16_t g : andByCost[c - AND_C]) reach(g, c, GateType::AND, g, 0);
+            if (c >= NAND_C) for (uint16_t g : andByCost[c - NAND_C]) reach((uint16_t)~g, c, GateType::NAND2, g, 0);
+            if (c >= OR_C) for (uint16_t g : orByCost[c - OR_C]) reach(g, c, GateType::OR, g, 0);
+            if (c >= NOR_C) for (uint16_t g : orByCost[c - NOR_C]) reach((uint16_t)~g, c, GateType::NOR2, g, 0);
+            for (int i = 0; i <= c - AOI21_C; i++) {
+                for (uint16_t g : andByCost[i])
+                    for (uint16_t x : byCost[c - AOI21_C - i]) reach((uint16_t)~(g | x), c, GateType::AOI21, g, x);
+            }
+            for (int i = 0; i <= c - AOI22_C - i; i++) {
+                for (uint16_t g : andByCost[i])
+                    for (uint16_t h : andByCost[c - AOI22_C - i]) reach((uint16_t)~(g | h), c, GateType::AOI22, g, h);
+            }
+            // pairs of subtrees costing c in total; every function of cost
+            // c exists by now since cells cost more than nothing
+            for (int i = 0; i <= c - i; i++) {
+                for (uint16_t a : byCost[i]) {
+                    for (uint16_t b : byCost[c - i]) {
+                        uint16_t g = a & b, h = a | b;
+                        if (andPair[g] == INF) {
+                            andPair[g] = (uint8_t)c;
+                            andArgs[g] = {a, b};
+                            andByCost[c].push_back(g);
+                        }
+                        if (orPair[h] == INF) {
+                            orPair[h] = (uint8_t)c;
+                            orArgs[h] = {a, b};
+                            orByCost[c].push_back(h);
+                        }
+                    }
+                }
+            }
+        }
+
+        // classes, by orbit
+        classes.clear();
+        std::vector<char> seen(N, 0);
+        const auto &perms = npnPerms();
+        for (int f = 0; f < N; f++) {
+            if (seen[f]) continue;
+            classes.push_back((uint16_t)f);   // the first of an orbit is its smallest
+            for (const auto &p : perms)
+                for (int m = 0; m < 16; m++)
+                    for (int o = 0; o < 2; o++) seen[npnTransform((uint16_t)f, p, m, o)] = 1;
+        }
+
+        entries.assign(classes.size() * NPN_PHASES, NpnEntry());
+        for (size_t k = 0; k < classes.size(); k++) {
+            for (int ph = 0; ph < NPN_PHASES; ph++) {
+                uint16_t h = npnTransform(classes[k], perms[0], ph >> 1, ph & 1);
+                NpnEntry &e = entries[k * NPN_PHASES + ph];
+                e.cost = cost_[h];
+                e.root = emit(h, e.cells);
+            }
+        }
+        libraryHash = cellLibraryHash();
+        cost_.clear();
+        how.clear();
+        andArgs.clear();
+        orArgs.clear();
+    }
+
+    // File layout: "NPN4DB", version, library hash, class count, the class
+    // representatives, then per class and phase: cost, root, cell count and
+    // 5 bytes per cell (type and 4 operands)
+    bool write(const std::string &path) const {
+        std::ofstream f(path, std::ios::binary);
+        if (!f) return false;
+        uint32_t n = (uint32_t)classes.size();
+        f.write("NPN4DB\0", 8);
+        f.write((const char *)&NPN_DB_VERSION, 4);
+        f.write((const char *)&libraryHash, 8);
+        f.write((const char *)&n, 4);
+        f.write((const char *)classes.data(), n * 2);
+        for (const NpnEntry &e : entries) {
+            uint8_t head[3] = {e.cost, e.root, (uint8_t)e.cells.size()};
+            f.write((const char *)head, 3);
+            for (const NpnCell &c : e.cells) {
+                uint8_t b[5] = {(uint8_t)c.type, c.in[0], c.in[1], c.in[2], c.in[3]};
+                f.write((const char *)b, 5);
+            }
+        }
+        return (bool)f;
+    }
+
+    bool read(const std::string &path) {
+        std::ifstream f(path, std::ios::binary);
+        char magic[8];
+        uint32_t version = 0, n = 0;
+        if (!f.read(magic, 8) || memcmp(magic, "NPN4DB\0", 8) != 0) return false;
+        if (!f.read((char *)&version, 4) || version != NPN_DB_VERSION) return false;
+        if (!f.read((char *)&libraryHash, 8) || !f.read((char *)&n, 4) || n == 0 || n > 256) return false;
+        classes.resize(n);
+        if (!f.read((char *)classes.data(), n * 2)) return false;
+        entries.assign(n * NPN_PHASES, NpnEntry());
+        for (NpnEntry &e : entries) {
+            uint8_t head[3];
+            if (!f.read((char *)head, 3)) return false;
+            e.cost = head[0];
+            e.root = head[1];
+            e.cells.resize(head[2]);
+            for (size_t k = 0; k < e.cells.size(); k++) {
+                NpnCell &c = e.cells[k];
+                uint8_t b[5];
+                if (!f.read((char *)b, 5) || b[0] >= GATE_TYPE_COUNT) return false;
+                c.type = (GateType)b[0];
+                memcpy(c.in, b + 1, 4);
+                // a cell only reads the cells before it
+                for (uint8_t v : c.in)
+                    if (v != NPN_NONE && v >= NPN_CELL + k) return false;
+            }
+            if (e.cells.empty() ? e.root >= NPN_CELL : e.root != NPN_CELL + e.cells.size() - 1) return false;
+        }
+        return true;
+    }
+
+    // Longest path, in cell delays, from input leaf of tt to the output of
+    // its formula (0 when the formula is the input itself, -1 when the
+    // formula does not read it)
+    int pinDelay(uint16_t tt, int leaf) const {
+        const Canon &c = canon[tt];
+        const NpnEntry &e = entries[c.cls * NPN_PHASES + c.phase];
+        const std::vector<int> &perm = npnPerms()[c.perm];
+        std::vector<int> d(e.cells.size());   // arrival at each cell, -1 when leaf does not reach it
+        for (size_t k = 0; k < e.cells.size(); k++) {
+            const NpnCell &cell = e.cells[k];
+            int a = -1;
+            for (int i = 0; i < 4 && cell.in[i] != NPN_NONE; i++) {
+                uint8_t v = cell.in[i];
+                if (v < 4 && perm[v] == leaf) a = std::max(a, 0);
+                if (v >= NPN_CELL) a = std::max(a, d[v - NPN_CELL]);
+            }
+            d[k] = a < 0 ? -1 : a + cellDelay(cell.type);
+        }
+        if (e.cells.empty()) return e.root < 4 && perm[e.root] == leaf ? 0 : -1;
+        return d[e.cells.size() - 1];
+    }
+
+    // Prints the cells implementing tt over the given leaf names as netlist
+    // lines; the output is called name and inner cells name_c1, name_c2, ...
+    void writeFormula(std::ostream &out, const std::string &name, uint16_t tt,
+                      const std::vector<std::string> &leaves) const {
+        const Canon &c = canon[tt];
+        const NpnEntry &e = entries[c.cls * NPN_PHASES + c.phase];
+        const std::vector<int> &perm = npnPerms()[c.perm];
+        // the entry is the class representative in this phase, over inputs
+        // that tt reads in the order perm
+        auto operand = [&](uint8_t v) -> std::string {
+            if (v < 4) return perm[v] < (int)leaves.size() ? leaves[perm[v]] : "0";
+            if (v < NPN_CELL) return v == NPN_CONST0 ? "0" : "1";
+            int k = v - NPN_CELL;
+            return k + 1 == (int)e.cells.size() ? name : name + "_c" + std::to_string(k + 1);
+        };
+        if (e.cells.empty()) {
+            out << name << " = " << operand(e.root) << "\n";
+            return;
+        }
+        for (int k = (int)e.cells.size() - 1; k >= 0; k--) {
+            const NpnCell &cell = e.cells[k];
+            out << operand((uint8_t)(NPN_CELL + k)) << " = " << gateTypeName(cell.type);
+            for (int i = 0; i < 4 && cell.in[i] != NPN_NONE; i++) out << " " << operand(cell.in[i]);
+            out << "\n";
+        }
+    }
+
+private:
+    struct Canon {
+        uint8_t cls = 0;
+        uint8_t perm = 0;
+        uint8_t phase = 0;
+    };
+    struct How {
+        GateType type = GateType::UNKNOWN;
+        uint16_t a = 0;
+        uint16_t b = 0;
+    };
+    std::vector<Canon> canon;   // truth table -> its class and transform
+    // generate() only
+    std::vector<uint8_t> cost_;
+    std::vector<How> how;
+    std::vector<std::pair<uint16_t, uint16_t>> andArgs, orArgs;
+
+    // f = npnTransform(classes[cls], perm, phase >> 1, phase & 1), which is
+    // the phase entry with its inputs read through perm
+    void buildCanon() {
+        canon.assign(1 << 16, Canon());
+        std::vector<char> set(1 << 16, 0);
+        const auto &perms = npnPerms();
+        for (size_t k = 0; k < classes.size(); k++) {
+            for (size_t p = 0; p < perms.size(); p++) {
+                for (int ph = 0; ph < NPN_PHASES; ph++) {
+                    uint16_t g = npnTransform(classes[k], perms[p], ph >> 1, ph & 1);
+                    if (set[g]) continue;
+                    set[g] = 1;
+                    canon[g] = {(uint8_t)k, (uint8_t)p, (uint8_t)ph};
+                }
+            }
+        }
+    }
+
+    // Appends the tree of f to cells and returns the operand for it
+    uint8_t emit(uint16_t f, std::vector<NpnCell> &cells) {
+        const How &h = how[f];
+        switch (h.type) {
+            case GateType::INPUT:
+                return (uint8_t)(std::find(NPN_VAR, NPN_VAR + 4, f) - NPN_VAR);
+            case GateType::CONST0: return NPN_CONST0;
+            case GateType::CONST1: return NPN_CONST0 + 1;
+            default: break;
+        }
+        NpnCell cell = {h.type, {NPN_NONE, NPN_NONE, NPN_NONE, NPN_NONE}};
+        int k = 0;
+        auto pair = [&](const std::pair<uint16_t, uint16_t> &ab) {
+            cell.in[k++] = emit(ab.first, cells);
+            cell.in[k++] = emit(ab.second, cells);
+        };
+        switch (h.type) {
+            case GateType::NOT: cell.in[k++] = emit(h.a, cells); break;
+            case GateType::AND:
+            case GateType::NAND2: pair(andArgs[h.a]); break;
+            case GateType::OR:
+            case GateType::NOR2: pair(orArgs[h.a]); break;
+            case GateType::AOI21:
+                pair(andArgs[h.a]);
+                cell.in[k++] = emit(h.b, cells);
+                break;
+            case GateType::AOI22:
+                pair(andArgs[h.a]);
+                pair(andArgs[h.b]);
+                break;
+            default: break;
+        }
+        cells.push_back(cell);
+        return (uint8_t)(NPN_CELL + cells.size() - 1);
+    }
+};
+
+#endif
@@ -0,0 +1,184 @@
+// packed_netlist.h
+// Compact netlist storage for very large designs. Each signal is one 24-byte
+// PackedNode: type, fan-in count, up to three fan-in ids inline (wider gates
+// keep theirs in a shared overflow pool), a cost label, flags and the offset
+// of its name. Names are interned once into an arena of 1 MB chunks, found
+// through an open-addressing table of 32-bit ids. Nodes live in pages of 64k,
+// so nothing is allocated per gate and nothing is copied as the netlist grows.
+//
+//   PackedNetlist net;
+//   uint32_t a = net.intern("a"), t = net.intern("t1");
+//   net.node(t).type = GateType::NOT;
+//   net.setFanins(t, &a, 1);
+#ifndef PACKED_NETLIST_H
+#define PACKED_NETLIST_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "cell_library.h"
+
+struct PackedNode {
+    static const uint8_t WIDE = 0xFF;     // arity of a gate with more than 3 fan-ins
+    static const uint8_t VISITED = 1;     // flags
+
+    uint32_t in[3] = {0, 0, 0};   // fan-in ids; for a WIDE gate, in[0] is its start in the pool and in[1] its count
+    uint32_t name = 0;            // offset of the name in the arena
+    int32_t cost = -1;
+    GateType type = GateType::UNKNOWN;
+    uint8_t arity = 0;
+    uint8_t flags = 0;
+};
+static_assert(sizeof(PackedNode) == 24, "PackedNode must stay 24 bytes");
+
+// Fan-in ids of one node, inline or in the pool
+struct FaninRange {
+    const uint32_t *first, *last;
+    size_t size() const { return last - first; }
+    uint32_t operator[](size_t k) const { return first[k]; }
+    const uint32_t *begin() const { return first; }
+    const uint32_t *end() const { return last; }
+};
+
+// NUL-terminated names in 1 MB chunks, addressed by 32-bit offsets (4 GB)
+class NameArena {
+public:
+    static const uint32_t FULL = UINT32_MAX;
+    static const int CHUNK_BITS = 20;
+    static const size_t CHUNK = size_t(1) << CHUNK_BITS;
+
+    // Copies s in and returns its offset, or FULL
+    uint32_t add(std::string_view s) {
+        if (s.size() + 1 > CHUNK) return FULL;
+        if (used + s.size() + 1 > CHUNK) {
+            if (chunks.size() == (size_t(1) << (32 - CHUNK_BITS))) return FULL;
+            chunks.emplace_back(new char[CHUNK]);
+            used = 0;
+        }
+        char *p = chunks.back().get() + used;
+        memcpy(p, s.data(), s.size());
+        p[s.size()] = '\0';
+        uint32_t off = uint32_t(((chunks.size() - 1) << CHUNK_BITS) + used);
+        used += s.size() + 1;
+        return off;
+    }
+
+    const char *get(uint32_t off) const { return chunks[off >> CHUNK_BITS].get() + (off & (CHUNK - 1)); }
+
+    size_t bytes() const { return chunks.size() * CHUNK; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+    size_t used = CHUNK;   // bytes taken in the last chunk
+};
+
+// Bytes held by each part of a PackedNetlist
+struct PackedMemory {
+    size_t nodes = 0, pool = 0, names = 0, index = 0;
+    size_t total() const { return nodes + pool + names + index; }
+};
+
+class PackedNetlist {
+public:
+    static const uint32_t NONE = UINT32_MAX;
+    static const int PAGE_BITS = 16;
+    static const uint32_t PAGE = uint32_t(1) << PAGE_BITS;
+
+    uint32_t size() const { return count; }
+
+    PackedNode &node(uint32_t id) { return pages[id >> PAGE_BITS][id & (PAGE - 1)]; }
+    const PackedNode &node(uint32_t id) const { return pages[id >> PAGE_BITS][id & (PAGE - 1)]; }
+
+    const char *name(uint32_t id) const { return names.get(node(id).name); }
+
+    // Id of the signal called s, or NONE
+    uint32_t find(std::string_view s) const {
+        if (index.empty()) return NONE;
+        for (size_t h = hashName(s) & (index.size() - 1);; h = (h + 1) & (index.size() - 1)) {
+            if (index[h] == 0) return NONE;
+            if (sameName(index[h] - 1, s)) return index[h] - 1;
+        }
+    }
+
+    // Id of the signal called s, adding an UNKNOWN node the first time.
+    // NONE when the ids or the arena run out.
+    uint32_t intern(std::string_view s) {
+        if ((size_t(count) + 1) * 4 > index.size() * 3) growIndex();
+        size_t h = hashName(s) & (index.size() - 1);
+        for (; index[h] != 0; h = (h + 1) & (index.size() - 1))
+            if (sameName(index[h] - 1, s)) return index[h] - 1;
+        if (count == NONE - 1) return NONE;
+        uint32_t off = names.add(s);
+        if (off == NameArena::FULL) return NONE;
+        if ((count & (PAGE - 1)) == 0) pages.emplace_back(new PackedNode[PAGE]);
+        node(count).name = off;
+        index[h] = count + 1;
+        return count++;
+    }
+
+    // Replaces the fan-ins of id. A redefined wide gate leaves its old
+    // fan-ins unused in the pool.
+    void setFanins(uint32_t id, const uint32_t *ids, size_t n) {
+        PackedNode &nd = node(id);
+        if (n <= 3) {
+            nd.arity = uint8_t(n);
+            for (size_t k = 0; k < n; k++) nd.in[k] = ids[k];
+        } else {
+            nd.arity = PackedNode::WIDE;
+            nd.in[0] = uint32_t(pool.size());
+            nd.in[1] = uint32_t(n);
+            pool.insert(pool.end(), ids, ids + n);
+        }
+    }
+
+    FaninRange fanins(uint32_t id) const {
+        const PackedNode &nd = node(id);
+        if (nd.arity != PackedNode::WIDE) return {nd.in, nd.in + nd.arity};
+        const uint32_t *p = pool.data() + nd.in[0];
+        return {p, p + nd.in[1]};
+    }
+
+    PackedMemory memory() const {
+        PackedMemory m;
+        m.nodes = pages.size() * PAGE * sizeof(PackedNode);
+        m.pool = pool.capacity() * sizeof(uint32_t);
+        m.names = names.bytes();
+        m.index = index.capacity() * sizeof(uint32_t);
+        return m;
+    }
+
+private:
+    std::vector<std::unique_ptr<PackedNode[]>> pages;
+    std::vector<uint32_t> pool;    // fan-ins of WIDE gates
+    NameArena names;
+    std::vector<uint32_t> index;   // id + 1 per used slot, 0 when empty
+    uint32_t count = 0;
+
+    static size_t hashName(std::string_view s) { return std::hash<std::string_view>()(s); }
+
+    // strncmp stops at the stored name's NUL, so a shorter name at the end
+    // of its chunk is never read past
+    bool sameName(uint32_t id, std::string_view s) const {
+        const char *p = name(id);
+        return strncmp(p, s.data(), s.size()) == 0 && p[s.size()] == '\0';
+    }
+
+    // Doubles the table (at most 3/4 full) and puts every id back
+    void growIndex() {
+        std::vector<uint32_t> old;
+        old.swap(index);
+        index.assign(old.empty() ? 1024 : 2 * old.size(), 0);
+        for (uint32_t id : old) {
+            if (id == 0) continue;
+            size_t h = hashName(name(id - 1)) & (index.size() - 1);
+            while (index[h] != 0) h = (h + 1) & (index.size() - 1);
+            index[h] = id;
+        }
+    }
+};
+
+#endif
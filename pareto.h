@@ -0,0 +1,232 @@
+// pareto.h
+// Area/delay trade-offs for the tree DP. Instead of one label, every mapped
+// node keeps up to PARETO_MAX (area, arrival) points, none of which is beaten
+// by another in both. A pattern's points come from merging the sets of its
+// leaves one leaf at a time, pruning after each merge, so the work per node
+// stays bounded. All sets live in one pooled buffer.
+//
+// Areas are area flows: a leaf read by k cells adds 1/k of its area, since
+// shared logic is built once. The flows only steer the search; pick() and
+// front() extract real covers and report their real area and delay.
+//
+//   ParetoMapper pm;
+//   pm.build(tm);                         // after tm.calculateMinimalCost()
+//   for (const ParetoPoint &p : pm.front(tm)) ... // real (delay, area) per point
+//   int area = pm.pick(tm, maxDelay);     // tm.cover is now that point's
+#ifndef PARETO_H
+#define PARETO_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "mapper.h"
+
+static const int PARETO_MAX = 8;   // points kept per node
+
+// One point of a node's set: the pattern that gives it and the point used
+// at each of the pattern's leaves
+struct ParetoLabel {
+    float area;
+    int arrival;
+    uint8_t match;
+    uint8_t pick[4];
+};
+
+// A real cover on the output-level front
+struct ParetoPoint {
+    int delay;
+    int area;
+    int bound;   // the delay bound passed to pick() for it (-1: not from pick)
+};
+
+// Sorts pts by delay and drops every point another one beats in both
+inline void paretoFilter(std::vector<ParetoPoint> &pts) {
+    std::sort(pts.begin(), pts.end(), [](const ParetoPoint &a, const ParetoPoint &b) {
+        return a.delay != b.delay ? a.delay < b.delay : a.area < b.area;
+    });
+    size_t kept = 0;
+    for (size_t k = 0; k < pts.size(); k++) {
+        if (kept > 0 && pts[k].area >= pts[kept - 1].area) continue;
+        pts[kept++] = pts[k];
+    }
+    pts.resize(kept);
+}
+
+class ParetoMapper {
+public:
+    std::vector<ParetoLabel> pool;   // every node's points, sorted by arrival
+    std::vector<uint32_t> first;     // node -> its first point in pool
+    std::vector<uint8_t> count;      // node -> number of points
+
+    // Labels every node of tm's subject graph. Needs tm's fan-outs, so call
+    // after calculateMinimalCost(). Choice classes are not supported.
+    bool build(const TechnologyMapper &tm) {
+        const SubjectGraph &g = tm.graph;
+        if (g.choiceClasses > 0 || tm.fanout.size() != (size_t)g.size()) return false;
+        int n = g.size();
+        first.assign(n, 0);
+        count.assign(n, 0);
+        pool.clear();
+        pool.reserve((size_t)n * 2);
+        computeShapeCodes(g, tm.fanout, codes);
+        const std::vector<ShapeEntry> &table = shapeTable();
+        for (int i = 0; i < n; i++) {
+            if (tm.fanout[i] == 0) continue;
+            first[i] = (uint32_t)pool.size();
+            if (g.nodes[i].type == GateType::INPUT) {
+                pool.push_back(ParetoLabel{0, 0, 0, {}});
+                count[i] = 1;
+                continue;
+            }
+            const ShapeEntry &e = table[shapeFromCodes(g, codes, i)];
+            int cone[16];
+            shapeCone(g, i, e, cone);
+            cand.clear();
+            for (int j = 0; j < e.count; j++) {
+                const ShapePattern &p = e.patterns[j];
+                part.assign(1, ParetoLabel{(float)cellCost(p.cell), 0, (uint8_t)j, {}});
+                for (int l = 0; l < p.numLeaves; l++) {
+                    int leaf = cone[p.leaves[l]];
+                    float share = 1.0f / std::max(1, tm.fanout[leaf]);
+                    next.clear();
+                    for (const ParetoLabel &a : part) {
+                        for (int k = 0; k < count[leaf]; k++) {
+                            const ParetoLabel &b = pool[first[leaf] + k];
+                            ParetoLabel q = a;
+                            q.area += b.area * share;
+                            q.arrival = std::max(a.arrival, b.arrival);
+                            q.pick[l] = (uint8_t)k;
+                            next.push_back(q);
+                        }
+                    }
+                    prune(next);
+                    part.swap(next);
+                }
+                for (ParetoLabel &q : part) {
+                    q.arrival += cellDelay(p.cell);
+                    cand.push_back(q);
+                }
+            }
+            prune(cand);
+            pool.insert(pool.end(), cand.begin(), cand.end());
+            count[i] = (uint8_t)cand.size();
+        }
+        return true;
+    }
+
+    // Bytes held by the point pool
+    size_t bytes() const { return pool.capacity() * sizeof(ParetoLabel); }
+
+    // Extracts the cover that gives every output its smallest-area point
+    // arriving by maxDelay (or its fastest point when none does) and stores
+    // it in tm.best / tm.cover. A node that readers want at different points
+    // gets the fastest of them. Returns the real area.
+    int pick(TechnologyMapper &tm, int maxDelay) {
+        extract(tm, maxDelay);
+        const SubjectGraph &g = tm.graph;
+        const std::vector<ShapeEntry> &table = shapeTable();
+        for (int i = 0; i < g.size(); i++) {
+            if (demand[i] < 0 || g.nodes[i].type == GateType::INPUT) continue;
+            const ShapeEntry &e = table[shapeFromCodes(g, codes, i)];
+            int cone[16];
+            shapeCone(g, i, e, cone);
+            tm.best[i] = shapeMatch(e.patterns[pool[first[i] + demand[i]].match], cone);
+        }
+        return tm.extractCover();
+    }
+
+    // Real (delay, area) of the covers pick() gives for every delay bound
+    // that changes the outputs' choices, without the dominated ones
+    std::vector<ParetoPoint> front(const TechnologyMapper &tm) {
+        std::vector<int> bounds;
+        for (int o : tm.graph.outputs)
+            for (int k = 0; k < count[o]; k++) bounds.push_back(pool[first[o] + k].arrival);
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+        std::vector<ParetoPoint> pts;
+        for (int d : bounds) {
+            ParetoPoint p = extract(tm, d);
+            p.bound = d;
+            pts.push_back(p);
+        }
+        paretoFilter(pts);
+        return pts;
+    }
+
+private:
+    std::vector<uint8_t> codes;          // shape codes under tm.fanout, at id + 1
+    std::vector<ParetoLabel> part, next, cand;
+    std::vector<int> demand;             // node -> point its readers need, -1 if unused
+    std::vector<int> arrival;
+
+    // Keeps the points no other point beats in both area and arrival; when
+    // more than PARETO_MAX remain, keeps the fastest, the smallest and an
+    // even spread in between
+    static void prune(std::vector<ParetoLabel> &v) {
+        std::sort(v.begin(), v.end(), [](const ParetoLabel &a, const ParetoLabel &b) {
+            return a.arrival != b.arrival ? a.arrival < b.arrival : a.area < b.area;
+        });
+        size_t kept = 0;
+        for (size_t k = 0; k < v.size(); k++) {
+            if (kept > 0 && v[k].area >= v[kept - 1].area) continue;
+            v[kept++] = v[k];
+        }
+        v.resize(kept);
+        if (kept <= (size_t)PARETO_MAX) return;
+        for (int k = 0; k < PARETO_MAX; k++) v[k] = v[k * (kept - 1) / (PARETO_MAX - 1)];
+        v.resize(PARETO_MAX);
+    }
+
+    // The point of node id an output bound by maxDelay uses
+    int outputPoint(int id, int maxDelay) const {
+        int best = -1;
+        for (int k = 0; k < count[id]; k++) {
+            const ParetoLabel &p = pool[first[id] + k];
+            if (p.arrival <= maxDelay && (best < 0 || p.area < pool[first[id] + best].area)) best = k;
+        }
+        return best < 0 ? 0 : best;   // points are sorted by arrival
+    }
+
+    // Fills demand for the cover pick(maxDelay) gives and returns its real
+    // delay and area
+    ParetoPoint extract(const TechnologyMapper &tm, int maxDelay) {
+        const SubjectGraph &g = tm.graph;
+        int n = g.size();
+        demand.assign(n, -1);
+        auto want = [&](int id, int k) {
+            // points are sorted by arrival, so the lower index is faster
+            if (demand[id] < 0 || k < demand[id]) demand[id] = k;
+        };
+        for (int o : g.outputs) want(o, outputPoint(o, maxDelay));
+        const std::vector<ShapeEntry> &table = shapeTable();
+        // readers have higher ids than the nodes they read
+        for (int i = n - 1; i >= 0; i--) {
+            if (demand[i] < 0 || g.nodes[i].type == GateType::INPUT) continue;
+            const ShapeEntry &e = table[shapeFromCodes(g, codes, i)];
+            int cone[16];
+            shapeCone(g, i, e, cone);
+            const ParetoLabel &p = pool[first[i] + demand[i]];
+            const ShapePattern &sp = e.patterns[p.match];
+            for (int l = 0; l < sp.numLeaves; l++) want(cone[sp.leaves[l]], p.pick[l]);
+        }
+        // real arrivals of the cover, bottom-up
+        ParetoPoint r = {0, 0, maxDelay};
+        arrival.assign(n, 0);
+        for (int i = 0; i < n; i++) {
+            if (demand[i] < 0 || g.nodes[i].type == GateType::INPUT) continue;
+            const ShapeEntry &e = table[shapeFromCodes(g, codes, i)];
+            int cone[16];
+            shapeCone(g, i, e, cone);
+            const ShapePattern &sp = e.patterns[pool[first[i] + demand[i]].match];
+            int a = 0;
+            for (int l = 0; l < sp.numLeaves; l++) a = std::max(a, arrival[cone[sp.leaves[l]]]);
+            arrival[i] = a + cellDelay(sp.cell);
+            r.area += cellCost(sp.cell);
+        }
+        for (int o : g.outputs) r.delay = std::max(r.delay, arrival[o]);
+        return r;
+    }
+};
+
+#endif
@@ -0,0 +1,281 @@
+// pipeline.h
+// Pipelined reading of a netlist file. A reader thread reads the file in
+// blocks (decompressing it, see compressed_input.h) and splits it into lines
+// and tokens; the calling thread takes the
+// blocks from a lock-free single-producer/single-consumer ring, interns the
+// names and, when a subject graph is given, lowers every gate to NAND2/NOT as
+// soon as its fan-ins are built. For a topologically ordered file the graph
+// is then complete at EOF and the cone extraction and the separate build
+// pass are skipped. The first gate that reads a signal not built yet stops
+// the lowering; the netlist is still read to the end and the caller builds
+// the graph the usual way.
+//
+// Only reading and building overlap. Labelling has to wait for EOF: a
+// node's matches depend on its final fan-out, which the last reader in the
+// file can still change. Mapping and writing the cover then run as usual.
+//
+//   Netlist nl;
+//   SubjectGraph sg;
+//   PipelineStats st;
+//   if (readNetlistPipelined("big.txt", nl, &sg, &st) && st.streamed) ... // sg is ready
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+#include "netlist.h"
+#include "subject_graph.h"
+#include "compressed_input.h"
+
+static const size_t PIPELINE_BLOCK = 1 << 20;   // bytes read per block
+static const int PIPELINE_BLOCKS = 8;           // blocks in flight
+
+// Ring of capacity - 1 slots (capacity a power of two) for exactly one
+// producer and one consumer thread. Neither side ever takes a lock.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots(capacity), mask(capacity - 1) {}
+
+    // Producer side; false when the ring is full
+    bool push(const T &v) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (((t + 1) & mask) == head.load(std::memory_order_acquire)) return false;
+        slots[t] = v;
+        tail.store((t + 1) & mask, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the ring is empty
+    bool pop(T &v) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        v = slots[h];
+        head.store((h + 1) & mask, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};   // next slot to pop
+    alignas(64) std::atomic<size_t> tail{0};   // next slot to push
+};
+
+struct PipelineStats {
+    int lines = 0;           // netlist lines handed to the builder
+    int blocks = 0;          // blocks the reader filled
+    int readerStalls = 0;    // times the reader found every block in use
+    int builderStalls = 0;   // times the builder found no block ready
+    bool streamed = false;   // the subject graph was built while reading
+    int stopLine = 0;        // line that stopped the lowering (0: none)
+};
+
+// Whole lines of the file with their tokens
+struct LineBlock {
+    struct Line {
+        size_t start, len;   // text of the line, without the line break
+        size_t token, count; // its tokens in tokens
+        int lineNo;
+    };
+    std::string text;
+    std::vector<Line> lines;
+    std::vector<std::string_view> tokens;
+    bool last = false;       // no blocks follow
+};
+
+// Waits (spinning briefly, then yielding) until step() succeeds or stop is
+// set. Returns false if it stopped; counts a stall if it had to wait.
+template <typename F>
+inline bool pipelineWait(F step, const std::atomic<bool> &stop, int &stalls) {
+    for (int spin = 0; !step(); spin++) {
+        if (stop.load(std::memory_order_relaxed)) return false;
+        if (spin == 0) stalls++;
+        if (spin >= 64) std::this_thread::yield();
+    }
+    return true;
+}
+
+// Splits b.text into lines and tokens the way parseNetlistLine reads them:
+// empty lines and lines starting with "Test" or "Script" are dropped
+inline void tokenizeBlock(LineBlock &b, int &lineNo) {
+    b.lines.clear();
+    b.tokens.clear();
+    const std::string &s = b.text;
+    auto space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; };
+    for (size_t pos = 0; pos < s.size();) {
+        size_t end = s.find('\n', pos);
+        if (end == std::string::npos) end = s.size();
+        size_t len = end - pos;
+        if (len > 0 && s[pos + len - 1] == '\r') len--;
+        lineNo++;
+        std::string_view line(s.data() + pos, len);
+        if (line.substr(0, 4) != "Test" && line.substr(0, 6) != "Script") {
+            size_t first = b.tokens.size();
+            for (size_t p = 0; p < len;) {
+                while (p < len && space(line[p])) p++;
+                size_t q = p;
+                while (q < len && !space(line[q])) q++;
+                if (q > p) b.tokens.push_back(line.substr(p, q - p));
+                p = q;
+            }
+            if (b.tokens.size() > first) b.lines.push_back({pos, len, first, b.tokens.size() - first, lineNo});
+        }
+        pos = end + 1;
+    }
+}
+
+// Reads fname into nl like readNetlist, tokenizing on a second thread. With
+// sg set, also lowers the gates into sg while reading; stats->streamed tells
+// whether that got through the whole file (sg then has its outputs set) or
+// sg was dropped and still has to be built from nl.
+inline bool readNetlistPipelined(const std::string &fname, Netlist &nl, SubjectGraph *sg,
+                                 PipelineStats *stats = nullptr) {
+    InputFile f;
+    if (!f.open(fname)) return false;
+    PipelineStats st;
+    std::vector<LineBlock> pool(PIPELINE_BLOCKS);
+    SpscQueue<LineBlock *> full(2 * PIPELINE_BLOCKS), empty(2 * PIPELINE_BLOCKS);
+    for (LineBlock &b : pool) empty.push(&b);
+    std::atomic<bool> stop{false};
+
+    std::thread reader([&] {
+        std::string carry;   // unfinished last line of the previous block
+        int lineNo = 0;
+        bool eof = false;
+        while (!eof && !stop) {
+            LineBlock *b = nullptr;
+            if (!pipelineWait([&] { return empty.pop(b); }, stop, st.readerStalls)) return;
+            b->text.swap(carry);
+            carry.clear();
+            size_t cut = std::string::npos;
+            while (!eof && cut == std::string::npos) {
+                // a compressed file may hand out less than asked before its end
+                size_t old = b->text.size(), got = 0;
+                b->text.resize(old + PIPELINE_BLOCK);
+                while (got < PIPELINE_BLOCK && !eof) {
+                    size_t k = f.read(&b->text[old + got], PIPELINE_BLOCK - got);
+                    got += k;
+                    eof = k == 0;
+                }
+                b->text.resize(old + got);
+                cut = b->text.rfind('\n');
+            }
+            if (!eof) {
+                carry.assign(b->text, cut + 1, std::string::npos);
+                b->text.resize(cut + 1);
+            }
+            tokenizeBlock(*b, lineNo);
+            b->last = eof;
+            st.blocks++;
+            if (!pipelineWait([&] { return full.push(b); }, stop, st.readerStalls)) return;
+        }
+    });
+
+    bool lowering = sg != nullptr;
+    std::vector<int> lit;   // netlist id -> subject node, -1 while not built
+    std::vector<int> in;
+    std::string key;
+    auto intern = [&](std::string_view name) {
+        key.assign(name);
+        int id = nl.intern(key);
+        if (lit.size() < nl.gates.size()) lit.resize(nl.gates.size(), -1);
+        return id;
+    };
+    // subject node of fan-in id; tie-offs become leaves the first time they're read
+    auto literal = [&](int id) {
+        GateType t = nl.gates[id].type;
+        if (lit[id] < 0 && (t == GateType::CONST0 || t == GateType::CONST1)) lit[id] = sg->addInput(id);
+        return lit[id];
+    };
+    auto stopLowering = [&](int lineNo) {
+        lowering = false;
+        st.stopLine = lineNo;
+        *sg = SubjectGraph();
+    };
+
+    bool ok = true;
+    bool done = false;
+    while (ok && !done) {
+        LineBlock *b = nullptr;
+        pipelineWait([&] { return full.pop(b); }, stop, st.builderStalls);
+        for (const LineBlock::Line &ln : b->lines) {
+            const std::string_view *tok = &b->tokens[ln.token];
+            size_t count = ln.count;
+            std::string_view op = count > 1 ? tok[1] : std::string_view();
+            st.lines++;
+            if (op == "INPUT") {
+                int id = intern(tok[0]);
+                nl.gates[id].type = GateType::INPUT;
+                if (lowering && lit[id] < 0) lit[id] = sg->addInput(id);
+            } else if (op == "OUTPUT") {
+                nl.outputs.push_back(intern(tok[0]));
+            } else if (op == "=" && count > 2) {
+                int id = intern(tok[0]);
+                // "F = t5" just renames another signal
+                GateType type = count == 3 ? GateType::OUTPUT : parseGateType(std::string(tok[2]));
+                if (type == GateType::UNKNOWN || type == GateType::INPUT) {
+                    ok = false;
+                } else {
+                    std::vector<int> inputs;
+                    inputs.reserve(count == 3 ? 1 : count - 3);
+                    for (size_t k = count == 3 ? 2 : 3; k < count; k++) inputs.push_back(intern(tok[k]));
+                    Gate &g = nl.gates[id];
+                    g.type = type;
+                    g.inputs = std::move(inputs);
+                    if (lowering) {
+                        // a redefinition or a fan-in from further down the
+                        // file can't be lowered in file order
+                        bool ready = lit[id] < 0 && validArity(g);
+                        in.clear();
+                        for (size_t k = 0; k < g.inputs.size() && ready; k++) {
+                            in.push_back(literal(g.inputs[k]));
+                            ready = in.back() >= 0;
+                        }
+                        if (ready) {
+                            lit[id] = lowerGate(*sg, type, in, id);
+                        } else {
+                            stopLowering(ln.lineNo);
+                        }
+                    }
+                }
+            } else {
+                ok = false;
+            }
+            if (!ok) {
+                std::cerr << fname << ":" << ln.lineNo << ": cannot parse '" << b->text.substr(ln.start, ln.len)
+                          << "'" << std::endl;
+                break;
+            }
+        }
+        done = b->last;
+        empty.push(b);
+    }
+    stop = true;
+    reader.join();
+    if (ok && !f.error.empty()) {
+        std::cerr << fname << ": " << f.error << std::endl;
+        ok = false;
+    }
+
+    if (ok && lowering) {
+        for (int o : nl.outputs) {
+            if (lit[o] < 0) {
+                // an output nothing defines: let the usual build report it
+                stopLowering(0);
+                break;
+            }
+            sg->outputs.push_back(lit[o]);
+        }
+    }
+    st.streamed = ok && lowering;
+    if (stats) *stats = st;
+    return ok && !nl.outputs.empty();
+}
+
+#endif
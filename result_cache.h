@@ -0,0 +1,354 @@
+// result_cache.h
+// Persistent cache of mapped cones, kept across runs in one memory-mapped
+// file. The unit is a cone from collectCones(): a group of outputs that
+// shares no logic with the rest, so its cover does not depend on anything
+// outside it. A cone is keyed by a hash of its subject graph structure (not
+// its signal names) plus the cell library and mapping options, and the entry
+// holds its cost and cover. Only cones not found in the file are mapped.
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "mapper.h"
+#include "exact_cover.h"
+
+static const uint32_t CACHE_VERSION = 1;
+static const uint32_t DEFAULT_CACHE_SLOTS = 1 << 16;
+static const uint64_t DEFAULT_CACHE_HEAP = 64ull << 20;
+
+struct CacheKey {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slots;
+    uint64_t heapSize;
+    uint64_t heapUsed;
+    uint64_t clock;      // bumped on every hit or insert, for LRU
+    uint32_t entries;
+    uint32_t pad;
+};
+
+struct CacheSlot {
+    CacheKey key;        // all zero when the slot is free
+    uint64_t stamp;      // clock of the last use
+    uint64_t offset;     // of the cover in the heap
+    uint32_t length;     // cover length in int32s
+    int32_t cost;
+    float ms;            // time it took to map the cone
+    uint32_t pad;
+};
+
+// Open-addressed slot table followed by a heap of covers, in one file shared
+// with the page cache. When either fills up, the least recently used entries
+// are dropped until half of it is free and the heap is compacted.
+class ResultCache {
+public:
+    int evicted = 0;
+
+    ~ResultCache() { close(); }
+
+    bool open(const std::string &path, uint32_t slots = DEFAULT_CACHE_SLOTS,
+              uint64_t heapBytes = DEFAULT_CACHE_HEAP) {
+        close();
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0 || flock(fd, LOCK_EX) != 0) {
+            std::cerr << "Cannot open cache file " << path << std::endl;
+            close();
+            return false;
+        }
+        struct stat sb;
+        fstat(fd, &sb);
+        CacheHeader h;
+        bool valid = sb.st_size >= (off_t)sizeof(h) && pread(fd, &h, sizeof(h), 0) == sizeof(h) &&
+                     memcmp(h.magic, "TMCACHE", 8) == 0 && h.version == CACHE_VERSION &&
+                     (uint64_t)sb.st_size == fileSize(h.slots, h.heapSize);
+        if (valid) {
+            slots = h.slots;
+            heapBytes = h.heapSize;
+        }
+        size = fileSize(slots, heapBytes);
+        if (!valid && (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)size) != 0)) {
+            std::cerr << "Cannot size cache file " << path << std::endl;
+            close();
+            return false;
+        }
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            std::cerr << "Cannot map cache file " << path << std::endl;
+            close();
+            return false;
+        }
+        base = (uint8_t *)p;
+        hdr = (CacheHeader *)base;
+        table = (CacheSlot *)(base + sizeof(CacheHeader));
+        heap = base + sizeof(CacheHeader) + (size_t)slots * sizeof(CacheSlot);
+        if (!valid) {
+            memset(hdr, 0, sizeof(CacheHeader));   // the rest is already zero
+            memcpy(hdr->magic, "TMCACHE", 8);
+            hdr->version = CACHE_VERSION;
+            hdr->slots = slots;
+            hdr->heapSize = heapBytes;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base) munmap(base, size);
+        if (fd >= 0) ::close(fd);   // also drops the lock
+        base = nullptr;
+        fd = -1;
+    }
+
+    // Entry for key, marked as just used, or nullptr. The pointer and its
+    // cover stay valid until the next insert().
+    const CacheSlot *find(CacheKey key) {
+        for (uint32_t i = home(key);; i = (i + 1) % hdr->slots) {
+            CacheSlot &s = table[i];
+            if (s.key.hi == 0 && s.key.lo == 0) return nullptr;
+            if (s.key.hi == key.hi && s.key.lo == key.lo) {
+                s.stamp = ++hdr->clock;
+                return &s;
+            }
+        }
+    }
+
+    const int32_t *cover(const CacheSlot &s) const { return (const int32_t *)(heap + s.offset); }
+
+    // Returns false when the cover is too big to ever fit
+    bool insert(CacheKey key, int cost, float ms, const std::vector<int32_t> &cover) {
+        uint64_t bytes = cover.size() * sizeof(int32_t);
+        if (bytes > hdr->heapSize / 2) return false;
+        if (hdr->heapUsed + bytes > hdr->heapSize || (hdr->entries + 1) * 4ull > hdr->slots * 3ull)
+            compact(bytes);
+        CacheSlot s;
+        s.key = key;
+        s.stamp = ++hdr->clock;
+        s.offset = hdr->heapUsed;
+        s.length = (uint32_t)cover.size();
+        s.cost = cost;
+        s.ms = ms;
+        s.pad = 0;
+        memcpy(heap + s.offset, cover.data(), bytes);
+        hdr->heapUsed += bytes;
+        place(s);
+        return true;
+    }
+
+private:
+    int fd = -1;
+    uint8_t *base = nullptr;
+    size_t size = 0;
+    CacheHeader *hdr = nullptr;
+    CacheSlot *table = nullptr;
+    uint8_t *heap = nullptr;
+
+    static uint64_t fileSize(uint32_t slots, uint64_t heapBytes) {
+        return sizeof(CacheHeader) + (uint64_t)slots * sizeof(CacheSlot) + heapBytes;
+    }
+
+    uint32_t home(CacheKey key) const { return (uint32_t)(key.lo % hdr->slots); }
+
+    void place(const CacheSlot &s) {
+        uint32_t i = home(s.key);
+        while (table[i].key.hi != 0 || table[i].key.lo != 0) i = (i + 1) % hdr->slots;
+        table[i] = s;
+        hdr->entries++;
+    }
+
+    // Keeps the most recently used entries that fit in half the slots and
+    // half the heap (less the entry about to be added)
+    void compact(uint64_t needBytes) {
+        std::vector<CacheSlot> live;
+        for (uint32_t i = 0; i < hdr->slots; i++) {
+            if (table[i].key.hi != 0 || table[i].key.lo != 0) live.push_back(table[i]);
+        }
+        std::sort(live.begin(), live.end(), [](const CacheSlot &a, const CacheSlot &b) { return a.stamp > b.stamp; });
+        std::vector<uint8_t> data;
+        std::vector<CacheSlot> kept;
+        for (CacheSlot s : live) {
+            uint64_t bytes = s.length * sizeof(int32_t);
+            if (kept.size() + 1 > hdr->slots / 2 || data.size() + bytes + needBytes > hdr->heapSize / 2) break;
+            data.insert(data.end(), heap + s.offset, heap + s.offset + bytes);
+            s.offset = data.size() - bytes;
+            kept.push_back(s);
+        }
+        evicted += (int)(live.size() - kept.size());
+        std::fill(table, table + hdr->slots, CacheSlot());
+        hdr->entries = 0;
+        memcpy(heap, data.data(), data.size());
+        hdr->heapUsed = data.size();
+        for (const CacheSlot &s : kept) place(s);
+    }
+};
+
+struct CacheStats {
+    int cones = 0;
+    int hits = 0;
+    double savedMs = 0;    // mapping time recorded for the cones that hit
+    double mappedMs = 0;   // time spent mapping the rest
+};
+
+// Library and options a cover depends on
+inline CacheKey cacheLibraryKey(bool choices, bool exact) {
+    CacheKey k;
+    k.hi = cellLibraryHash() ^ CACHE_VERSION;
+    k.lo = 0xc2b2ae3d27d4eb4full ^ (choices ? 1 : 0) ^ (exact ? 2 : 0);
+    return k;
+}
+
+// Canonical numbering of one cone: its member nodes in id order (the builder
+// emits them in DFS order from the outputs, so this follows the structure and
+// not the names) and its inputs in order of first use
+struct ConeCanon {
+    CacheKey key;
+    std::vector<int> nodes;    // local index -> subject node
+    std::vector<int> inputs;   // input index -> subject node
+    std::unordered_map<int, int> code;   // subject node -> code: node index, or -1 - input index
+};
+
+inline ConeCanon canonicalizeCone(const SubjectGraph &sg, const ExactCone &cone, CacheKey lib) {
+    ConeCanon c;
+    for (int r : cone.nodes) {
+        for (int m = r; m >= 0; m = sg.nextChoice[m]) c.nodes.push_back(m);
+    }
+    std::sort(c.nodes.begin(), c.nodes.end());
+    for (size_t i = 0; i < c.nodes.size(); i++) c.code[c.nodes[i]] = (int)i;
+
+    CacheKey k = lib;
+    auto mix = [&](int64_t v) {
+        k.hi = (k.hi ^ (uint64_t)v) * 0x100000001b3ull;
+        k.lo = ((k.lo ^ (uint64_t)v) * 0xff51afd7ed558ccdull) ^ (k.lo >> 29);
+    };
+    auto codeOf = [&](int id) {
+        auto it = c.code.find(id);
+        if (it != c.code.end()) return it->second;
+        int in = -1 - (int)c.inputs.size();
+        c.inputs.push_back(id);
+        c.code[id] = in;
+        return in;
+    };
+    for (int id : c.nodes) {
+        const SgNode &n = sg.nodes[id];
+        mix((int)n.type);
+        mix(codeOf(n.in0));
+        mix(n.in1 >= 0 ? codeOf(n.in1) : 1 << 30);
+        mix(c.code[sg.repr[id]]);
+    }
+    for (int r : cone.roots) mix(codeOf(r));
+    if (k.hi == 0 && k.lo == 0) k.lo = 1;   // zero marks a free slot
+    c.key = k;
+    return c;
+}
+
+// calculateMinimalCost() (and calculateExactCost() when exact is set) through
+// the cache: cones found in it take their cover from the file, the others are
+// mapped together and stored. The mapping time of a miss is split over its
+// cones by node count. Returns the total cost.
+inline int calculateCachedCost(TechnologyMapper &tm, ResultCache &cache, bool exact,
+                               CacheStats *stats = nullptr) {
+    CacheStats st;
+    CacheKey lib = cacheLibraryKey(tm.graph.choiceClasses > 0, exact);
+    std::vector<ExactCone> cones = collectCones(tm);
+    st.cones = (int)cones.size();
+
+    // decode the hits now; their covers move once misses are inserted
+    std::vector<ConeCanon> canon;
+    std::vector<std::vector<std::pair<int, Match>>> cached(cones.size());
+    std::vector<char> hit(cones.size(), 0);
+    std::vector<int> missedRoots;
+    for (size_t i = 0; i < cones.size(); i++) {
+        canon.push_back(canonicalizeCone(tm.graph, cones[i], lib));
+        const ConeCanon &c = canon.back();
+        const CacheSlot *s = cache.find(c.key);
+        if (s) {
+            // [root code, cell, leaf count, leaf codes...] per cell
+            const int32_t *p = cache.cover(*s), *end = p + s->length;
+            bool ok = true;
+            auto node = [&](int32_t code) {
+                if (code >= 0 && code < (int32_t)c.nodes.size()) return c.nodes[code];
+                if (code < 0 && -1 - code < (int32_t)c.inputs.size()) return c.inputs[-1 - code];
+                ok = false;
+                return 0;
+            };
+            while (ok && p + 3 <= end) {
+                Match m;
+                int root = node(p[0]);
+                m.cell = (GateType)p[1];
+                m.numLeaves = (uint8_t)p[2];
+                p += 3;
+                if (m.numLeaves > 4 || p + m.numLeaves > end) break;
+                for (int l = 0; l < m.numLeaves; l++) m.leaves[l] = node(*p++);
+                cached[i].push_back({root, m});
+            }
+            if (ok && p == end) {
+                hit[i] = 1;
+                st.hits++;
+                st.savedMs += s->ms;
+                continue;
+            }
+            cached[i].clear();
+        }
+        missedRoots.insert(missedRoots.end(), cones[i].roots.begin(), cones[i].roots.end());
+    }
+
+    // map only the missed cones
+    std::vector<int> allOutputs = tm.graph.outputs;
+    tm.graph.outputs = missedRoots;
+    auto t0 = std::chrono::steady_clock::now();
+    int total = tm.calculateMinimalCost();
+    if (total >= 0 && exact) total = calculateExactCost(tm);
+    st.mappedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    tm.graph.outputs = allOutputs;
+    if (total < 0) return -1;
+
+    int missedNodes = 0;
+    std::vector<int> coneOf(tm.graph.size(), -1);
+    for (size_t i = 0; i < cones.size(); i++) {
+        if (hit[i]) continue;
+        missedNodes += (int)canon[i].nodes.size();
+        for (int id : canon[i].nodes) coneOf[id] = (int)i;
+    }
+    std::vector<std::vector<int32_t>> covers(cones.size());
+    std::vector<int> costs(cones.size(), 0);
+    for (int id : tm.cover) {
+        int i = coneOf[id];
+        const Match &m = tm.best[id];
+        const ConeCanon &c = canon[i];
+        covers[i].push_back(c.code.at(id));
+        covers[i].push_back((int32_t)m.cell);
+        covers[i].push_back(m.numLeaves);
+        for (int l = 0; l < m.numLeaves; l++) covers[i].push_back(c.code.at(m.leaves[l]));
+        costs[i] += cellCost(m.cell);
+    }
+    for (size_t i = 0; i < cones.size(); i++) {
+        if (hit[i]) continue;
+        float ms = missedNodes ? (float)(st.mappedMs * canon[i].nodes.size() / missedNodes) : 0;
+        cache.insert(canon[i].key, costs[i], ms, covers[i]);
+    }
+
+    for (size_t i = 0; i < cones.size(); i++) {
+        for (const auto &cm : cached[i]) {
+            tm.best[cm.first] = cm.second;
+            tm.chosen[tm.graph.repr[cm.first]] = cm.first;
+        }
+    }
+    if (stats) *stats = st;
+    return tm.extractCover();
+}
+
+#endif
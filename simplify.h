@@ -0,0 +1,240 @@
+// simplify.h
+// Constant propagation and trivial-logic cleanup on the netlist, run before
+// the subject graph is built. Tie-offs ("0"/"1") are folded through the
+// gates, repeated inputs (AND x x) are dropped, gates that see x and NOT x
+// collapse to a constant and chains of inverters cancel. Without this every
+// such gate is mapped and paid for like real logic.
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <string>
+#include <vector>
+
+#include "netlist.h"
+#include "subject_graph.h"
+
+struct SimplifyStats {
+    int gatesBefore = 0;     // cells in the cone (not counting inputs, buffers, tie-offs)
+    int gatesAfter = 0;
+    int constants = 0;       // gates folded because of a constant input
+    int idempotent = 0;      // gates with a repeated input
+    int complementary = 0;   // gates that saw x and NOT x
+    int inverters = 0;       // NOTs cancelled by another inversion
+};
+
+// Every signal becomes a literal over the nodes that survive: 0 and 1 are the
+// constants, 2 * (k + 1) + neg is node k, possibly inverted. Inverters only
+// flip the literal and are put back on the way out where a node is read
+// inverted, so one pass in topological order does all of the rewriting.
+class NetlistSimplifier {
+public:
+    NetlistSimplifier(const Netlist &n, SimplifyStats &s) : nl(n), st(s) {}
+
+    bool run(Netlist &out) {
+        if (reportLoops(nl) > 0) return false;
+        std::vector<int> order;
+        if (!topoOrder(nl, order)) return false;
+
+        lit.assign(nl.size(), -1);
+        for (int id : order) {
+            const Gate &g = nl.gates[id];
+            std::vector<int> in;
+            for (int i : g.inputs) in.push_back(lit[i]);
+            switch (g.type) {
+                case GateType::INPUT: lit[id] = newNode(GateType::INPUT, {}, id); break;
+                case GateType::CONST0: lit[id] = 0; break;
+                case GateType::CONST1: lit[id] = 1; break;
+                case GateType::OUTPUT: lit[id] = in[0]; break;
+                case GateType::NOT:
+                    if (in[0] < 2) st.constants++;
+                    else if (in[0] & 1) st.inverters++;
+                    lit[id] = in[0] ^ 1;
+                    break;
+                case GateType::AND:
+                case GateType::OR:
+                case GateType::NAND2:
+                case GateType::NOR2: {
+                    bool isAnd = g.type == GateType::AND || g.type == GateType::NAND2;
+                    bool inverted = g.type == GateType::NAND2 || g.type == GateType::NOR2;
+                    int r = reduce(isAnd, in);
+                    lit[id] = r >= 0 ? r ^ (int)inverted : newNode(g.type, in, id);
+                    break;
+                }
+                case GateType::AOI21: {
+                    std::vector<int> t = {in[0], in[1]};
+                    int r = reduce(true, t);
+                    if (r < 0) lit[id] = aoiTail(t, in[2], id);
+                    else lit[id] = nor2(r, in[2], id);
+                    break;
+                }
+                case GateType::AOI22: {
+                    std::vector<int> t1 = {in[0], in[1]}, t2 = {in[2], in[3]};
+                    int r1 = reduce(true, t1), r2 = reduce(true, t2);
+                    if (r1 < 0 && r2 < 0) lit[id] = newNode(GateType::AOI22, {t1[0], t1[1], t2[0], t2[1]}, id);
+                    else if (r1 < 0) lit[id] = aoiTail(t1, r2, id);
+                    else if (r2 < 0) lit[id] = aoiTail(t2, r1, id);
+                    else lit[id] = nor2(r1, r2, id);
+                    break;
+                }
+                default: return false;
+            }
+            if (g.type != GateType::INPUT && g.type != GateType::OUTPUT &&
+                g.type != GateType::CONST0 && g.type != GateType::CONST1) st.gatesBefore++;
+            // an inverted node gets its NOT named after the first signal that carries it
+            int l = lit[id];
+            if (l >= 2 && (l & 1) && negName[var(l)] < 0) negName[var(l)] = id;
+        }
+        write(out);
+        return true;
+    }
+
+private:
+    struct Node {
+        GateType type;
+        std::vector<int> ins;   // literals
+        int src;                // signal the node is named after
+    };
+
+    const Netlist &nl;
+    SimplifyStats &st;
+    std::vector<Node> nodes;
+    std::vector<int> lit;       // signal -> literal
+    std::vector<int> negName;   // node -> signal naming its inverted form, or -1
+    std::vector<int> stamp;     // node -> last reduce() that saw it
+    std::vector<int> seenLit;   // node -> literal it was seen as
+    int round = 0;
+
+    static int var(int l) { return l / 2 - 1; }
+
+    int newNode(GateType t, std::vector<int> ins, int src) {
+        nodes.push_back({t, std::move(ins), src});
+        negName.push_back(-1);
+        stamp.push_back(-1);
+        seenLit.push_back(-1);
+        return 2 * (int)nodes.size();
+    }
+
+    // AND (isAnd) or OR of lits. Returns the literal the gate reduces to, or
+    // -1 with lits left holding the distinct non-constant inputs.
+    int reduce(bool isAnd, std::vector<int> &lits) {
+        int identity = isAnd ? 1 : 0, absorbing = isAnd ? 0 : 1;
+        round++;
+        std::vector<int> kept;
+        bool folded = false, repeated = false;
+        for (int l : lits) {
+            if (l == identity) {
+                folded = true;
+                continue;
+            }
+            if (l == absorbing) {
+                st.constants++;
+                return absorbing;
+            }
+            int v = var(l);
+            if (stamp[v] == round) {
+                if (seenLit[v] != l) {
+                    st.complementary++;
+                    return absorbing;
+                }
+                repeated = true;
+                continue;
+            }
+            stamp[v] = round;
+            seenLit[v] = l;
+            kept.push_back(l);
+        }
+        if (folded) st.constants++;
+        if (repeated) st.idempotent++;
+        if (kept.empty()) return identity;
+        if (kept.size() == 1) return kept[0];
+        lits.swap(kept);
+        return -1;
+    }
+
+    // NOT(a OR b)
+    int nor2(int a, int b, int src) {
+        std::vector<int> o = {a, b};
+        int r = reduce(false, o);
+        return r >= 0 ? r ^ 1 : newNode(GateType::NOR2, o, src);
+    }
+
+    // NOT(AND(t) OR c) where AND(t) did not reduce
+    int aoiTail(const std::vector<int> &t, int c, int src) {
+        if (c < 2) st.constants++;
+        if (c == 1) return 0;
+        if (c == 0) return newNode(GateType::NAND2, t, src);
+        return newNode(GateType::AOI21, {t[0], t[1], c}, src);
+    }
+
+    // Emits the nodes the outputs reach, with one NOT per node read inverted
+    void write(Netlist &out) {
+        int n = (int)nodes.size();
+        std::vector<char> need(n, 0), needNeg(n, 0);
+        auto mark = [&](int l) {
+            if (l < 2) return;
+            need[var(l)] = 1;
+            if (l & 1) needNeg[var(l)] = 1;
+        };
+        for (int o : nl.outputs) mark(lit[o]);
+        for (int k = n - 1; k >= 0; k--) {
+            if (need[k])
+                for (int l : nodes[k].ins) mark(l);
+        }
+
+        std::vector<int> pos(n, -1), neg(n, -1);
+        auto signal = [&](int l) {
+            if (l < 2) return out.intern(l ? "1" : "0");
+            return (l & 1) ? neg[var(l)] : pos[var(l)];
+        };
+        for (int k = 0; k < n; k++) {
+            if (!need[k]) continue;
+            std::vector<int> in;
+            for (int l : nodes[k].ins) in.push_back(signal(l));
+            pos[k] = out.intern(nl.names[nodes[k].src]);
+            out.gates[pos[k]].type = nodes[k].type;
+            out.gates[pos[k]].inputs = std::move(in);
+            if (nodes[k].type != GateType::INPUT) st.gatesAfter++;
+            if (!needNeg[k]) continue;
+            std::string name;
+            if (negName[k] >= 0) {
+                name = nl.names[negName[k]];
+            } else {
+                name = nl.names[nodes[k].src] + "_n";
+                while (nl.ids.count(name) || out.ids.count(name)) name += "_n";
+            }
+            neg[k] = out.intern(name);
+            out.gates[neg[k]].type = GateType::NOT;
+            out.gates[neg[k]].inputs = {pos[k]};
+            st.gatesAfter++;
+        }
+
+        // an output that now reads another signal (or a constant) becomes a
+        // buffer under its own name
+        for (int o : nl.outputs) {
+            const std::string &name = nl.names[o];
+            int src = signal(lit[o]);   // may intern "0"/"1", which can be outputs too
+            auto it = out.ids.find(name);
+            if (it != out.ids.end()) {
+                out.outputs.push_back(it->second);
+                continue;
+            }
+            int id = out.intern(name);
+            out.gates[id].type = GateType::OUTPUT;
+            out.gates[id].inputs = {src};
+            out.outputs.push_back(id);
+        }
+    }
+};
+
+// Writes the simplified copy of nl (its output cones only) to out. Output
+// names are kept; surviving gates keep their names and fan-in order. Returns
+// false, like buildSubjectGraph, on loops or malformed gates.
+inline bool simplifyNetlist(const Netlist &nl, Netlist &out, SimplifyStats *stats = nullptr) {
+    SimplifyStats st;
+    NetlistSimplifier s(nl, st);
+    bool ok = s.run(out);
+    if (stats) *stats = st;
+    return ok;
+}
+
+#endif
@@ -0,0 +1,463 @@
+// subject_graph.h
+// NAND2/NOT subject graph built from a Netlist. This is the graph the mapper
+// covers with library cells (the same decomposition calc_cost.cpp's
+// convertToNandNot does, but shared and structurally hashed).
+#ifndef SUBJECT_GRAPH_H
+#define SUBJECT_GRAPH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <tuple>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+#include "cell_library.h"
+#include "netlist.h"
+
+struct SgNode {
+    GateType type;   // INPUT, NOT or NAND2
+    int in0;
+    int in1;
+};
+
+// Structural hash of the subject graph: node key -> node id, with open
+// addressing and linear probing in two flat arrays. Every gate of the netlist
+// passes through it once or twice while building, so it avoids a node-based
+// map's allocation and pointer chase per entry.
+class StrashTable {
+public:
+    // Id stored for key, or -1
+    int find(uint64_t key) const {
+        if (keys.empty()) return -1;
+        for (size_t i = slot(key);; i = (i + 1) & mask) {
+            if (keys[i] == key) return ids[i];
+            if (keys[i] == EMPTY) return -1;
+        }
+    }
+
+    // Stores id for key unless key is already there
+    void emplace(uint64_t key, int id) {
+        if ((count + 1) * 4 > keys.size() * 3) rehash(std::max<size_t>(16, 2 * keys.size()));
+        size_t i = slot(key);
+        for (; keys[i] != EMPTY; i = (i + 1) & mask)
+            if (keys[i] == key) return;
+        keys[i] = key;
+        ids[i] = id;
+        count++;
+    }
+
+    // Makes room for n keys without growing again
+    void reserve(size_t n) {
+        size_t capacity = 16;
+        while (capacity * 3 < n * 4) capacity *= 2;
+        if (capacity > keys.size()) rehash(capacity);
+    }
+
+    // Empties the table but keeps its storage
+    void clear() {
+        std::fill(keys.begin(), keys.end(), EMPTY);
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    static constexpr uint64_t EMPTY = ~uint64_t(0);   // no node has in0 = -1
+    std::vector<uint64_t> keys;
+    std::vector<int> ids;
+    size_t mask = 0, count = 0;
+    int shift = 64;
+
+    // Fibonacci hashing: the top bits of key * 2^64 / phi
+    size_t slot(uint64_t key) const { return (size_t)((key * 0x9E3779B97F4A7C15ull) >> shift); }
+
+    void rehash(size_t capacity) {
+        std::vector<uint64_t> oldKeys(capacity, EMPTY);
+        std::vector<int> oldIds(capacity);
+        oldKeys.swap(keys);
+        oldIds.swap(ids);
+        mask = capacity - 1;
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) shift--;
+        count = 0;
+        for (size_t i = 0; i < oldKeys.size(); i++)
+            if (oldKeys[i] != EMPTY) emplace(oldKeys[i], oldIds[i]);
+    }
+};
+
+// Node ids are created fan-ins first, so increasing id is a topological order.
+// Equivalent nodes can be linked into a choice class: the first node of the
+// class is its representative and the others are alternative structures for
+// the same function that the mapper may pick instead.
+struct SubjectGraph {
+    std::vector<SgNode> nodes;
+    std::vector<int> level;        // logic depth of each node
+    std::vector<int> source;       // netlist signal a node implements, -1 if internal
+    std::vector<int> repr;         // representative of the node's choice class
+    std::vector<int> nextChoice;   // next node of the same class, -1 at the end
+    std::vector<int> outputs;      // subject node of each netlist output
+    StrashTable strash;
+    int choiceClasses = 0;
+    int choiceNodes = 0;           // nodes created only for alternatives
+
+    int size() const { return (int)nodes.size(); }
+
+    int addInput(int src) {
+        nodes.push_back({GateType::INPUT, -1, -1});
+        level.push_back(0);
+        source.push_back(src);
+        repr.push_back(size() - 1);
+        nextChoice.push_back(-1);
+        return size() - 1;
+    }
+
+    // NOT(NOT(x)) folds back to x
+    int addNot(int a) {
+        if (nodes[a].type == GateType::NOT) return nodes[a].in0;
+        return addNode(GateType::NOT, a, -1);
+    }
+
+    int addNand(int a, int b) {
+        if (a > b) std::swap(a, b);
+        return addNode(GateType::NAND2, a, b);
+    }
+
+    int addAnd(int a, int b) { return addNot(addNand(a, b)); }
+    int addOr(int a, int b) { return addNand(addNot(a), addNot(b)); }
+
+    // Links alt into the choice class of rep
+    void addChoice(int rep, int alt) {
+        if (nextChoice[rep] < 0) choiceClasses++;
+        repr[alt] = rep;
+        nextChoice[alt] = nextChoice[rep];
+        nextChoice[rep] = alt;
+    }
+
+    // Structural hash key of a node; b is -1 for NOT
+    static uint64_t strashKey(int a, int b) {
+        return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+    }
+
+private:
+    int addNode(GateType t, int a, int b) {
+        uint64_t key = strashKey(a, b);
+        int found = strash.find(key);
+        if (found >= 0) return found;
+        nodes.push_back({t, a, b});
+        level.push_back(1 + std::max(level[a], b >= 0 ? level[b] : 0));
+        source.push_back(-1);
+        repr.push_back(size() - 1);
+        nextChoice.push_back(-1);
+        strash.emplace(key, size() - 1);
+        return size() - 1;
+    }
+};
+
+// Turns a wide AND/OR into a tree of 2-input gates. Operands are combined
+// lowest level first (Huffman order), which gives the minimum-depth tree in
+// O(n log n). Among operands at the same level, inverted ones (NOT nodes) are
+// paired with each other first: AND of two of them is a NOR2 and OR of two
+// AND terms is the AOI22 shape, so the decomposition feeds the matcher the
+// patterns it can use instead of an arbitrary chain.
+inline int decomposeWide(SubjectGraph &sg, bool isAnd, const std::vector<int> &ops) {
+    typedef std::tuple<int, int, int, int> Entry;   // level, class, seq, node
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+    int seq = 0;
+    auto push = [&](int n) {
+        int cls = sg.nodes[n].type == GateType::NOT ? 0 : 1;
+        pq.emplace(sg.level[n], cls, seq++, n);
+    };
+    for (int n : ops) push(n);
+    while (pq.size() > 1) {
+        int a = std::get<3>(pq.top()); pq.pop();
+        int b = std::get<3>(pq.top()); pq.pop();
+        push(isAnd ? sg.addAnd(a, b) : sg.addOr(a, b));
+    }
+    return std::get<3>(pq.top());
+}
+
+// Orders the cone of the outputs so that every gate comes after its fan-ins.
+// Returns false (and names the signal) on an undefined signal or a gate with
+// the wrong number of inputs. The netlist must be loop-free (see findLoops).
+inline bool topoOrder(const Netlist &nl, std::vector<int> &order) {
+    std::vector<char> seen(nl.size(), 0);
+    std::vector<std::pair<int, size_t>> stack;
+    for (int o : nl.outputs) {
+        if (seen[o]) continue;
+        stack.push_back({o, 0});
+        seen[o] = 1;
+        while (!stack.empty()) {
+            int id = stack.back().first;
+            const Gate &g = nl.gates[id];
+            if (stack.back().second == 0 && !validArity(g)) {
+                std::cerr << "Signal '" << nl.names[id] << "' is undefined or has the wrong number of inputs" << std::endl;
+                return false;
+            }
+            if (stack.back().second < g.inputs.size()) {
+                int in = g.inputs[stack.back().second++];
+                if (!seen[in]) {
+                    seen[in] = 1;
+                    stack.push_back({in, 0});
+                }
+            } else {
+                order.push_back(id);
+                stack.pop_back();
+            }
+        }
+    }
+    return true;
+}
+
+// Limits on the alternatives recorded by buildSubjectGraph
+static const int MAX_SUPERGATE_LEAVES = 16;
+static const double MAX_CHOICE_OVERHEAD = 1.0;   // alternative nodes per base node
+
+// Collects the operands of the AND (isAnd) or OR tree that computes signal
+// id, inverted if invert is set. The walk continues through single-fanout
+// gates of the same kind, through inverters, and through De Morgan
+// (NOT(OR(a,b)) is AND(NOT a, NOT b)). Leaves are subject graph literals.
+inline void collectSupergate(const Netlist &nl, const std::vector<int> &nlFanout,
+                             const std::vector<int> &lit, SubjectGraph &sg, int id,
+                             bool isAnd, bool invert, bool root, std::vector<int> &leaves) {
+    const Gate &g = nl.gates[id];
+    bool single = root || nlFanout[id] == 1;
+    GateType same = isAnd ? GateType::AND : GateType::OR;
+    GateType dual = isAnd ? GateType::OR : GateType::AND;
+    if (single && leaves.size() <= (size_t)MAX_SUPERGATE_LEAVES) {
+        if (g.type == GateType::NOT) {
+            collectSupergate(nl, nlFanout, lit, sg, g.inputs[0], isAnd, !invert, false, leaves);
+            return;
+        }
+        if (g.type == (invert ? dual : same)) {
+            for (int in : g.inputs)
+                collectSupergate(nl, nlFanout, lit, sg, in, isAnd, invert, false, leaves);
+            return;
+        }
+    }
+    leaves.push_back(invert ? sg.addNot(lit[id]) : lit[id]);
+}
+
+// True if node can reach rep through nodes newer than rep
+inline bool reachesNode(const SubjectGraph &sg, int node, int rep) {
+    std::vector<int> stack = {node};
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        if (id == rep) return true;
+        if (id < rep) continue;
+        stack.push_back(sg.nodes[id].in0);
+        if (sg.nodes[id].in1 >= 0) stack.push_back(sg.nodes[id].in1);
+    }
+    return false;
+}
+
+// Builds re-associated versions of the AND/OR tree behind netlist gate id and
+// records them as choices of rep: the balanced decomposition of the whole
+// supergate and the left-to-right chain in netlist order.
+inline void addAlternatives(const Netlist &nl, const std::vector<int> &nlFanout,
+                            const std::vector<int> &lit, SubjectGraph &sg, int id, int rep) {
+    const Gate &g = nl.gates[id];
+    bool isAnd;
+    bool invert = false;
+    if (g.type == GateType::AND || g.type == GateType::OR) {
+        isAnd = g.type == GateType::AND;
+    } else if (g.type == GateType::NOT && nlFanout[g.inputs[0]] == 1 &&
+               (nl.gates[g.inputs[0]].type == GateType::AND || nl.gates[g.inputs[0]].type == GateType::OR)) {
+        // NOT(AND) is an OR of inverted operands and NOT(OR) an AND of them
+        isAnd = nl.gates[g.inputs[0]].type == GateType::OR;
+        invert = true;
+        id = g.inputs[0];
+    } else {
+        return;
+    }
+
+    int before = sg.size();
+    std::vector<int> leaves;
+    collectSupergate(nl, nlFanout, lit, sg, id, isAnd, invert, true, leaves);
+    if (leaves.size() >= 3 && leaves.size() <= (size_t)MAX_SUPERGATE_LEAVES) {
+        int alts[2];
+        alts[0] = decomposeWide(sg, isAnd, leaves);
+        alts[1] = leaves[0];
+        for (size_t i = 1; i < leaves.size(); i++)
+            alts[1] = isAnd ? sg.addAnd(alts[1], leaves[i]) : sg.addOr(alts[1], leaves[i]);
+        for (int alt : alts) {
+            if (alt <= rep || sg.repr[alt] != alt || sg.nextChoice[alt] >= 0) continue;
+            // a member built on top of another member would make a cycle
+            bool cyclic = false;
+            for (int m = rep; m >= 0 && !cyclic; m = sg.nextChoice[m])
+                cyclic = reachesNode(sg, alt, m);
+            if (!cyclic) sg.addChoice(rep, alt);
+        }
+    }
+    sg.choiceNodes += sg.size() - before;
+}
+
+// Lowers one netlist gate (signal id) to NAND2/NOT over the subject nodes of
+// its fan-ins, in. Returns the node that implements it, -1 for a type the
+// subject graph doesn't know.
+inline int lowerGate(SubjectGraph &sg, GateType type, const std::vector<int> &in, int id) {
+    int n = -1;
+    switch (type) {
+        case GateType::INPUT:
+        case GateType::CONST0:
+        case GateType::CONST1: n = sg.addInput(id); break;   // tie-offs are free leaves
+        case GateType::OUTPUT: n = in[0]; break;
+        case GateType::NOT: n = sg.addNot(in[0]); break;
+        case GateType::AND: n = decomposeWide(sg, true, in); break;
+        case GateType::OR: n = decomposeWide(sg, false, in); break;
+        case GateType::NAND2: n = sg.addNand(in[0], in[1]); break;
+        case GateType::NOR2: n = sg.addNot(sg.addOr(in[0], in[1])); break;
+        case GateType::AOI21:
+            n = sg.addNot(sg.addOr(sg.addAnd(in[0], in[1]), in[2]));
+            break;
+        case GateType::AOI22:
+            n = sg.addNot(sg.addOr(sg.addAnd(in[0], in[1]), sg.addAnd(in[2], in[3])));
+            break;
+        default: return -1;
+    }
+    if (sg.source[n] < 0) sg.source[n] = id;
+    return n;
+}
+
+// Lowers the cone of the netlist outputs to NAND2/NOT. With choices set,
+// AND/OR trees also get re-associated alternatives (see addAlternatives),
+// capped at MAX_CHOICE_OVERHEAD extra nodes per base node.
+inline bool buildSubjectGraph(const Netlist &nl, SubjectGraph &sg, bool choices = false) {
+    if (reportLoops(nl) > 0) return false;
+    std::vector<int> order;
+    if (!topoOrder(nl, order)) return false;
+
+    std::vector<int> nlFanout(nl.size(), 0);
+    if (choices) {
+        for (int id : order)
+            for (int in : nl.gates[id].inputs) nlFanout[in]++;
+        for (int o : nl.outputs) nlFanout[o]++;
+    }
+
+    std::vector<int> lit(nl.size(), -1);
+    for (int id : order) {
+        const Gate &g = nl.gates[id];
+        std::vector<int> in;
+        for (int i : g.inputs) in.push_back(lit[i]);
+        int before = sg.size();
+        int n = lowerGate(sg, g.type, in, id);
+        if (n < 0) return false;
+        lit[id] = n;
+        // only freshly built nodes get alternatives, which keeps every member
+        // of a class newer than the classes it depends on
+        if (choices && n >= before &&
+            sg.choiceNodes <= MAX_CHOICE_OVERHEAD * (sg.size() - sg.choiceNodes))
+            addAlternatives(nl, nlFanout, lit, sg, id, n);
+    }
+    for (int o : nl.outputs) sg.outputs.push_back(lit[o]);
+    return true;
+}
+
+// Node layouts for reorderSubjectGraph
+enum class NodeOrder { DFS, LEVEL };
+
+// Post-order DFS from the outputs, so a node sits right after the fan-ins it
+// was reached through and the mapper's sweep reads mostly recent entries. A
+// choice class is visited as one unit: the fan-ins of all its members come
+// first, then the members back to back. Nodes no output reaches go last.
+inline std::vector<int> dfsNodeOrder(const SubjectGraph &sg) {
+    struct Frame { int rep; int member; int input; };
+    int n = sg.size();
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> state(n, 0);   // by representative: 0 new, 1 open, 2 placed
+    std::vector<Frame> stack;
+    auto visit = [&](int id) {
+        int r = sg.repr[id];
+        if (state[r]) return;
+        state[r] = 1;
+        stack.push_back({r, r, 0});
+        while (!stack.empty()) {
+            Frame &f = stack.back();
+            if (f.member < 0) {
+                for (int m = f.rep; m >= 0; m = sg.nextChoice[m]) order.push_back(m);
+                state[f.rep] = 2;
+                stack.pop_back();
+                continue;
+            }
+            const SgNode &s = sg.nodes[f.member];
+            int in = f.input == 0 ? s.in0 : s.in1;
+            if (++f.input == 2) {
+                f.member = sg.nextChoice[f.member];
+                f.input = 0;
+            }
+            if (in >= 0 && state[sg.repr[in]] == 0) {
+                state[sg.repr[in]] = 1;
+                stack.push_back({sg.repr[in], sg.repr[in], 0});
+            }
+        }
+    };
+    for (int o : sg.outputs) visit(o);
+    for (int i = 0; i < n; i++) visit(i);
+    return order;
+}
+
+// Nodes by logic level, ties in id order. Members of a choice class can be
+// deeper than the nodes reading the class, so graphs with choices use the
+// DFS order instead.
+inline std::vector<int> levelNodeOrder(const SubjectGraph &sg) {
+    if (sg.choiceClasses > 0) return dfsNodeOrder(sg);
+    int n = sg.size();
+    int maxLevel = 0;
+    for (int l : sg.level) maxLevel = std::max(maxLevel, l);
+    std::vector<int> start(maxLevel + 2, 0);
+    for (int l : sg.level) start[l + 1]++;
+    for (int l = 0; l <= maxLevel; l++) start[l + 1] += start[l];
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++) order[start[sg.level[i]]++] = i;
+    return order;
+}
+
+// Renumbers the graph so that order[k] becomes node k. order must list every
+// node once, fan-ins before readers. NAND fan-ins stay sorted and the
+// structural hash, if still kept, is rebuilt under the new ids.
+inline void applyNodeOrder(SubjectGraph &sg, const std::vector<int> &order) {
+    int n = sg.size();
+    std::vector<int> newId(n);
+    for (int k = 0; k < n; k++) newId[order[k]] = k;
+    auto remap = [&](int id) { return id < 0 ? id : newId[id]; };
+
+    std::vector<SgNode> nodes(n);
+    std::vector<int> level(n), source(n), repr(n), nextChoice(n);
+    for (int k = 0; k < n; k++) {
+        int old = order[k];
+        SgNode s = sg.nodes[old];
+        s.in0 = remap(s.in0);
+        s.in1 = remap(s.in1);
+        if (s.type == GateType::NAND2 && s.in0 > s.in1) std::swap(s.in0, s.in1);
+        nodes[k] = s;
+        level[k] = sg.level[old];
+        source[k] = sg.source[old];
+        repr[k] = newId[sg.repr[old]];
+        nextChoice[k] = remap(sg.nextChoice[old]);
+    }
+    sg.nodes.swap(nodes);
+    sg.level.swap(level);
+    sg.source.swap(source);
+    sg.repr.swap(repr);
+    sg.nextChoice.swap(nextChoice);
+    for (int &o : sg.outputs) o = newId[o];
+    if (!sg.strash.empty()) {
+        sg.strash.clear();
+        for (int k = 0; k < n; k++) {
+            if (sg.nodes[k].type != GateType::INPUT)
+                sg.strash.emplace(SubjectGraph::strashKey(sg.nodes[k].in0, sg.nodes[k].in1), k);
+        }
+    }
+}
+
+inline void reorderSubjectGraph(SubjectGraph &sg, NodeOrder order = NodeOrder::DFS) {
+    applyNodeOrder(sg, order == NodeOrder::DFS ? dfsNodeOrder(sg) : levelNodeOrder(sg));
+}
+
+#endif
@@ -5,9 +5,10 @@
 #include <vector>
 #include <string>
 #include <climits>
-using namespace std;
 
-enum GateType { INPUT, OUTPUT, AND, OR, NOT, UNKNOWN };
+#include "cell_library.h"
+
+using namespace std;
 
 struct Node {
     GateType type;
@@ -16,17 +17,10 @@ struct Node {
 
 struct TreeNode {
     string name;               // logical name for memoization
-    string gate;               // "NAND", "NOT", or "INPUT"
+    GateType gate;             // NAND2, NOT, or INPUT
     vector<TreeNode*> inputs; // input TreeNode pointers
 };
 
-GateType getGateType(const string& s) {
-    if (s == "AND") return AND;
-    if (s == "OR") return OR;
-    if (s == "NOT") return NOT;
-    return UNKNOWN;
-}
-
 void readNetlist(const string& filename, unordered_map<string, Node>& circuit, string& outputName) {
     ifstream file(filename);
     string line;
@@ -39,14 +33,14 @@ void readNetlist(const string& filename, unordered_map<string, Node>& circuit, s
         ss >> typeOrEqual;
 
         if (typeOrEqual == "INPUT") {
-            circuit[name] = {INPUT, {}};
+            circuit[name] = {GateType::INPUT, {}};
         } else if (typeOrEqual == "OUTPUT") {
             outputName = name;
         } else if (typeOrEqual == "=") {
             string gateTypeStr;
             ss >> gateTypeStr;
 
-            GateType gateType = getGateType(gateTypeStr);
+            GateType gateType = parseGateType(gateTypeStr);
             vector<string> inputs;
             string inputName;
             while (ss >> inputName) {
@@ -63,15 +57,15 @@ TreeNode* buildNandNotTree(string name, unordered_map<string, Node>& circuit, un
     if (memo.count(name)) return memo[name];
     Node& node = circuit[name];
 
-    if (node.type == INPUT) {
-        TreeNode* leaf = new TreeNode{name, "INPUT", {}};
+    if (node.type == GateType::INPUT) {
+        TreeNode* leaf = new TreeNode{name, GateType::INPUT, {}};
         memo[name] = leaf;
         return leaf;
     }
 
-    if (node.type == NOT) {
+    if (node.type == GateType::NOT) {
         TreeNode* child = buildNandNotTree(node.inputs[0], circuit, memo);
-        TreeNode* notNode = new TreeNode{name, "NOT", {child}};
+        TreeNode* notNode = new TreeNode{name, GateType::NOT, {child}};
         memo[name] = notNode;
         return notNode;
     }
@@ -79,16 +73,16 @@ TreeNode* buildNandNotTree(string name, unordered_map<string, Node>& circuit, un
     TreeNode* a = buildNandNotTree(node.inputs[0], circuit, memo);
     TreeNode* b = buildNandNotTree(node.inputs[1], circuit, memo);
 
-    if (node.type == AND) {
-        TreeNode* nandNode = new TreeNode{name + "_nand", "NAND", {a, b}};
-        TreeNode* notNode = new TreeNode{name, "NOT", {nandNode}};
+    if (node.type == GateType::AND) {
+        TreeNode* nandNode = new TreeNode{name + "_nand", GateType::NAND2, {a, b}};
+        TreeNode* notNode = new TreeNode{name, GateType::NOT, {nandNode}};
         memo[name] = notNode;
         return notNode;
     }
-    if (node.type == OR) {
-        TreeNode* notA = new TreeNode{name + "_na", "NOT", {a}};
-        TreeNode* notB = new TreeNode{name + "_nb", "NOT", {b}};
-        TreeNode* nandNode = new TreeNode{name, "NAND", {notA, notB}};
+    if (node.type == GateType::OR) {
+        TreeNode* notA = new TreeNode{name + "_na", GateType::NOT, {a}};
+        TreeNode* notB = new TreeNode{name + "_nb", GateType::NOT, {b}};
+        TreeNode* nandNode = new TreeNode{name, GateType::NAND2, {notA, notB}};
         memo[name] = nandNode;
         return nandNode;
     }
@@ -96,152 +90,152 @@ TreeNode* buildNandNotTree(string name, unordered_map<string, Node>& circuit, un
 }
 
 int computeMinCost(TreeNode* node, unordered_map<TreeNode*, int>& dp) {
-    cout << "Evaluating node: " << node->name << " (" << node->gate << ")" << endl;
-    cout << "Evaluating node: " << node->name << " (" << node->gate << ")" << endl;
+    cout << "Evaluating node: " << node->name << " (" << gateTypeName(node->gate) << ")" << endl;
+    cout << "Evaluating node: " << node->name << " (" << gateTypeName(node->gate) << ")" << endl;
     if (dp.count(node)) return dp[node];
 
     int minCost = INT_MAX;
 
     // Base case: input
-    if (node->gate == "INPUT") {
+    if (node->gate == GateType::INPUT) {
         dp[node] = 0;
         return 0;
     }
 
     // Try matching AOI22 = NOT(NAND(NAND(x, y), NAND(z, w)))
-    if (node->gate == "NOT" && node->inputs.size() == 1) {
+    if (node->gate == GateType::NOT && node->inputs.size() == 1) {
         TreeNode* nandTop = node->inputs[0];
-        if (nandTop->gate == "NAND" && nandTop->inputs.size() == 2) {
+        if (nandTop->gate == GateType::NAND2 && nandTop->inputs.size() == 2) {
             TreeNode* n1 = nandTop->inputs[0];
             TreeNode* n2 = nandTop->inputs[1];
-            if (n1->gate == "NAND" && n1->inputs.size() == 2 &&
-                n2->gate == "NAND" && n2->inputs.size() == 2) {
+            if (n1->gate == GateType::NAND2 && n1->inputs.size() == 2 &&
+                n2->gate == GateType::NAND2 && n2->inputs.size() == 2) {
                 int a = computeMinCost(n1->inputs[0], dp);
                 int b = computeMinCost(n1->inputs[1], dp);
                 int c = computeMinCost(n2->inputs[0], dp);
                 int d = computeMinCost(n2->inputs[1], dp);
-                dp[node] = 7;
-                cout << "--> Matched AOI22 at " << node->name << " = 7" << endl;
-                return 7;
+                dp[node] = AOI22_COST;
+                cout << "--> Matched AOI22 at " << node->name << " = " << dp[node] << endl;
+                return dp[node];
             }
         }
     }
 
     // Try matching AOI21 = NOT(NAND(NAND(x, y), z))
-    if (node->gate == "NOT" && node->inputs.size() == 1) {
+    if (node->gate == GateType::NOT && node->inputs.size() == 1) {
         TreeNode* nand1 = node->inputs[0];
-        if (nand1->gate == "NAND" && nand1->inputs.size() == 2) {
+        if (nand1->gate == GateType::NAND2 && nand1->inputs.size() == 2) {
             TreeNode* n1 = nand1->inputs[0];
             TreeNode* n2 = nand1->inputs[1];
-            if (n1->gate == "NAND" && n1->inputs.size() == 2) {
+            if (n1->gate == GateType::NAND2 && n1->inputs.size() == 2) {
                 int a = computeMinCost(n1->inputs[0], dp);
                 int b = computeMinCost(n1->inputs[1], dp);
                 int c = computeMinCost(n2, dp);
-                dp[node] = 7;
-                cout << "--> Matched AOI21 at " << node->name << " = 7" << endl;
-                return 7;
+                dp[node] = AOI21_COST;
+                cout << "--> Matched AOI21 at " << node->name << " = " << dp[node] << endl;
+                return dp[node];
             }
         }
     }
 
     // Try matching AND = NOT(NAND(x,y))
-    if (node->gate == "NOT" && node->inputs.size() == 1) {
+    if (node->gate == GateType::NOT && node->inputs.size() == 1) {
         TreeNode* nandChild = node->inputs[0];
-        if (nandChild->gate == "NAND" && nandChild->inputs.size() == 2) {
+        if (nandChild->gate == GateType::NAND2 && nandChild->inputs.size() == 2) {
             int c1 = computeMinCost(nandChild->inputs[0], dp);
             int c2 = computeMinCost(nandChild->inputs[1], dp);
-            dp[node] = 4;
-            cout << "--> Matched AND2 at " << node->name << " = 4" << endl;
-            return 4;
+            dp[node] = AND2_COST;
+            cout << "--> Matched AND2 at " << node->name << " = " << dp[node] << endl;
+            return dp[node];
         }
     }
 
     // Try matching OR = NAND(NOT(x), NOT(y))
-    if (node->gate == "NAND" && node->inputs.size() == 2) {
+    if (node->gate == GateType::NAND2 && node->inputs.size() == 2) {
         TreeNode* n1 = node->inputs[0];
         TreeNode* n2 = node->inputs[1];
-        if (n1->gate == "NOT" && n2->gate == "NOT" &&
+        if (n1->gate == GateType::NOT && n2->gate == GateType::NOT &&
             n1->inputs.size() == 1 && n2->inputs.size() == 1) {
             int x = computeMinCost(n1->inputs[0], dp);
             int y = computeMinCost(n2->inputs[0], dp);
-            dp[node] = x + y + 4;
+            dp[node] = x + y + OR2_COST;
             cout << "--> Matched OR2 at " << node->name << " = " << dp[node] << endl;
             return dp[node];
         }
     }
 
     // Try matching as NOT gate
-    if (node->gate == "NOT" && node->inputs.size() == 1) {
+    if (node->gate == GateType::NOT && node->inputs.size() == 1) {
         int childCost = computeMinCost(node->inputs[0], dp);
-        dp[node] = childCost + 2;
+        dp[node] = childCost + NOT_COST;
         cout << "--> Matched NOT at " << node->name << " = " << dp[node] << endl;
         return dp[node];
     }
 
     // Try matching as NAND gate
-    if (node->gate == "NAND" && node->inputs.size() == 2) {
+    if (node->gate == GateType::NAND2 && node->inputs.size() == 2) {
         int leftCost = computeMinCost(node->inputs[0], dp);
         int rightCost = computeMinCost(node->inputs[1], dp);
-        dp[node] = leftCost + rightCost + 3;
+        dp[node] = leftCost + rightCost + NAND2_COST;
         cout << "--> Matched NAND2 at " << node->name << " = " << dp[node] << endl;
         return dp[node];
     }
 
     // Try matching as NAND gate
-    if (node->gate == "NAND" && node->inputs.size() == 2) {
+    if (node->gate == GateType::NAND2 && node->inputs.size() == 2) {
         int leftCost = computeMinCost(node->inputs[0], dp);
         int rightCost = computeMinCost(node->inputs[1], dp);
-        minCost = min(minCost, leftCost + rightCost + 3);
+        minCost = min(minCost, leftCost + rightCost + NAND2_COST);
     }
 
     // Try matching as AND = NOT(NAND(x,y))
-    if (node->gate == "NOT" && node->inputs.size() == 1) {
+    if (node->gate == GateType::NOT && node->inputs.size() == 1) {
         TreeNode* nandChild = node->inputs[0];
-        if (nandChild->gate == "NAND" && nandChild->inputs.size() == 2) {
-            minCost = min(minCost, 4); // AND2 = 4 from tech library // match AND2 gate from tech library
+        if (nandChild->gate == GateType::NAND2 && nandChild->inputs.size() == 2) {
+            minCost = min(minCost, AND2_COST); // match AND2 gate from tech library
         }
     }
 
     // Try matching as OR = NAND(NOT(x), NOT(y))
-    if (node->gate == "NAND" && node->inputs.size() == 2) {
+    if (node->gate == GateType::NAND2 && node->inputs.size() == 2) {
         TreeNode* n1 = node->inputs[0];
         TreeNode* n2 = node->inputs[1];
-        if (n1->gate == "NOT" && n2->gate == "NOT" &&
+        if (n1->gate == GateType::NOT && n2->gate == GateType::NOT &&
             n1->inputs.size() == 1 && n2->inputs.size() == 1) {
             int x = computeMinCost(n1->inputs[0], dp); // t1
             int y = computeMinCost(n2->inputs[0], dp); // t2
-            minCost = min(minCost, x + y + 4); // OR2 matched from tech library
+            minCost = min(minCost, x + y + OR2_COST); // OR2 matched from tech library
         }
     }
 
     // Try matching AOI21 = NOT(NAND(NAND(x, y), z))
-    if (node->gate == "NOT" && node->inputs.size() == 1) {
+    if (node->gate == GateType::NOT && node->inputs.size() == 1) {
         TreeNode* nand1 = node->inputs[0];
-        if (nand1->gate == "NAND" && nand1->inputs.size() == 2) {
+        if (nand1->gate == GateType::NAND2 && nand1->inputs.size() == 2) {
             TreeNode* n1 = nand1->inputs[0];
             TreeNode* n2 = nand1->inputs[1];
-            if (n1->gate == "NAND" && n1->inputs.size() == 2) {
+            if (n1->gate == GateType::NAND2 && n1->inputs.size() == 2) {
                 int a = computeMinCost(n1->inputs[0], dp);
                 int b = computeMinCost(n1->inputs[1], dp);
                 int c = computeMinCost(n2, dp);
-                minCost = min(minCost, a + b + c + 7); // AOI21
+                minCost = min(minCost, a + b + c + AOI21_COST); // AOI21
             }
         }
     }
 
     // Try matching AOI22 = NOT(NAND(NAND(x, y), NAND(z, w)))
-    if (node->gate == "NOT" && node->inputs.size() == 1) {
+    if (node->gate == GateType::NOT && node->inputs.size() == 1) {
         TreeNode* nandTop = node->inputs[0];
-        if (nandTop->gate == "NAND" && nandTop->inputs.size() == 2) {
+        if (nandTop->gate == GateType::NAND2 && nandTop->inputs.size() == 2) {
             TreeNode* n1 = nandTop->inputs[0];
             TreeNode* n2 = nandTop->inputs[1];
-            if (n1->gate == "NAND" && n1->inputs.size() == 2 &&
-                n2->gate == "NAND" && n2->inputs.size() == 2) {
+            if (n1->gate == GateType::NAND2 && n1->inputs.size() == 2 &&
+                n2->gate == GateType::NAND2 && n2->inputs.size() == 2) {
                 int a = computeMinCost(n1->inputs[0], dp);
                 int b = computeMinCost(n1->inputs[1], dp);
                 int c = computeMinCost(n2->inputs[0], dp);
                 int d = computeMinCost(n2->inputs[1], dp);
-                minCost = min(minCost, a + b + c + d + 7); // AOI22
+                minCost = min(minCost, a + b + c + d + AOI22_COST); // AOI22
             }
         }
     }
@@ -254,10 +248,12 @@ int computeMinCost(TreeNode* node, unordered_map<TreeNode*, int>& dp) {
     return minCost;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    string inputFile = argc > 1 ? argv[1] : "input2.txt";
+    string outputFile = argc > 2 ? argv[2] : "output.txt";
     unordered_map<string, Node> circuit;
     string outputNode;
-    readNetlist("input2.txt", circuit, outputNode);
+    readNetlist(inputFile, circuit, outputNode);
 
     unordered_map<string, TreeNode*> memo;
     TreeNode* root = buildNandNotTree(outputNode, circuit, memo);
@@ -265,7 +261,7 @@ int main() {
     unordered_map<TreeNode*, int> dp;
     int totalCost = computeMinCost(root, dp);
 
-    ofstream out("output.txt");
+    ofstream out(outputFile);
     out << totalCost << endl;
     out.close();
 
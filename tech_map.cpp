@@ -0,0 +1,369 @@
+// tech_map.cpp
+// Technology mapper built on the shared netlist / subject graph / mapper
+// headers. Reads a netlist, maps it onto the technology table and writes the
+// minimal cost to the output file. A gzip, BGZF or (built with
+// -DTECH_MAP_ZSTD -lzstd) zstd compressed input is decompressed while it is
+// read; link with -lz. Binary AIGER files (aiger.h) are read as well.
+//
+// Usage: tech_map [input.txt] [output.txt] [--cover] [--exact] [--choices]
+//                 [--output NAME]... [--lazy] [--simplify] [--cache FILE]
+//                 [--npn] [--npn-db FILE] [--fraig] [--timing FILE]
+//                 [--pareto] [--max-delay D] [--pipeline]
+//        tech_map [input.txt] [output.txt] --engine NAME [--bin DIR]
+//        tech_map --engines [--bin DIR]
+//   --exact    search small cones exactly instead of trusting the tree DP
+//   --choices  also try re-associated AND/OR trees and report what they saved
+//   --output   map only this signal's cone (repeatable; default: OUTPUT lines)
+//   --lazy     parse only the lines inside the mapped cones
+//   --simplify fold constants, repeated/complementary inputs and inverter
+//              pairs first; also maps the netlist as is to report the time saved
+//   --cache    reuse the covers of unchanged cones from FILE across runs
+//   --fraig    merge signals proven equivalent by simulation first; also
+//              maps the netlist without the merge to report the time saved
+//   --npn      also price every 4-input cut by its cheapest formula from the
+//              NPN database (--npn-db, default npn4.db; rebuilt when missing
+//              or made for another library)
+//   --timing   run static timing analysis on the cover and write arrival,
+//              required time and slack of every cell to FILE
+//   --pareto   keep (area, delay) trade-offs per node and print the
+//              output-level front of area against delay
+//   --max-delay  map at the front's cheapest point with delay <= D
+//   --pipeline read the file on a second thread and, if it is in
+//              topological order, build the subject graph while reading
+//   --engine   map with another engine from engine.h (stand-alone programs
+//              are run from DIR, default .); --engines lists them
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "mapper.h"
+#include "exact_cover.h"
+#include "engine.h"
+#include "hierarchy.h"
+#include "result_cache.h"
+#include "timing.h"
+#include "pareto.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    string inputFile = "input.txt";
+    string outputFile = "output.txt";
+    bool printCover = false;
+    bool exact = false;
+    bool choices = false;
+    string engineName;
+    string binDir = ".";
+    vector<string> outputs;
+    bool lazy = false;
+    bool simplify = false;
+    string cacheFile;
+    bool fraig = false;
+    bool useNpn = false;
+    string npnFile = "npn4.db";
+    string timingFile;
+    bool pareto = false;
+    int maxDelay = -1;
+    bool pipelined = false;
+    bool listEngines = false;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--cover") {
+            printCover = true;
+        } else if (arg == "--exact") {
+            exact = true;
+        } else if (arg == "--choices") {
+            choices = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputs.push_back(argv[++i]);
+        } else if (arg == "--lazy") {
+            lazy = true;
+        } else if (arg == "--simplify") {
+            simplify = true;
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheFile = argv[++i];
+        } else if (arg == "--fraig") {
+            fraig = true;
+        } else if (arg == "--npn") {
+            useNpn = true;
+        } else if (arg == "--npn-db" && i + 1 < argc) {
+            npnFile = argv[++i];
+        } else if (arg == "--timing" && i + 1 < argc) {
+            timingFile = argv[++i];
+        } else if (arg == "--pareto") {
+            pareto = true;
+        } else if (arg == "--max-delay" && i + 1 < argc) {
+            maxDelay = atoi(argv[++i]);
+            pareto = true;
+        } else if (arg == "--pipeline") {
+            pipelined = true;
+        } else if (arg == "--engine" && i + 1 < argc) {
+            engineName = argv[++i];
+        } else if (arg == "--bin" && i + 1 < argc) {
+            binDir = argv[++i];
+        } else if (arg == "--engines") {
+            listEngines = true;
+        } else if (positional == 0) {
+            inputFile = arg;
+            positional++;
+        } else {
+            outputFile = arg;
+        }
+    }
+
+    // after every option, so that a later --bin applies
+    if (listEngines) {
+        for (const auto &e : makeEngines(binDir))
+            cout << e->name() << ": " << e->description() << endl;
+        return 0;
+    }
+    if (!engineName.empty()) {
+        auto engines = makeEngines(binDir);
+        MapperEngine *engine = findEngine(engines, engineName);
+        if (!engine) {
+            cerr << "Unknown engine '" << engineName << "' (see --engines)" << endl;
+            return 1;
+        }
+        EngineResult r = engine->run(inputFile);
+        if (r.cost < 0) {
+            cerr << "Engine " << engineName << " failed: " << r.error << endl;
+            return 1;
+        }
+        ofstream out(outputFile);
+        out << r.cost << endl;
+        cout << "Minimal cost: " << r.cost << endl;
+        return 0;
+    }
+
+    NpnDatabase npn;
+    if (useNpn) {
+        // cut formulas are neither cells the exact search knows nor what
+        // the cache stores
+        if (exact || !cacheFile.empty()) {
+            cerr << "--npn cannot be combined with --exact or --cache" << endl;
+            return 1;
+        }
+        auto t = chrono::steady_clock::now();
+        npn.load(npnFile);
+        if (npn.regenerated)
+            cout << "NPN: rebuilt " << npnFile << " (" << npn.classes.size() << " classes) in "
+                 << chrono::duration<double, milli>(chrono::steady_clock::now() - t).count() << " ms" << endl;
+    }
+
+    // the trade-off labels only know single cells of the tree DP
+    if (pareto && (exact || choices || useNpn || !cacheFile.empty())) {
+        cerr << "--pareto cannot be combined with --exact, --choices, --npn or --cache" << endl;
+        return 1;
+    }
+
+    bool aiger = isAigerFile(inputFile);
+    if (!aiger && detectInputFormat(inputFile) == InputFormat::PLAIN && isHierarchical(inputFile)) {
+        // modules are mapped whole, per boundary condition
+        if (lazy || !outputs.empty() || !timingFile.empty() || pareto || pipelined) {
+            cerr << "--lazy, --output, --timing, --pareto and --pipeline do not apply to hierarchical netlists"
+                 << endl;
+            return 1;
+        }
+        HierarchicalMapper hm;
+        hm.choices = choices;
+        hm.simplify = simplify;
+        hm.fraig = fraig;
+        hm.exact = exact;
+        if (useNpn) hm.npn = &npn;
+        if (!hm.readDesign(inputFile)) {
+            cerr << "Failed to read or parse netlist!" << endl;
+            return 1;
+        }
+        int cost = hm.calculateMinimalCost();
+        if (cost < 0) {
+            cerr << "Error: Could not calculate valid cost!" << endl;
+            return 1;
+        }
+        ofstream out(outputFile);
+        out << cost << endl;
+        out.close();
+
+        const ModuleMapping &top = hm.topMapping();
+        int uniqueGates = 0;
+        for (const auto &m : hm.mapped) uniqueGates += m.second.gates;
+        cout << "Minimal cost: " << cost << endl;
+        cout << "Hierarchy: " << hm.stats.modules << " modules, " << top.flatInstances << " instances, "
+             << hm.stats.mapped - 1 << " mapped (" << hm.stats.reused << " reuses), "
+             << uniqueGates << " gates mapped of " << top.flatGates << " flattened" << endl;
+        if (printCover) hm.writeCover(cout);
+        return 0;
+    }
+
+    // --lazy has its own reader, which already skips most of the file
+    if (pipelined && lazy) {
+        cerr << "--pipeline cannot be combined with --lazy" << endl;
+        return 1;
+    }
+    // the AIGER reader builds the graph as it reads anyway
+    if (pipelined && aiger) {
+        cerr << "--pipeline reads text netlists only; AIGER input is read in one pass already" << endl;
+        return 1;
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    TechnologyMapper tm;
+    tm.choices = choices;
+    tm.lazyParse = lazy;
+    tm.requestedOutputs = outputs;
+    tm.simplify = simplify;
+    tm.fraig = fraig;
+    tm.pipelined = pipelined;
+    if (useNpn) tm.npn = &npn;
+    if (!tm.readNetlist(inputFile)) {
+        cerr << "Failed to read or parse netlist!" << endl;
+        return 1;
+    }
+    ResultCache cache;
+    CacheStats cacheStats;
+    if (!cacheFile.empty() && !cache.open(cacheFile)) return 1;
+    int cost = cacheFile.empty() ? tm.calculateMinimalCost() : calculateCachedCost(tm, cache, exact, &cacheStats);
+    if (cost < 0) {
+        cerr << "Error: Could not calculate valid cost!" << endl;
+        return 1;
+    }
+    ExactStats exactStats;
+    if (exact && cacheFile.empty()) cost = calculateExactCost(tm, &exactStats);
+    ParetoMapper pm;
+    vector<ParetoPoint> front;
+    int dpCost = cost, dpDelay = 0;
+    double paretoMs = 0;
+    if (pareto) {
+        StaticTiming sta;
+        sta.build(tm);
+        dpDelay = sta.analyze();
+        auto t1 = chrono::steady_clock::now();
+        pm.build(tm);
+        front = pm.front(tm);
+        // the tree DP's cover is a point too, and usually the smallest
+        front.push_back(ParetoPoint{dpDelay, dpCost, -1});
+        paretoFilter(front);
+        if (maxDelay >= 0) {
+            // the cheapest point that meets the bound, or the fastest one
+            int at = (int)front.size() - 1;
+            while (at > 0 && front[at].delay > maxDelay) at--;
+            if (front[at].bound >= 0) cost = pm.pick(tm, front[at].bound);
+        }
+        paretoMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t1).count();
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    if (exact && cacheFile.empty())
+        cout << "Exact mode: " << exactStats.solved << " of " << exactStats.cones << " cones searched, "
+             << exactStats.improved << " improved, saved " << exactStats.saved << endl;
+
+    ofstream out(outputFile);
+    out << cost << endl;
+    out.close();
+
+    cout << "Minimal cost: " << cost << endl;
+    if (aiger) {
+        const AigerStats &st = tm.aigerStats;
+        cout << "AIGER: " << st.inputs << " inputs, " << st.latches << " latches, " << st.outputs << " outputs, "
+             << st.ands << " ANDs, " << st.symbols << " names" << endl;
+    }
+    if (lazy || !outputs.empty())
+        cout << "Cone: " << tm.coneStats.kept << " of " << tm.coneStats.signals << " signals" << endl;
+    if (pipelined) {
+        const PipelineStats &st = tm.pipelineStats;
+        cout << "Pipeline: " << st.lines << " lines in " << st.blocks << " blocks, reader stalled " << st.readerStalls
+             << " times, builder " << st.builderStalls << " times; ";
+        if (st.streamed)
+            cout << "graph built while reading" << endl;
+        else if (st.stopLine > 0)
+            cout << "line " << st.stopLine << " reads a signal defined later, graph built after reading" << endl;
+        else
+            cout << "graph built after reading" << endl;
+    }
+    if (!cacheFile.empty())
+        cout << "Cache: " << cacheStats.hits << " of " << cacheStats.cones << " cones hit ("
+             << (cacheStats.cones ? 100 * cacheStats.hits / cacheStats.cones : 0) << "%), saved ~"
+             << cacheStats.savedMs << " ms, mapped the rest in " << cacheStats.mappedMs << " ms, "
+             << cache.evicted << " evicted" << endl;
+    // The same run with --simplify or --fraig as given here and every other
+    // option unchanged, for the reports only. Compared with the DP cost,
+    // before any --max-delay pick.
+    auto mapWithout = [&](bool withSimplify, bool withFraig, double &rawMs) {
+        auto t1 = chrono::steady_clock::now();
+        TechnologyMapper raw;
+        raw.choices = choices;
+        raw.lazyParse = lazy;
+        raw.requestedOutputs = outputs;
+        raw.simplify = withSimplify;
+        raw.fraig = withFraig;
+        raw.pipelined = pipelined;
+        if (useNpn) raw.npn = &npn;
+        int rawCost = -1;
+        if (raw.readNetlist(inputFile)) rawCost = raw.calculateMinimalCost();
+        if (rawCost >= 0 && exact) rawCost = calculateExactCost(raw);
+        rawMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t1).count();
+        return rawCost;
+    };
+    if (simplify) {
+        double rawMs = 0;
+        int rawCost = mapWithout(false, fraig, rawMs);
+        const SimplifyStats &st = tm.simplifyStats;
+        cout << "Simplify: removed " << st.gatesBefore - st.gatesAfter << " of " << st.gatesBefore
+             << " gates (" << st.constants << " constant, " << st.idempotent << " idempotent, "
+             << st.complementary << " complementary, " << st.inverters << " inverter pairs)" << endl;
+        cout << "Simplify: mapped in " << ms << " ms, " << rawMs << " ms without (cost "
+             << rawCost << ", saved " << rawCost - dpCost << ")" << endl;
+    }
+    if (fraig) {
+        double rawMs = 0;
+        int rawCost = mapWithout(simplify, false, rawMs);
+        const FraigStats &st = tm.fraigStats;
+        cout << "FRAIG: merged " << st.merged << " signals (" << st.complemented << " inverted, " << st.constants
+             << " constant), " << st.gatesBefore << " -> " << st.gatesAfter << " gates, " << st.disproved
+             << " candidates disproved, " << st.unproven << " too wide to check" << endl;
+        cout << "FRAIG: mapped in " << ms << " ms, " << rawMs << " ms without (cost " << rawCost << ", saved "
+             << rawCost - dpCost << ")" << endl;
+    }
+    if (useNpn) {
+        int cuts = 0, cutCost = 0;
+        for (int id : tm.cover) {
+            if (tm.best[id].cell != GateType::UNKNOWN) continue;
+            cuts++;
+            cutCost += tm.matchCost(id);
+        }
+        cout << "NPN: " << cuts << " of " << tm.cover.size() << " cover nodes are cut formulas (cost "
+             << cutCost << ")" << endl;
+    }
+    if (pareto) {
+        size_t points = 0;
+        for (int i = 0; i < tm.graph.size(); i++) points += pm.count[i];
+        cout << "Pareto: " << points << " labels (" << pm.bytes() / 1024 << " KB), front in " << paretoMs
+             << " ms; area-optimal cover: area " << dpCost << ", delay " << dpDelay << endl;
+        cout << "Pareto front (delay area):";
+        for (const ParetoPoint &p : front) cout << " " << p.delay << ":" << p.area;
+        cout << endl;
+        if (maxDelay >= 0) {
+            StaticTiming sta;
+            sta.build(tm);
+            cout << "Pareto: picked area " << cost << ", delay " << sta.analyze() << " for --max-delay " << maxDelay
+                 << endl;
+        }
+    }
+    if (!timingFile.empty()) {
+        auto t1 = chrono::steady_clock::now();
+        StaticTiming sta;
+        sta.build(tm);
+        auto t2 = chrono::steady_clock::now();
+        int delay = sta.analyze();
+        auto t3 = chrono::steady_clock::now();
+        ofstream rep(timingFile);
+        sta.writeReport(rep);
+        cout << "Timing: delay " << delay << ", critical path of " << sta.criticalPath().size() - 1 << " cells ("
+             << sta.size() << " nodes, built in " << chrono::duration<double, milli>(t2 - t1).count()
+             << " ms, analyzed in " << chrono::duration<double, milli>(t3 - t2).count() << " ms)" << endl;
+    }
+    if (choices) tm.writeChoiceReport(cout);
+    if (printCover) tm.writeCover(cout);
+    return 0;
+}
@@ -0,0 +1,204 @@
+// tech_map_api.cpp
+// The C interface of tech_map_api.h, built as libtechmap.so. Every handle
+// owns one TechnologyMapper and clears it between netlists instead of
+// building a new one, so the graph and label arrays keep their storage.
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "tech_map_api.h"
+#include "mapper.h"
+#include "exact_cover.h"
+
+using namespace std;
+
+struct tm_mapper {
+    TechnologyMapper tm;
+    bool exact = false;
+    int cost = -1;
+    int signals = 0;                 // signals of the netlist as given; subject nodes follow
+    vector<int> original;            // tm.netlist id -> signal as given (-1: none), when rebuilt
+    unordered_map<string, int> byName;
+    vector<const string *> givenNames;   // names as given, when rebuilt
+    vector<tm_cell> cells;           // cover of the last tm_map()
+    vector<int> outputSignals;
+    string error;
+    string name;                     // tm_signal_name's buffer
+};
+
+// tm_gate_type -> GateType, by value
+static const GateType API_TYPES[] = {GateType::INPUT, GateType::CONST0, GateType::CONST1, GateType::OUTPUT,
+                                     GateType::NOT,   GateType::AND,    GateType::OR,     GateType::NAND2,
+                                     GateType::NOR2,  GateType::AOI21,  GateType::AOI22};
+static const int API_TYPE_COUNT = sizeof(API_TYPES) / sizeof(API_TYPES[0]);
+
+static tm_gate_type apiType(GateType t) {
+    for (int k = 0; k < API_TYPE_COUNT; k++)
+        if (API_TYPES[k] == t) return (tm_gate_type)k;
+    return TM_BUF;
+}
+
+static int fail(tm_mapper *m, const string &msg) {
+    m->error = msg;
+    return -1;
+}
+
+// Starts a new netlist on m, keeping the storage of the last one
+static void reset(tm_mapper *m) {
+    m->tm.clear();
+    m->cost = -1;
+    m->signals = 0;
+    m->original.clear();
+    m->byName.clear();
+    m->givenNames.clear();
+    m->cells.clear();
+    m->outputSignals.clear();
+    m->error.clear();
+}
+
+// Signal of the class of subject node id, as the caller numbers signals
+static int signalOf(const tm_mapper *m, int id) {
+    const SubjectGraph &g = m->tm.graph;
+    int r = g.repr[id];
+    int s = g.source[r];
+    if (s >= 0 && !m->original.empty()) s = m->original[s];
+    return s >= 0 ? s : m->signals + r;
+}
+
+extern "C" {
+
+int tm_api_version(void) { return TM_API_VERSION; }
+
+tm_mapper *tm_create(void) { return new tm_mapper(); }
+
+void tm_destroy(tm_mapper *m) { delete m; }
+
+int tm_set_option(tm_mapper *m, tm_option opt, int value) {
+    switch (opt) {
+        case TM_OPT_CHOICES: m->tm.choices = value != 0; break;
+        case TM_OPT_SIMPLIFY: m->tm.simplify = value != 0; break;
+        case TM_OPT_FRAIG: m->tm.fraig = value != 0; break;
+        case TM_OPT_EXACT: m->exact = value != 0; break;
+        case TM_OPT_PIPELINE: m->tm.pipelined = value != 0; break;
+        default: return fail(m, "unknown option " + to_string((int)opt));
+    }
+    return 0;
+}
+
+int tm_load_netlist(tm_mapper *m, const char *path) {
+    reset(m);
+    if (!path) return fail(m, "no path");
+    if (!m->tm.readNetlist(path)) return fail(m, string("cannot read or map ") + path + " (details on stderr)");
+    m->signals = m->tm.netlist.size();
+    return 0;
+}
+
+int tm_set_netlist(tm_mapper *m, int num_signals, const tm_gate_type *types, const int *fanin_start,
+                   const int *fanins, const char *const *names, int num_outputs, const int *outputs) {
+    reset(m);
+    if (num_signals <= 0 || !types || !fanin_start || num_outputs <= 0 || !outputs)
+        return fail(m, "empty netlist");
+    if (fanin_start[0] != 0 || (fanin_start[num_signals] > 0 && !fanins)) return fail(m, "bad fan-in list");
+    Netlist &nl = m->tm.netlist;
+    nl.gates.resize(num_signals);
+    nl.names.resize(num_signals);
+    for (int i = 0; i < num_signals; i++) {
+        if ((int)types[i] < 0 || (int)types[i] >= API_TYPE_COUNT)
+            return fail(m, "signal " + to_string(i) + " has an unknown type");
+        if (fanin_start[i + 1] < fanin_start[i]) return fail(m, "bad fan-in list");
+        Gate &g = nl.gates[i];
+        g.type = API_TYPES[types[i]];
+        g.inputs.assign(fanins + fanin_start[i], fanins + fanin_start[i + 1]);
+        for (int in : g.inputs)
+            if (in < 0 || in >= num_signals) return fail(m, "signal " + to_string(i) + " reads an unknown signal");
+        if (!validArity(g)) return fail(m, "signal " + to_string(i) + " has the wrong number of fan-ins");
+        // simplify and fraig rebuild the netlist by name, so names must be distinct
+        if (names && names[i]) {
+            nl.names[i] = names[i];
+        } else {
+            nl.names[i] = "s" + to_string(i);
+        }
+    }
+    for (int k = 0; k < num_outputs; k++) {
+        if (outputs[k] < 0 || outputs[k] >= num_signals) return fail(m, "output " + to_string(k) + " is unknown");
+        nl.outputs.push_back(outputs[k]);
+    }
+    m->signals = num_signals;
+    bool rebuilt = m->tm.simplify || m->tm.fraig;
+    if (rebuilt) {
+        for (int i = 0; i < num_signals; i++) {
+            auto it = m->byName.emplace(nl.names[i], i);
+            if (!it.second) return fail(m, "signal names are not distinct");
+            m->givenNames.push_back(&it.first->first);
+        }
+    }
+    if (!m->tm.buildGraph()) return fail(m, "netlist has a loop or an undefined signal (details on stderr)");
+    if (rebuilt) {
+        // surviving signals keep their names
+        const Netlist &out = m->tm.netlist;
+        m->original.assign(out.size(), -1);
+        for (int id = 0; id < out.size(); id++) {
+            auto it = m->byName.find(out.names[id]);
+            if (it != m->byName.end()) m->original[id] = it->second;
+        }
+    }
+    return 0;
+}
+
+int tm_map(tm_mapper *m) {
+    m->cells.clear();
+    m->outputSignals.clear();
+    if (m->tm.graph.outputs.empty()) return fail(m, "no netlist");
+    TechnologyMapper &tm = m->tm;
+    int cost = tm.calculateMinimalCost();
+    if (cost >= 0 && m->exact) cost = calculateExactCost(tm);
+    m->cost = cost;
+    if (cost < 0) return fail(m, "no cover");
+    for (int id : tm.cover) {
+        const Match &mt = tm.best[id];
+        tm_cell c = {};
+        c.output = signalOf(m, id);
+        c.type = apiType(mt.cell);
+        c.num_leaves = mt.numLeaves;
+        for (int l = 0; l < mt.numLeaves; l++) c.leaves[l] = signalOf(m, mt.leaves[l]);
+        m->cells.push_back(c);
+    }
+    for (int o : tm.graph.outputs) m->outputSignals.push_back(signalOf(m, o));
+    m->error.clear();
+    return cost;
+}
+
+int tm_cost(const tm_mapper *m) { return m->cost; }
+
+int tm_cover_size(const tm_mapper *m) { return (int)m->cells.size(); }
+
+int tm_cover_cell(const tm_mapper *m, int k, tm_cell *cell) {
+    if (k < 0 || k >= (int)m->cells.size() || !cell) return -1;
+    *cell = m->cells[k];
+    return 0;
+}
+
+int tm_output_signal(const tm_mapper *m, int output) {
+    if (output < 0 || output >= (int)m->outputSignals.size()) return -1;
+    return m->outputSignals[output];
+}
+
+int tm_signal_count(const tm_mapper *m) { return m->signals + m->tm.graph.size(); }
+
+const char *tm_signal_name(tm_mapper *m, int signal) {
+    const TechnologyMapper &tm = m->tm;
+    if (signal < 0 || signal >= tm_signal_count(m)) return nullptr;
+    if (signal >= m->signals) {
+        m->name = tm.nodeName(signal - m->signals);
+    } else if (m->original.empty()) {
+        m->name = tm.netlist.names[signal];
+    } else {
+        m->name = *m->givenNames[signal];
+    }
+    return m->name.c_str();
+}
+
+const char *tm_last_error(const tm_mapper *m) { return m->error.c_str(); }
+
+}
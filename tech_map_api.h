@@ -0,0 +1,109 @@
+/* tech_map_api.h
+ * C interface to the shared-header mapper (mapper.h), for linking the mapper
+ * into another program instead of running tech_map and reading output.txt.
+ * Netlists come from a file or straight from arrays; after tm_map() the cost
+ * and every cell of the cover can be read back.
+ *
+ * A handle keeps its buffers between netlists, so one handle per thread that
+ * maps many netlists allocates little after the first. Handles are
+ * independent; one handle must not be used by two threads at once.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread -shared -fPIC -fvisibility=hidden
+ *            -o libtechmap.so tech_map_api.cpp -lz
+ *
+ *   tm_mapper *m = tm_create();
+ *   tm_set_netlist(m, 4, types, fanin_start, fanins, NULL, 1, outputs);
+ *   int cost = tm_map(m);
+ *   for (int k = 0; k < tm_cover_size(m); k++) { tm_cell c; tm_cover_cell(m, k, &c); ... }
+ *   tm_destroy(m);
+ */
+#ifndef TECH_MAP_API_H
+#define TECH_MAP_API_H
+
+#if defined(__GNUC__)
+#define TM_API __attribute__((visibility("default")))
+#else
+#define TM_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TM_API_VERSION 1
+
+/* Signal and cell types. The values are part of the interface and never change. */
+typedef enum {
+    TM_INPUT = 0,    /* primary input, no fan-ins */
+    TM_CONST0 = 1,   /* tie-offs, no fan-ins */
+    TM_CONST1 = 2,
+    TM_BUF = 3,      /* 1 fan-in; "F = t5" in the text format */
+    TM_NOT = 4,
+    TM_AND = 5,      /* AND/OR take any number of fan-ins (at least 1) */
+    TM_OR = 6,
+    TM_NAND2 = 7,
+    TM_NOR2 = 8,
+    TM_AOI21 = 9,    /* NOT((a AND b) OR c) */
+    TM_AOI22 = 10    /* NOT((a AND b) OR (c AND d)) */
+} tm_gate_type;
+
+typedef enum {
+    TM_OPT_CHOICES = 0,    /* also try re-associated AND/OR trees */
+    TM_OPT_SIMPLIFY = 1,   /* fold constants and trivial logic first */
+    TM_OPT_FRAIG = 2,      /* merge signals proven equivalent first */
+    TM_OPT_EXACT = 3,      /* search small cones exactly */
+    TM_OPT_PIPELINE = 4    /* tm_load_netlist: read on a second thread */
+} tm_option;
+
+/* One cell of the cover. Signals of the netlist keep their index; internal
+ * nodes of the subject graph get indices from tm_signal_count() up. */
+typedef struct {
+    int output;
+    tm_gate_type type;
+    int num_leaves;
+    int leaves[4];
+} tm_cell;
+
+typedef struct tm_mapper tm_mapper;
+
+TM_API int tm_api_version(void);
+
+TM_API tm_mapper *tm_create(void);
+TM_API void tm_destroy(tm_mapper *m);
+
+/* Options apply to the next netlist. Returns 0, or -1 for an unknown option. */
+TM_API int tm_set_option(tm_mapper *m, tm_option opt, int value);
+
+/* Reads a netlist file in the "t1 = AND b c" format or binary AIGER (gzip
+ * and BGZF too). Returns 0, or -1 with tm_last_error() set. */
+TM_API int tm_load_netlist(tm_mapper *m, const char *path);
+
+/* Takes a netlist of num_signals signals. Signal i has type types[i] and
+ * reads fanins[fanin_start[i]] .. fanins[fanin_start[i + 1] - 1], so
+ * fanin_start has num_signals + 1 entries. names may be NULL (signals are
+ * then named "s<i>"). outputs lists the signals to map. Returns 0, or -1
+ * with tm_last_error() set. */
+TM_API int tm_set_netlist(tm_mapper *m, int num_signals, const tm_gate_type *types, const int *fanin_start,
+                          const int *fanins, const char *const *names, int num_outputs, const int *outputs);
+
+/* Maps the current netlist and returns the total cell area, or -1 */
+TM_API int tm_map(tm_mapper *m);
+
+/* Results of the last tm_map() */
+TM_API int tm_cost(const tm_mapper *m);
+TM_API int tm_cover_size(const tm_mapper *m);
+TM_API int tm_cover_cell(const tm_mapper *m, int k, tm_cell *cell);   /* 0, or -1 out of range */
+TM_API int tm_output_signal(const tm_mapper *m, int output);         /* signal driving an output */
+
+TM_API int tm_signal_count(const tm_mapper *m);
+/* Name of a signal (netlist or internal); valid until the next call on m */
+TM_API const char *tm_signal_name(tm_mapper *m, int signal);
+
+/* Why the last call failed ("" if it didn't) */
+TM_API const char *tm_last_error(const tm_mapper *m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,9 +3,10 @@
 #include <sstream>
 #include <unordered_map>
 #include <vector>
+#include "cell_library.h"
+
 using namespace std;
 
-enum GateType { INPUT, OUTPUT, AND, OR, NOT, UNKNOWN };
 
 // Structure to hold basic gate info from netlist
 struct Node {
@@ -16,18 +17,10 @@ struct Node {
 // Structure to build NAND-NOT tree
 struct TreeNode {
     string name;
-    string gate;                   // "NAND", "NOT", or "INPUT"
+    GateType gate;                 // NAND2, NOT, or INPUT
     vector<TreeNode*> inputs;     // children of this gate
 };
 
-// Converts gate string to enum
-GateType getGateType(const string& s) {
-    if (s == "AND") return AND;
-    if (s == "OR") return OR;
-    if (s == "NOT") return NOT;
-    return UNKNOWN;
-}
-
 // Parses the input netlist into a circuit map
 void readNetlist(const string& filename, unordered_map<string, Node>& circuit, string& outputName) {
     ifstream file(filename);
@@ -42,14 +35,14 @@ void readNetlist(const string& filename, unordered_map<string, Node>& circuit, s
         ss >> typeOrEqual;
 
         if (typeOrEqual == "INPUT") {
-            circuit[name] = {INPUT, {}};
+            circuit[name] = {GateType::INPUT, {}};
         } else if (typeOrEqual == "OUTPUT") {
             outputName = name;
         } else if (typeOrEqual == "=") {
             string gateTypeStr;
             ss >> gateTypeStr;
 
-            GateType gateType = getGateType(gateTypeStr);
+            GateType gateType = parseGateType(gateTypeStr);
             vector<string> inputs;
             string inputName;
             while (ss >> inputName) {
@@ -69,8 +62,8 @@ TreeNode* buildNandNotTree(string nodeName, unordered_map<string, Node>& circuit
 
     Node node = circuit[nodeName];
 
-    if (node.type == INPUT) {
-        TreeNode* inputNode = new TreeNode{nodeName, "INPUT", {}};
+    if (node.type == GateType::INPUT) {
+        TreeNode* inputNode = new TreeNode{nodeName, GateType::INPUT, {}};
         memo[nodeName] = inputNode;
         return inputNode;
     }
@@ -82,15 +75,15 @@ TreeNode* buildNandNotTree(string nodeName, unordered_map<string, Node>& circuit
 
     TreeNode* result = nullptr;
 
-    if (node.type == AND) {
-        TreeNode* nandGate = new TreeNode{"", "NAND", inputs};
-        result = new TreeNode{"", "NOT", {nandGate}};
-    } else if (node.type == OR) {
-        TreeNode* not1 = new TreeNode{"", "NOT", {inputs[0]}};
-        TreeNode* not2 = new TreeNode{"", "NOT", {inputs[1]}};
-        result = new TreeNode{"", "NAND", {not1, not2}};
-    } else if (node.type == NOT) {
-        result = new TreeNode{"", "NOT", {inputs[0]}};
+    if (node.type == GateType::AND) {
+        TreeNode* nandGate = new TreeNode{"", GateType::NAND2, inputs};
+        result = new TreeNode{"", GateType::NOT, {nandGate}};
+    } else if (node.type == GateType::OR) {
+        TreeNode* not1 = new TreeNode{"", GateType::NOT, {inputs[0]}};
+        TreeNode* not2 = new TreeNode{"", GateType::NOT, {inputs[1]}};
+        result = new TreeNode{"", GateType::NAND2, {not1, not2}};
+    } else if (node.type == GateType::NOT) {
+        result = new TreeNode{"", GateType::NOT, {inputs[0]}};
     }
 
     memo[nodeName] = result;
@@ -107,8 +100,7 @@ int computeCost(TreeNode* node, unordered_map<TreeNode*, int>& memo) {
         cost += computeCost(child, memo);
     }
 
-    if (node->gate == "NAND") cost += 3;
-    else if (node->gate == "NOT") cost += 2;
+    cost += cellCost(node->gate);
 
     memo[node] = cost;
     return cost;
@@ -118,7 +110,7 @@ int computeCost(TreeNode* node, unordered_map<TreeNode*, int>& memo) {
 void printTree(TreeNode* node, int indent = 0) {
     if (!node) return;
     for (int i = 0; i < indent; i++) cout << "  ";
-    cout << node->gate;
+    cout << gateTypeName(node->gate);
     if (!node->name.empty()) cout << " (" << node->name << ")";
     cout << endl;
 
@@ -127,11 +119,13 @@ void printTree(TreeNode* node, int indent = 0) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    string inputFile = argc > 1 ? argv[1] : "input2.txt";
+    string outputFile = argc > 2 ? argv[2] : "output.txt";
     unordered_map<string, Node> circuit;
     string outputNode;
 
-    readNetlist("input2.txt", circuit, outputNode);
+    readNetlist(inputFile, circuit, outputNode);
 
     // Step 1: Convert to NAND-NOT tree
     unordered_map<string, TreeNode*> treeMemo;
@@ -142,7 +136,7 @@ int main() {
     int cost = computeCost(root, costMemo);
 
     // Step 3: Output result
-    ofstream out("output.txt");
+    ofstream out(outputFile);
     out << cost << endl;
     out.close();
 
@@ -0,0 +1,163 @@
+// timing.h
+// Static timing analysis of a mapped cover. Each cell of the cover becomes
+// one timing node and each of its leaves one edge carrying the cell's pin
+// delay from cell_library.h (for an --npn cut, the longest path through its
+// formula). Everything is kept in flat arrays in topological order, so after
+// changing delays a new analysis is two linear sweeps.
+//
+//   StaticTiming sta;
+//   sta.build(tm);                     // after tm.calculateMinimalCost()
+//   int delay = sta.analyze();         // required time = the critical delay
+//   std::vector<int> path = sta.criticalPath();
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "mapper.h"
+
+class StaticTiming {
+public:
+    // Timing nodes: the inputs the cover reads, then its cells, fan-ins first
+    std::vector<int> node;        // timing node -> subject node
+    std::vector<int> faninEnd;    // timing node -> end of its edges in fanin
+    std::vector<int> fanin;       // edge -> timing node it reads
+    std::vector<int> edgeDelay;   // edge -> delay from that fan-in to the cell output
+    std::vector<int> outputs;     // timing node of each output, as in graph.outputs
+
+    std::vector<int> arrival;
+    std::vector<int> required;
+    std::vector<int> slack;
+
+    // Records the cover of tm's last mapping
+    void build(const TechnologyMapper &tm) {
+        const SubjectGraph &g = tm.graph;
+        std::vector<int> cells = tm.cover;
+        // mapNodes labels in id order and a leaf's class is settled before
+        // it is read, so id order is a topological order of the cover
+        std::sort(cells.begin(), cells.end());
+        std::vector<int> index(g.size(), -1);   // subject node -> timing node
+        node.clear();
+        auto addInput = [&](int id) {
+            if (g.nodes[id].type != GateType::INPUT || index[id] >= 0) return;
+            index[id] = (int)node.size();
+            node.push_back(id);
+        };
+        for (int id : cells) {
+            const Match &m = tm.best[id];
+            for (int l = 0; l < m.numLeaves; l++) addInput(tm.impl(m.leaves[l]));
+        }
+        for (int o : g.outputs) addInput(tm.impl(o));
+        for (int id : cells) {
+            index[id] = (int)node.size();
+            node.push_back(id);
+        }
+        faninEnd.assign(node.size(), 0);
+        fanin.clear();
+        edgeDelay.clear();
+        size_t first = node.size() - cells.size();
+        for (size_t k = first; k < node.size(); k++) {
+            int id = node[k];
+            const Match &m = tm.best[id];
+            for (int l = 0; l < m.numLeaves; l++) {
+                // a cut formula may not read every leaf (or be a constant)
+                int d = m.cell == GateType::UNKNOWN ? tm.npn->pinDelay(tm.cutFunc[id], l) : cellDelay(m.cell);
+                if (d < 0) continue;
+                fanin.push_back(index[tm.impl(m.leaves[l])]);
+                edgeDelay.push_back(d);
+            }
+            faninEnd[k] = (int)fanin.size();
+        }
+        outputs.clear();
+        for (int o : g.outputs) outputs.push_back(index[tm.impl(o)]);
+        names.clear();
+        types.clear();
+        for (int k = 0; k < (int)node.size(); k++) {
+            names.push_back(tm.nodeName(node[k]));
+            types.push_back(k < (int)first ? GateType::INPUT : tm.best[node[k]].cell);
+        }
+    }
+
+    int size() const { return (int)node.size(); }
+
+    // Sets the delay of every pin of timing node k (for a what-if on the
+    // cell library; call analyze() again afterwards)
+    void setDelay(int k, int delay) {
+        for (int e = k > 0 ? faninEnd[k - 1] : 0; e < faninEnd[k]; e++) edgeDelay[e] = delay;
+    }
+
+    // Arrival times forward from the inputs (at 0), required times back
+    // from the outputs (at requiredTime, or the critical delay when < 0),
+    // and slack = required - arrival. Returns the critical delay.
+    int analyze(int requiredTime = -1) {
+        int n = size();
+        arrival.assign(n, 0);
+        int e = 0;
+        for (int k = 0; k < n; k++) {
+            int a = 0;
+            for (; e < faninEnd[k]; e++) a = std::max(a, arrival[fanin[e]] + edgeDelay[e]);
+            arrival[k] = a;
+        }
+        delay = 0;
+        for (int o : outputs) delay = std::max(delay, arrival[o]);
+        target = requiredTime < 0 ? delay : requiredTime;
+        required.assign(n, INF);
+        for (int o : outputs) required[o] = target;
+        for (int k = n - 1; k >= 0; k--) {
+            for (int f = k > 0 ? faninEnd[k - 1] : 0; f < faninEnd[k]; f++)
+                required[fanin[f]] = std::min(required[fanin[f]], required[k] - edgeDelay[f]);
+        }
+        slack.resize(n);
+        for (int k = 0; k < n; k++) slack[k] = required[k] - arrival[k];
+        return delay;
+    }
+
+    // The timing nodes of the latest-arriving output's path, input first
+    std::vector<int> criticalPath() const {
+        std::vector<int> path;
+        int k = -1;
+        for (int o : outputs)
+            if (k < 0 || arrival[o] > arrival[k]) k = o;
+        while (k >= 0) {
+            path.push_back(k);
+            int next = -1;
+            for (int f = k > 0 ? faninEnd[k - 1] : 0; f < faninEnd[k] && next < 0; f++)
+                if (arrival[fanin[f]] + edgeDelay[f] == arrival[k]) next = fanin[f];
+            k = next;
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // Critical path, then every timing node with its arrival, required time
+    // and slack, worst slack first
+    void writeReport(std::ostream &out) const {
+        std::vector<int> path = criticalPath();
+        int worst = INF;
+        for (int s : slack) worst = std::min(worst, s);
+        out << "Delay: " << delay << ", required " << target << ", worst slack " << worst << "\n";
+        out << "Critical path (" << path.size() - (path.empty() ? 0 : 1) << " cells):\n";
+        for (int k : path) out << "  " << names[k] << " " << typeName(k) << " " << arrival[k] << "\n";
+        std::vector<int> order(size());
+        for (int k = 0; k < size(); k++) order[k] = k;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return slack[a] < slack[b]; });
+        out << "Nodes (name cell arrival required slack):\n";
+        for (int k : order)
+            out << "  " << names[k] << " " << typeName(k) << " " << arrival[k] << " "
+                << required[k] << " " << slack[k] << "\n";
+    }
+
+private:
+    static constexpr int INF = 1 << 29;   // required time of nodes no output reads
+    std::vector<std::string> names;
+    std::vector<GateType> types;      // cell of each timing node (UNKNOWN: a cut formula)
+    int delay = 0;
+    int target = 0;
+
+    const char *typeName(int k) const { return types[k] == GateType::UNKNOWN ? "CUT" : gateTypeName(types[k]); }
+};
+
+#endif